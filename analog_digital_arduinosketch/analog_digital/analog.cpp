@@ -6,7 +6,7 @@
  * six generator functions (sine, triangle, sawtooth, shark-fin, square,
  * or smooth noise). Waveforms are drawn as a moving window of pixels;
  * once the trailing edge passes the bottom of the screen the wave is
- * deactivated and its slot can be reused.
+ * retired and its slot can be reused.
  *
  * All waveform generators share the same interface: given a vertical pixel
  * position Y and a frequency parameter (radianOffset), they return the
@@ -17,11 +17,95 @@
  */
 
 #include "analog.h"
+#include "dither.h"
+#include "fastdraw.h"
+#include "governor.h"
+#include "indexed.h"
+#include "pool.h"
+#include "profiler.h"
+#include "scenerandom.h"
+#include "sinetable.h"
 #include <math.h>
+#include <stdlib.h>
 
 /** Lookup table so we can pick a random waveform by index. */
 Waveforms waveformArray[numWaveforms] = {SIN_WAVE, TRI_WAVE, SAW_WAVE, SHARK_WAVE, SQR_WAVE, NOISE_WAVE};
-Wave waves[numWaves];
+int numWaves = 0;
+
+/**
+ * WavePool
+ *
+ * Per-wave state, one array per field indexed by slot (see pool.h). Waves
+ * scroll top-to-bottom or bottom-to-top and retire once their trailing
+ * edge has left the screen.
+ *
+ * A wave's shape depends only on Y, its frequency and the screen width,
+ * so the generator output for every row is computed once at spawn and
+ * cached in the slot's x table. Drawing a frame is then a table read per
+ * row. Each table has screen height + 1 entries, so the snap-back check
+ * at the bottom edge can read row y + 1.
+ */
+struct WavePool {
+  int16_t *curY;        // Leading edge Y position (advances each frame)
+  int16_t *length;      // Visible length in pixels between leading and trailing edges
+  uint16_t *color;      // RGB565 color
+  uint8_t *colorIndex;  // Index into the palette (used to prevent duplicate colors on screen)
+  uint8_t *speed;       // Pixels the leading edge advances per frame
+  int8_t *direction;    // +1 = scrolls downward, -1 = scrolls upward
+  uint8_t *waveform;    // Which shape generator (Waveforms)
+  uint8_t *x;           // Precomputed X pixel position for each row, tableSize per slot
+  int tableSize;
+  ActiveList active;    // Waves on screen
+};
+
+static WavePool waves = {};
+static void *wavesBlock = NULL;
+
+/**
+ * Rows drawn last frame, one span per wave drawn (retired ones included),
+ * for clearAnalog() to erase.
+ */
+struct DirtySpan {
+  int16_t y;
+  int16_t rows;
+};
+static DirtySpan *dirtySpans = NULL;
+static int dirtyCount = 0;
+
+/** Set when the screen holds something other than our waves (see invalidateAnalog()). */
+static bool fullClearPending = false;
+
+#if ANALOG_INDEXED
+/** Palette-indexed copy of the scene; waves draw here, then it is expanded into the canvas. */
+static IndexedCanvas scene = {0, 0, NULL, NULL};
+/** RGB565 color of every scene byte (top palette slot, optionally glowing with the one below). */
+static uint16_t sceneColors[INDEXED_COLORS];
+/** Glow setting sceneColors[] was built with, kept for rebuilding it while dithering. */
+static bool sceneGlow = false;
+#endif
+
+/** Frames drawn since initAnalog(), the phase of the dither cycle (dither.h). */
+static uint8_t ditherPhase = 0;
+
+/**
+ * noiseHash()
+ *
+ * Deterministic hash for noise wave control points. Given a segment index
+ * and a frequency key (radianOffset * 100, truncated), returns a
+ * reproducible pseudo-random value. This lets the noise wave be redrawn
+ * identically each frame without storing state. Uses Knuth's
+ * multiplicative hash constants for good bit mixing.
+ */
+static uint32_t noiseHash(int segment, uint32_t offsetKey) {
+    uint32_t seed = (uint32_t)(segment + 1) * 2654435761UL;
+    seed ^= offsetKey * 2246822519UL;
+    seed ^= seed >> 16;
+    seed *= 0x45d9f3bUL;
+    seed ^= seed >> 16;
+    return seed;
+}
+
+#if !ANALOG_FIXED_POINT
 
 /* ------------------------------------------------------------------ */
 /*  Waveform generator functions                                      */
@@ -36,7 +120,7 @@ Wave waves[numWaves];
  * Classic sine wave. Maps Y into radians, takes sin(), and scales the
  * result from -1..1 back to 0..screenWidth.
  */
-static int sinWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int sinWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     float yMapped = ((float)y / (float)matrix.height()) * radianOffset;
     float sinY = sin(yMapped);
     int x = round(((sinY + 1)/2) * (float(matrix.width()) - 1));
@@ -49,7 +133,7 @@ static int sinWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
  * Triangle wave. Uses the identity asin(sin(x)) to convert the sine
  * curve into linear ramps, producing a zig-zag pattern.
  */
-static int triWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int triWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     float yMapped = ((float)y / (float)matrix.height()) * radianOffset;
     float sinY = sin(yMapped);
     float arcY = asin(sinY);           // Folds sine into linear ramps
@@ -64,7 +148,7 @@ static int triWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
  * Sawtooth wave. Produces a linear ramp from -1 to 1 that snaps back
  * at the end of each period.
  */
-static int sawWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int sawWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     float yMapped = ((float)y / (float)matrix.height()) * radianOffset;
     // Linear ramp -1 to 1 within each 2*PI period, then snaps back
     float sawY = 2.0 * (yMapped / (2.0 * PI) - floor(yMapped / (2.0 * PI) + 0.5));
@@ -79,7 +163,7 @@ static int sawWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
  * (18% of the period) followed by a slow, rounded cosine fall (82%).
  * Resembles a dorsal fin or a capacitor charge/discharge curve.
  */
-static int sharkWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int sharkWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     float yMapped = ((float)y / (float)matrix.height()) * radianOffset;
     float phase = fmod(yMapped, 2.0 * PI) / (2.0 * PI); // Normalize to 0..1 phase
     if (phase < 0) phase += 1.0;
@@ -101,30 +185,13 @@ static int sharkWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
  * Square wave. Outputs full-left or full-right based on the sign of
  * sin() at the current phase — producing sharp horizontal transitions.
  */
-static int sqrWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int sqrWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     float yMapped = ((float)y / (float)matrix.height()) * radianOffset;
     float sqrY = sin(yMapped) >= 0 ? 1.0 : -1.0;
     int x = round(((sqrY + 1) / 2) * (float(matrix.width()) - 1));
     return x;
 }
 
-/**
- * noiseHash()
- *
- * Deterministic hash for noise wave control points. Given a segment index
- * and radianOffset, returns a reproducible pseudo-random value. This lets
- * the noise wave be redrawn identically each frame without storing state.
- * Uses Knuth's multiplicative hash constants for good bit mixing.
- */
-static unsigned long noiseHash(int segment, float radianOffset) {
-    unsigned long seed = (unsigned long)(segment + 1) * 2654435761UL;
-    seed ^= (unsigned long)(radianOffset * 100) * 2246822519UL;
-    seed ^= seed >> 16;
-    seed *= 0x45d9f3bUL;
-    seed ^= seed >> 16;
-    return seed;
-}
-
 /**
  * noiseWave()
  *
@@ -132,7 +199,7 @@ static unsigned long noiseHash(int segment, float radianOffset) {
  * deterministic random X control point at each segment boundary, and
  * uses cosine interpolation between them for a smooth, organic look.
  */
-static int noiseWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
+static int noiseWave(int y, float radianOffset, GFXcanvas16 &matrix) {
     // Segment length in pixels, derived from the frequency parameter
     float period = (2.0 * PI * matrix.height()) / radianOffset;
     if (period < 2.0) period = 2.0;
@@ -142,17 +209,89 @@ static int noiseWave(int y, float radianOffset, Adafruit_Protomatter &matrix) {
     float smooth = (1.0 - cos(t * PI)) / 2.0;         // Cosine interpolation (ease in/out)
 
     // Deterministic random X at each segment boundary
-    int x0 = noiseHash(segment, radianOffset) % matrix.width();
-    int x1 = noiseHash(segment + 1, radianOffset) % matrix.width();
+    uint32_t offsetKey = (uint32_t)(radianOffset * 100);
+    int x0 = noiseHash(segment, offsetKey) % matrix.width();
+    int x1 = noiseHash(segment + 1, offsetKey) % matrix.width();
 
     int x = x0 + (int)(smooth * (float)(x1 - x0));
     return x;
 }
 
+#else  // ANALOG_FIXED_POINT
+
+/* ------------------------------------------------------------------ */
+/*  Fixed-point waveform generators                                   */
+/*  Integer equivalents of the float generators above. Each takes the */
+/*  row's phase as a Q15 turn count (32768 = one full period, upper    */
+/*  bits = whole periods elapsed) and returns a Q15 amplitude in      */
+/*  -32768..32768. fixedToX() maps that onto the screen width.        */
+/* ------------------------------------------------------------------ */
+
+/** Shark-fin rise/fall split: 18% of the period, in Q15 turns. */
+static const int32_t SHARK_RISE = 5898;
+
+/** Maps a Q15 amplitude (-1..1) to 0..width-1, rounding to nearest. */
+static int fixedToX(int32_t amp, int width) {
+    return ((amp + 32768) * (width - 1) + 32768) >> 16;
+}
+
+static int32_t sinFixed(uint32_t phase) {
+    return sinQ15(phase);
+}
+
+/** Triangle: linear ramps, equivalent to asin(sin(x)) * 2 / PI. */
+static int32_t triFixed(uint32_t phase) {
+    int32_t p = phase & (SINE_TURN - 1);
+    if (p < 8192) return p * 4;               // 0 -> +1
+    if (p < 24576) return 65536 - p * 4;      // +1 -> -1
+    return p * 4 - 131072;                    // -1 -> 0
+}
+
+/** Sawtooth: ramps -1..1 centred on each period boundary, then snaps back. */
+static int32_t sawFixed(uint32_t phase) {
+    int32_t p = phase & (SINE_TURN - 1);
+    return (p < 16384) ? p * 2 : p * 2 - 65536;
+}
+
+/** Shark-fin: fast linear rise, then a cosine fall over the rest of the period. */
+static int32_t sharkFixed(uint32_t phase) {
+    int32_t p = phase & (SINE_TURN - 1);
+    if (p < SHARK_RISE) {
+        return (p * 65536) / SHARK_RISE - 32768;
+    }
+    // Fall phase 0..1 in Q15, then cos(fall * PI) is a half turn of the table
+    int32_t fall = ((p - SHARK_RISE) * 32768) / (32768 - SHARK_RISE);
+    return cosQ15(fall / 2);
+}
+
+static int32_t sqrFixed(uint32_t phase) {
+    return ((phase & (SINE_TURN - 1)) < 16384) ? 32768 : -32768;
+}
+
+/**
+ * noiseFixed()
+ *
+ * Cosine-interpolated noise. The period of the noise segments equals one
+ * phase turn, so the segment index is the whole-turn part of the phase
+ * and t is the fraction within it.
+ */
+static int noiseFixed(uint32_t phase, uint32_t offsetKey, int width) {
+    int segment = phase >> 15;
+    int32_t t = phase & (SINE_TURN - 1);
+    int32_t smooth = (32768 - cosQ15(t / 2)) / 2;  // (1 - cos(t * PI)) / 2 in Q15
+
+    int x0 = noiseHash(segment, offsetKey) % width;
+    int x1 = noiseHash(segment + 1, offsetKey) % width;
+
+    return x0 + (smooth * (x1 - x0)) / 32768;
+}
+
+#endif  // ANALOG_FIXED_POINT
+
 /**
  * Curated palette of 12 soft, bright colors that are visually distinct from
  * each other on an LED matrix. Stored as RGB triplets and converted to
- * RGB565 at init time via matrix.color565().
+ * RGB565 at init time via Adafruit_Protomatter::color565().
  */
 static const uint8_t PALETTE_SIZE = 12;
 static const uint8_t palette[PALETTE_SIZE][3] = {
@@ -170,6 +309,52 @@ static const uint8_t palette[PALETTE_SIZE][3] = {
   {180, 160,   0},  // Olive yellow
 };
 
+/**
+ * paletteColor()
+ *
+ * RGB565 for a palette color (or a glow mix of two): through the dither
+ * stage for this frame when the analog scene has it on, else plain
+ * color565().
+ *
+ * @param offset  Added to the phase so separate colors step on different frames
+ */
+static uint16_t paletteColor(int r, int g, int b, uint8_t offset) {
+  if (ditherEnabled(DITHER_ANALOG)) return ditherColor565(r, g, b, ditherPhase + offset);
+  return Adafruit_Protomatter::color565(r, g, b);
+}
+
+#if ANALOG_INDEXED
+
+/**
+ * buildSceneColors()
+ *
+ * Fills sceneColors[] for the indexed scene. A pixel's low nibble is the
+ * palette slot drawn last (slot = palette index + 1) and its high nibble
+ * the slot underneath. Without glow a pixel shows its top color, exactly
+ * like drawing straight into the canvas; with glow a crossing shows the
+ * two colors added together, clamped per channel. While dithering this
+ * runs every frame, so the table holds the current frame's colors.
+ */
+static void buildSceneColors(bool glow) {
+  for (int i = 0; i < INDEXED_COLORS; i++) {
+    int top = i & 0x0F;
+    int under = i >> 4;
+    if (top == 0 || top > PALETTE_SIZE) {
+      sceneColors[i] = 0;
+      continue;
+    }
+    const uint8_t *a = palette[top - 1];
+    if (!glow || under == 0 || under == top || under > PALETTE_SIZE) {
+      sceneColors[i] = paletteColor(a[0], a[1], a[2], top);
+      continue;
+    }
+    const uint8_t *b = palette[under - 1];
+    sceneColors[i] = paletteColor(min(a[0] + b[0], 255), min(a[1] + b[1], 255), min(a[2] + b[2], 255), top);
+  }
+}
+
+#endif
+
 /**
  * pickUnusedColor()
  *
@@ -179,10 +364,8 @@ static const uint8_t palette[PALETTE_SIZE][3] = {
 static int pickUnusedColor() {
   // Collect palette indices currently on screen
   bool used[PALETTE_SIZE] = {};
-  for (int i = 0; i < numWaves; i++) {
-    if (waves[i].active) {
-      used[waves[i].colorIndex] = true;
-    }
+  for (int i = 0; i < waves.active.count; i++) {
+    used[waves.colorIndex[waves.active.slots[i]]] = true;
   }
   // Build list of available indices
   uint8_t available[PALETTE_SIZE];
@@ -193,191 +376,432 @@ static int pickUnusedColor() {
     }
   }
   if (count > 0) {
-    return available[random(count)];
+    return available[sceneRandom(count)];
   }
-  return random(PALETTE_SIZE);  // Fallback (shouldn't happen with 12 colors / 5 waves)
+  return sceneRandom(PALETTE_SIZE);  // Fallback (shouldn't happen: at most 12 wave slots for 12 colors)
 }
 
+#if !ANALOG_FIXED_POINT
 /**
- * initWaveform()
+ * waveformX()
+ *
+ * Dispatches to the correct waveform generator for a single row.
+ */
+static int waveformX(Waveforms waveform, int y, float radianOffset, GFXcanvas16 &matrix) {
+  switch (waveform) {
+    case SIN_WAVE:   return sinWave(y, radianOffset, matrix);
+    case TRI_WAVE:   return triWave(y, radianOffset, matrix);
+    case SAW_WAVE:   return sawWave(y, radianOffset, matrix);
+    case SHARK_WAVE: return sharkWave(y, radianOffset, matrix);
+    case SQR_WAVE:   return sqrWave(y, radianOffset, matrix);
+    case NOISE_WAVE: return noiseWave(y, radianOffset, matrix);
+  }
+  return 0;
+}
+#else
+/**
+ * waveformXFixed()
+ *
+ * Dispatches to the correct fixed-point generator for a single row.
+ */
+static int waveformXFixed(Waveforms waveform, uint32_t phase, uint32_t offsetKey, int width) {
+  switch (waveform) {
+    case SIN_WAVE:   return fixedToX(sinFixed(phase), width);
+    case TRI_WAVE:   return fixedToX(triFixed(phase), width);
+    case SAW_WAVE:   return fixedToX(sawFixed(phase), width);
+    case SHARK_WAVE: return fixedToX(sharkFixed(phase), width);
+    case SQR_WAVE:   return fixedToX(sqrFixed(phase), width);
+    case NOISE_WAVE: return noiseFixed(phase, offsetKey, width);
+  }
+  return 0;
+}
+#endif
+
+/**
+ * startWave()
+ *
+ * Fills slot with a new wave and a color chosen from the palette,
+ * guaranteed not to duplicate any color already on screen. The
+ * radianOffset parameter is multiplied by PI so callers can pass simple
+ * integers (e.g. 10 becomes ~31.4 radians across the screen height).
+ * The caller adds the slot to the active list afterwards.
+ *
+ * The generator is evaluated once here for every row (0..height inclusive)
+ * and the results stored in the slot's x table, so drawWaveform() never
+ * touches the trig functions.
  *
- * Creates a new Wave with a color chosen from the palette, guaranteed not
- * to duplicate any color already on screen. The radianOffset parameter is
- * multiplied by PI so callers can pass simple integers (e.g. 10 becomes
- * ~31.4 radians across the screen height).
+ * @param slot          Free slot to fill
+ * @param radianOffset  Frequency multiplier (multiplied by PI internally)
+ * @param length        Visible tail length in pixels
+ * @param speed         Scroll speed in pixels per frame
+ * @param waveform      Which waveform shape to use
+ * @param matrix        Canvas the wave will be drawn on (used for screen dimensions)
  */
-Wave initWaveform(int radianOffset, int length, int speed, Waveforms waveform, Adafruit_Protomatter &matrix) {
-  Wave wave;
-  wave.length = length;
-  wave.speed = speed;
-  wave.direction = random(2) ? 1 : -1;  // Randomly scroll down or up
+static void startWave(int slot, int radianOffset, int length, int speed, Waveforms waveform, GFXcanvas16 &matrix) {
+  uint8_t *table = waves.x + slot * waves.tableSize;
+  waves.length[slot] = length;
+  waves.speed[slot] = speed;
+  waves.direction[slot] = sceneRandom(2) ? 1 : -1;  // Randomly scroll down or up
   // Downward waves start at the top; upward waves start at the bottom
-  wave.curY = (wave.direction == 1) ? 0 : matrix.height();
-  wave.radianOffset = radianOffset * PI;
-  wave.colorIndex = pickUnusedColor();
-  wave.color = matrix.color565(palette[wave.colorIndex][0], palette[wave.colorIndex][1], palette[wave.colorIndex][2]);
-  wave.waveform = waveform;
-  wave.active = true;
-  return wave;
+  waves.curY[slot] = (waves.direction[slot] == 1) ? 0 : matrix.height();
+  int colorIndex = pickUnusedColor();
+  waves.colorIndex[slot] = colorIndex;
+  waves.color[slot] = paletteColor(palette[colorIndex][0], palette[colorIndex][1], palette[colorIndex][2], slot);
+  waves.waveform[slot] = waveform;
+
+  int rows = matrix.height() + 1;
+#if !ANALOG_FIXED_POINT
+  float radians = radianOffset * PI;
+  for (int y = 0; y < rows; y++) {
+    table[y] = waveformX(waveform, y, radians, matrix);
+  }
+#else
+  // Q15 phase accumulator: the wave covers radianOffset * PI over the
+  // screen height, i.e. radianOffset * 16384 phase units per height rows.
+  // The remainder term keeps the per-row step exact (no drift).
+  int width = matrix.width();
+  int height = matrix.height();
+  uint32_t turnsPerScreen = (uint32_t)radianOffset * (SINE_TURN / 2);
+  uint32_t step = turnsPerScreen / height;
+  uint32_t stepRem = turnsPerScreen % height;
+  uint32_t phase = 0;
+  uint32_t rem = 0;
+  // Same key as (uint32_t)(radianOffset * PI * 100) in the float path
+  uint32_t offsetKey = (uint32_t)((uint64_t)radianOffset * 314159265ULL / 1000000ULL);
+  for (int y = 0; y < rows; y++) {
+    table[y] = waveformXFixed(waveform, phase, offsetKey, width);
+    phase += step;
+    rem += stepRem;
+    if (rem >= (uint32_t)height) {
+      rem -= height;
+      phase++;
+    }
+  }
+#endif
+}
+
+/**
+ * plotTrace() / plotRow()
+ *
+ * Where drawWaveform() puts a wave's pixels: the indexed scene with
+ * ANALOG_INDEXED, otherwise straight into the canvas. ink is what
+ * waveInk() returns for the wave.
+ */
+static inline void plotTrace(GFXcanvas16 &matrix, uint16_t ink, int x, int y) {
+#if ANALOG_INDEXED
+  (void)matrix;
+  indexedTrace(scene, x, y, ink);
+#else
+  fastTrace(matrix, x, y, ink);
+#endif
+}
+
+static inline void plotRow(GFXcanvas16 &matrix, uint16_t ink, int y) {
+#if ANALOG_INDEXED
+  indexedHLine(scene, 0, y, matrix.width(), ink);
+#else
+  fastHLine(matrix, 0, y, matrix.width(), ink);
+#endif
+}
+
+/** A wave's palette slot in the indexed scene (ANALOG_INDEXED), else its RGB565 color. */
+static inline uint16_t waveInk(int slot) {
+#if ANALOG_INDEXED
+  return waves.colorIndex[slot] + 1;
+#else
+  return waves.color[slot];
+#endif
 }
 
 /**
  * drawWaveform()
  *
  * Renders a single waveform for the current frame. Draws pixels from the
- * trailing edge (curY - length) to the leading edge (curY), calling the
- * appropriate generator function for each row to determine X position.
+ * trailing edge (curY - length) to the leading edge (curY), reading each
+ * row's X position from the wave's precomputed lookup table. The drawn
+ * row span is queued in dirtySpans so the next frame can erase exactly
+ * those rows.
  *
  * Special-case handling for sawtooth and square waves: when the X value
  * jumps abruptly between consecutive rows (a snap-back or high/low
  * transition), a full-width horizontal line is drawn to connect them
  * visually, mimicking how these waveforms appear on a real oscilloscope.
+ *
+ * When the governor sheds to QUALITY_HALF_ROWS, every other table entry is
+ * read and drawn two rows tall.
  */
-static void drawWaveform(struct Wave &wave, Adafruit_Protomatter &matrix) {
-  int x;
+static void drawWaveform(int slot, GFXcanvas16 &matrix) {
+  int screenW = matrix.width();
   int screenH = matrix.height();
+  int curY = waves.curY[slot];
+  int length = waves.length[slot];
+  int direction = waves.direction[slot];
+  Waveforms waveform = (Waveforms)waves.waveform[slot];
+  const uint8_t *table = waves.x + slot * waves.tableSize;
+  uint16_t ink = waveInk(slot);
 
   // Compute the visible Y range. For downward waves the leading edge is
   // curY with the tail above; for upward waves the leading edge is curY
   // with the tail below.
   int startingY, endingY;
-  if (wave.direction == 1) {
-    startingY = wave.curY - wave.length;
-    endingY = wave.curY;
+  if (direction == 1) {
+    startingY = curY - length;
+    endingY = curY;
   } else {
-    startingY = wave.curY;
-    endingY = wave.curY + wave.length;
+    startingY = curY;
+    endingY = curY + length;
   }
   // Clamp to screen bounds
   if (startingY < 0) startingY = 0;
   if (endingY > screenH) endingY = screenH;
 
-  for (int y = startingY; y <= endingY; y++) {
-    // Dispatch to the correct waveform generator
-    switch (wave.waveform) {
-      case SIN_WAVE:
-        x = sinWave(y, wave.radianOffset, matrix);
-        break;
-      case TRI_WAVE:
-        x = triWave(y, wave.radianOffset, matrix);
-        break;
-      case SAW_WAVE:
-        x = sawWave(y, wave.radianOffset, matrix);
-        break;
-      case SHARK_WAVE:
-        x = sharkWave(y, wave.radianOffset, matrix);
-        break;
-      case SQR_WAVE:
-        x = sqrWave(y, wave.radianOffset, matrix);
-        break;
-      case NOISE_WAVE:
-        x = noiseWave(y, wave.radianOffset, matrix);
-        break;
-    }
+  // Every pixel below (trace and edge lines) lies within these rows
+  if (endingY >= startingY) {
+    dirtySpans[dirtyCount].y = startingY;
+    dirtySpans[dirtyCount].rows = endingY - startingY + 1;
+    dirtyCount++;
+  }
+
+  bool hasEdges = (waveform == SAW_WAVE || waveform == SQR_WAVE);
+
+  // At QUALITY_HALF_ROWS each table entry is drawn for two rows
+  int step = governorSheds(QUALITY_HALF_ROWS) ? 2 : 1;
+
+  // Each pass draws rows y and y + 1 only: skip the passes outside the
+  // draw window (fastdraw.h), keeping to the same step grid
+  int16_t windowTop, windowBottom;
+  fastDrawRows(matrix, windowTop, windowBottom);
+  int fromY = startingY;
+  if (fromY < windowTop - 1) fromY += (windowTop - 1 - fromY + step - 1) / step * step;
+
+  for (int y = fromY; y <= endingY && y < windowBottom; y += step) {
+    int x = table[y];
 
     // Draw 2-pixel thick line horizontally
-    matrix.drawPixel(x, y, wave.color);
-    if (x + 1 < matrix.width()) {
-      matrix.drawPixel(x + 1, y, wave.color);
-    }
+    plotTrace(matrix, ink, x, y);
+    if (step == 2 && y < endingY) plotTrace(matrix, ink, x, y + 1);
+
+    if (!hasEdges || y >= endingY) continue;
 
     // Sawtooth snap-back: if the next row's X jumps more than half the
-    // screen width to the left, it's a wrap-around — draw a horizontal
+    // screen width to the left, it's a wrap-around. Square wave transition:
+    // the output flips between high and low. Either way, draw a horizontal
     // line across the full width to connect the two sides.
-    if (wave.waveform == SAW_WAVE && y < endingY) {
-      int xNext = sawWave(y + 1, wave.radianOffset, matrix);
-      if (xNext < x - (matrix.width() / 2)) {
-        matrix.drawFastHLine(0, y, matrix.width(), wave.color);
-        if (y + 1 < matrix.height()) {
-          matrix.drawFastHLine(0, y + 1, matrix.width(), wave.color);
-        }
-      }
-    }
-
-    // Square wave transition: when the output flips between high and low,
-    // draw a horizontal line to create the vertical edge of the square.
-    if (wave.waveform == SQR_WAVE && y < endingY) {
-      int xNext = sqrWave(y + 1, wave.radianOffset, matrix);
-      if (xNext != x) {
-        matrix.drawFastHLine(0, y, matrix.width(), wave.color);
-        if (y + 1 < matrix.height()) {
-          matrix.drawFastHLine(0, y + 1, matrix.width(), wave.color);
-        }
+    int xNext = table[min(y + step, endingY)];
+    bool edge = (waveform == SAW_WAVE) ? (xNext < x - (screenW / 2)) : (xNext != x);
+    if (edge) {
+      plotRow(matrix, ink, y);
+      if (y + 1 < screenH) {
+        plotRow(matrix, ink, y + 1);
       }
     }
   }
 
   // Advance the leading edge in the wave's scroll direction
-  wave.curY = wave.curY + wave.speed * wave.direction;
+  waves.curY[slot] = curY + waves.speed[slot] * direction;
 }
 
 /**
  * initAnalog()
  *
- * Initializes the analog scene by spawning the first waveform.
- * Additional waves will spawn dynamically during drawAnalog().
+ * Allocates the wave pool for maxWaves slots, their lookup tables and the
+ * dirty span list (in a single block) and, with ANALOG_INDEXED, the
+ * indexed scene and its color table. Spawns the first waveform;
+ * additional waves will spawn dynamically during drawAnalog().
+ */
+bool initAnalog(GFXcanvas16 &matrix, int maxWaves, bool glow) {
+  int tableSize = matrix.height() + 1;
+  free(wavesBlock);
+  // Widest fields first so every array stays aligned
+  size_t perSlot = sizeof(DirtySpan) + 2 * sizeof(int16_t) + sizeof(uint16_t) + 5 * sizeof(uint8_t) + tableSize;
+  wavesBlock = calloc(maxWaves, perSlot);
+  if (wavesBlock == NULL) {
+    numWaves = 0;
+    return false;
+  }
+#if ANALOG_INDEXED
+  indexedFree(scene);
+  if (!indexedCreate(scene, matrix.width(), matrix.height())) {
+    free(wavesBlock);
+    wavesBlock = NULL;
+    numWaves = 0;
+    return false;
+  }
+  sceneGlow = glow;
+  buildSceneColors(glow);
+#else
+  (void)glow;
+#endif
+  numWaves = maxWaves;
+  ditherPhase = 0;
+  uint8_t *cursor = (uint8_t *)wavesBlock;
+  dirtySpans = poolCarve<DirtySpan>(cursor, maxWaves);
+  waves.curY = poolCarve<int16_t>(cursor, maxWaves);
+  waves.length = poolCarve<int16_t>(cursor, maxWaves);
+  waves.color = poolCarve<uint16_t>(cursor, maxWaves);
+  waves.colorIndex = poolCarve<uint8_t>(cursor, maxWaves);
+  waves.speed = poolCarve<uint8_t>(cursor, maxWaves);
+  waves.direction = poolCarve<int8_t>(cursor, maxWaves);
+  waves.waveform = poolCarve<uint8_t>(cursor, maxWaves);
+  waves.active.slots = poolCarve<uint8_t>(cursor, maxWaves);
+  waves.x = poolCarve<uint8_t>(cursor, maxWaves * tableSize);
+  waves.tableSize = tableSize;
+  waves.active.count = 0;
+  dirtyCount = 0;
+
+  startWave(0, 10, 100, 6, waveformArray[sceneRandom(numWaveforms)], matrix);
+  activeInsert(waves.active, 0);
+  return true;
+}
+
+/**
+ * invalidateAnalog()
+ *
+ * Requests a full-screen clear on the next frame.
  */
-void initAnalog(Adafruit_Protomatter &matrix) {
-  waves[0] = initWaveform(10, 100, 6, waveformArray[random(numWaveforms)], matrix);
+void invalidateAnalog() {
+  fullClearPending = true;
 }
 
 /**
  * spawnWave()
  *
- * Finds the first inactive wave slot and initializes it with randomized
- * parameters (frequency, length, speed, and waveform type).
+ * Starts a wave with randomized parameters (frequency, length, speed, and
+ * waveform type) in the lowest free slot, if there is one.
+ */
+static void spawnWave(GFXcanvas16 &matrix) {
+  int slot = activeLowestFree(waves.active, numWaves);
+  if (slot < 0) return;
+  startWave(slot, sceneRandom(2, 40), sceneRandom(40, matrix.height()), sceneRandom(1, 6), waveformArray[sceneRandom(numWaveforms)], matrix);
+  activeInsert(waves.active, slot);
+}
+
+/**
+ * clearAnalog()
+ *
+ * Erases the previous frame. With ANALOG_DIRTY_SPANS only the rows each
+ * wave drew last frame are cleared (at most a few tails of 32-pixel rows
+ * instead of all 576); otherwise, or after invalidateAnalog(), the whole
+ * screen is cleared. With ANALOG_INDEXED the clearing happens in the
+ * indexed scene and reaches the canvas through expandAnalog().
  */
-static void spawnWave(Adafruit_Protomatter &matrix) {
-  for (int i = 0; i < numWaves; i++) {
-    if (!waves[i].active) {
-      waves[i] = initWaveform(random(2, 40), random(40, matrix.height()), random(1, 6), waveformArray[random(numWaveforms)], matrix);
-      return;
+static void clearAnalog(GFXcanvas16 &matrix) {
+  int spans = dirtyCount;
+  dirtyCount = 0;
+#if ANALOG_INDEXED
+  // Scene rows outside the draw window are never expanded or shown
+  int16_t windowTop, windowBottom;
+  fastDrawRows(matrix, windowTop, windowBottom);
+#endif
+#if ANALOG_DIRTY_SPANS
+  if (!fullClearPending) {
+    for (int i = 0; i < spans; i++) {
+#if ANALOG_INDEXED
+      int16_t from = max(dirtySpans[i].y, windowTop);
+      int16_t to = min((int16_t)(dirtySpans[i].y + dirtySpans[i].rows), windowBottom);
+      indexedClearRows(scene, from, to - from);
+#else
+      fastFillRect(matrix, 0, dirtySpans[i].y, matrix.width(), dirtySpans[i].rows, 0);
+#endif
     }
+    return;
   }
+#else
+  (void)spans;
+#endif
+#if ANALOG_INDEXED
+  indexedClearRows(scene, windowTop, windowBottom - windowTop);
+#else
+  matrix.fillScreen(0);
+#endif
+  fullClearPending = false;
+}
+
+/**
+ * expandAnalog()
+ *
+ * With ANALOG_INDEXED, copies every row of the indexed scene that was
+ * erased or drawn this frame into the canvas through the color table.
+ */
+static void expandAnalog(GFXcanvas16 &matrix) {
+#if ANALOG_INDEXED
+  indexedExpand(scene, matrix, sceneColors);
+#else
+  (void)matrix;
+#endif
+}
+
+/**
+ * ditherWaveColors()
+ *
+ * Steps the dither cycle and recomputes the colors waves draw with this
+ * frame: the indexed scene's color table, or each active wave's RGB565.
+ * Every lit row is redrawn each frame, so the new colors reach every
+ * wave pixel.
+ */
+static void ditherWaveColors() {
+  ditherPhase++;
+#if ANALOG_INDEXED
+  buildSceneColors(sceneGlow);
+#else
+  for (int i = 0; i < waves.active.count; i++) {
+    int slot = waves.active.slots[i];
+    const uint8_t *rgb = palette[waves.colorIndex[slot]];
+    waves.color[slot] = paletteColor(rgb[0], rgb[1], rgb[2], slot);
+  }
+#endif
 }
 
 /**
  * drawAnalog()
  *
  * Main entry point for the analog visualization mode, called once per frame.
- * Clears the screen, draws all active waveforms, retires any that have
+ * Clears the previous frame, draws all active waveforms, retires any that have
  * scrolled off, and ensures at least one wave is always visible. Additional
- * waves spawn randomly up to a maximum of 4 concurrent.
+ * waves spawn randomly while fewer than numWaves - 1 are active (4 with the
+ * default five slots), so one slot is usually free. The caller presents
+ * the finished frame with matrix.show().
  */
-void drawAnalog(Adafruit_Protomatter &matrix) {
-  matrix.fillScreen(0);
-
-  int activeCount = 0;
-  for (int i = 0; i < numWaves; i++) {
-    if (!waves[i].active) continue;
-
-    drawWaveform(waves[i], matrix);
+void drawAnalog(GFXcanvas16 &matrix) {
+  clearAnalog(matrix);
+  profileMark(PHASE_CLEAR);
+  if (ditherEnabled(DITHER_ANALOG)) ditherWaveColors();
+
+  // Draw in slot order, dropping retired waves from the list as we go
+  ActiveList &active = waves.active;
+  int kept = 0;
+  for (int i = 0; i < active.count; i++) {
+    int slot = active.slots[i];
+    drawWaveform(slot, matrix);
 
     // A wave is off-screen once its trailing edge has passed the far side:
     // downward waves expire when the tail clears the bottom,
     // upward waves expire when the tail clears the top.
     bool offScreen;
-    if (waves[i].direction == 1) {
-      offScreen = (waves[i].curY - waves[i].length) > matrix.height();
-    } else {
-      offScreen = (waves[i].curY + waves[i].length) < 0;
-    }
-    if (offScreen) {
-      waves[i].active = false;
+    if (waves.direction[slot] == 1) {
+      offScreen = (waves.curY[slot] - waves.length[slot]) > matrix.height();
     } else {
-      activeCount++;
+      offScreen = (waves.curY[slot] + waves.length[slot]) < 0;
     }
+    if (!offScreen) active.slots[kept++] = slot;
   }
+  active.count = kept;
+  expandAnalog(matrix);
+  profileMark(PHASE_DRAW);
 
   // Always keep at least 1 wave on screen
-  if (activeCount < 1) {
+  if (kept < 1) {
     spawnWave(matrix);
   }
 
-  // ~0.8% chance each frame to spawn another wave (up to 4 concurrent)
-  if (activeCount < 4 && random(120) == 0) {
+  // ~0.8% chance each frame to spawn another wave (up to numWaves - 1
+  // concurrent), unless the governor is shedding optional spawns
+  if (kept < numWaves - 1 && !governorSheds(QUALITY_NO_EXTRA_SPAWNS) && sceneRandom(120) == 0) {
     spawnWave(matrix);
   }
+  profileMark(PHASE_UPDATE);
+}
 
-  matrix.show();
+int analogActiveWaves() {
+  return waves.active.count;
 }
@@ -2,8 +2,8 @@
  * analog.h
  *
  * Header for the analog waveform visualization mode.
- * Defines the available waveform types, the Wave struct that tracks each
- * active waveform's state, and the public API used by the main sketch.
+ * Defines the available waveform types and the public API used by the
+ * main sketch. Per-wave state lives in a pool inside analog.cpp.
  */
 
 #ifndef ANALOG_H
@@ -11,6 +11,42 @@
 
 #include <Adafruit_Protomatter.h>
 
+/**
+ * ANALOG_FIXED_POINT
+ *
+ * Selects the waveform generator implementation used to fill each wave's
+ * lookup table. 0 = float generators (sin/asin/fmod via libm). 1 = integer
+ * generators driven by a Q15 phase accumulator and the shared sine table
+ * in sinetable.h, for MCUs without an FPU. Output matches within a pixel.
+ */
+#ifndef ANALOG_FIXED_POINT
+#define ANALOG_FIXED_POINT 0
+#endif
+
+/**
+ * ANALOG_DIRTY_SPANS
+ *
+ * 1 = drawAnalog() erases only the rows each wave drew on the previous
+ * frame instead of clearing the whole screen. 0 = full fillScreen(0)
+ * every frame (reference behavior).
+ */
+#ifndef ANALOG_DIRTY_SPANS
+#define ANALOG_DIRTY_SPANS 1
+#endif
+
+/**
+ * ANALOG_INDEXED
+ *
+ * 1 = waves draw into a one-byte-per-pixel palette-indexed scene (see
+ * indexed.h) that records which two colors meet at each pixel, and the
+ * touched rows are expanded into the canvas through a color table. This
+ * is what lets crossings glow (config setting glow). 0 = waves draw
+ * RGB565 straight into the canvas, the later wave covering the earlier.
+ */
+#ifndef ANALOG_INDEXED
+#define ANALOG_INDEXED 1
+#endif
+
 /** Total number of distinct waveform shapes available. */
 const int numWaveforms = 6;
 
@@ -29,65 +65,49 @@ enum Waveforms {
   NOISE_WAVE   // Smooth random noise (cosine-interpolated random control points)
 };
 
-/**
- * Wave
- *
- * Holds all per-waveform state: current draw position, visual properties,
- * and activity flag. Waves scroll top-to-bottom and deactivate once their
- * trailing edge passes the bottom of the screen.
- */
-struct Wave {
-  int curY;            // Leading edge Y position (advances each frame)
-  int curClearY;       // Trailing edge Y position for erasing old pixels
-  int color;           // 16-bit RGB565 color
-  int colorIndex;      // Index into the palette (used to prevent duplicate colors on screen)
-  int length;          // Visible length in pixels between leading and trailing edges
-  int speed;           // Pixels the leading edge advances per frame
-  int direction;       // +1 = scrolls downward, -1 = scrolls upward
-  float radianOffset;  // Controls waveform frequency — higher = more cycles on screen
-  Waveforms waveform;  // Which shape generator to use
-  bool active;         // false once the wave has fully scrolled off-screen
-};
-
-/** Maximum number of concurrent waveforms on screen. */
-const int numWaves = 5;
+/** Number of wave slots (maximum concurrent waveforms), set by initAnalog(). */
+extern int numWaves;
 
 extern Waveforms waveformArray[numWaveforms];
-extern Wave waves[numWaves];
 
 /**
- * initWaveform()
+ * initAnalog()
  *
- * Creates and returns a new Wave with the given parameters and a random color.
+ * Allocates the wave slots and their lookup tables for the canvas height
+ * (and the indexed scene, see ANALOG_INDEXED), then spawns the first
+ * waveform. Call once from setup().
  *
- * @param radianOffset  Frequency multiplier (multiplied by PI internally)
- * @param length        Visible tail length in pixels
- * @param speed         Scroll speed in pixels per frame
- * @param waveform      Which waveform shape to use
- * @param matrix        Reference to the LED matrix (used for color generation)
- * @return              Fully initialized Wave struct
+ * @param matrix    Canvas to draw into (the LED matrix or an offscreen scene canvas)
+ * @param maxWaves  Number of wave slots
+ * @param glow      Where two waves cross, show their colors added together
+ *                  instead of the later one (ANALOG_INDEXED only)
+ * @return          false if the slots could not be allocated
  */
-Wave initWaveform(int radianOffset, int length, int speed, Waveforms waveform, Adafruit_Protomatter &matrix);
+bool initAnalog(GFXcanvas16 &matrix, int maxWaves, bool glow);
 
 /**
- * drawAnalog()
- *
- * Renders one frame of the analog waveform scene. Clears the screen, draws
- * all active waveforms, deactivates any that have scrolled off, and spawns
- * new ones to keep the display populated.
+ * invalidateAnalog()
  *
- * @param matrix  Reference to the LED matrix
+ * Forces the next drawAnalog() to clear the whole screen rather than only
+ * the rows the waves touched. Call whenever something other than the
+ * analog scene has drawn to the matrix (e.g. after digital mode ran).
  */
+void invalidateAnalog();
+
 /**
- * initAnalog()
+ * drawAnalog()
  *
- * Initializes the analog waveform scene by spawning the first waveform.
- * Call once from setup().
+ * Renders one frame of the analog waveform scene. Clears the screen (or
+ * just last frame's wave rows, see ANALOG_DIRTY_SPANS), draws all active
+ * waveforms, deactivates any that have scrolled off, and spawns new ones
+ * to keep the display populated. Does not call matrix.show(); the main
+ * loop presents the frame.
  *
- * @param matrix  Reference to the LED matrix
+ * @param matrix  Canvas to draw into (the LED matrix or an offscreen scene canvas)
  */
-void initAnalog(Adafruit_Protomatter &matrix);
+void drawAnalog(GFXcanvas16 &matrix);
 
-void drawAnalog(Adafruit_Protomatter &matrix);
+/** Number of waves currently on screen (telemetry). */
+int analogActiveWaves();
 
 #endif
@@ -9,15 +9,54 @@
  *   - Digital mode: a "Matrix"-style rain of binary digits with animated
  *     blinking eyes, eyelashes, and expanding ripple effects
  *
- * Sending a space character (' ') over the serial console toggles
- * between the two modes at runtime.
+ * The mode follows the Teensy sensor controller: each sensor trigger
+ * arrives as a UART frame (see triggerlink.h) that switches to digital
+ * mode and opens an eye at that sensor's place on the next frame. If no
+ * link frames arrive, a switch on pin A1 selects the mode as before.
+ * Single-character commands
+ * over the serial console control the frame profiler:
+ *   p = print frame-time stats, r = reset stats, o = toggle bar overlay,
+ *   g = cycle the quality governor through auto and each forced level,
+ *   t = toggle the binary telemetry stream (see telemetry.h),
+ *   b = run the deterministic replay and print its signature (see replay.h)
+ * and a line starting with 'c' views or edits the boot-time settings
+ * (panel count, bit depth, FPS, scene limits; see config.h).
+ *
+ * Flipping the switch cross-fades between the modes (see transition.h).
+ *
+ * Built with NETWORK_SINK, the wall also shows frames streamed over DDP
+ * or Art-Net (see netsink.h) for as long as they keep arriving, and goes
+ * back to the scenes afterwards.
+ *
+ * Built with WALL_SHARDING, several MatrixPortals can drive one long wall
+ * between them (config settings "shards" and "node"; see shard.h). Each
+ * renders the whole wall's scenes in step with the others and shows its
+ * own part.
+ *
+ * On the ESP32-S3 the scenes are rendered by a task on core 0 into an
+ * offscreen canvas while this loop (core 1) presents the previous frame
+ * and polls inputs; see pipeline.h. Elsewhere everything runs inline.
  */
 
 #include <Adafruit_Protomatter.h>
+#include <atomic>
 #include <elapsedMillis.h>
 #include <math.h>
 #include "analog.h"
+#include "config.h"
 #include "digital.h"
+#include "dither.h"
+#include "governor.h"
+#include "netsink.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "replay.h"
+#include "scenerandom.h"
+#include "scheduler.h"
+#include "shard.h"
+#include "telemetry.h"
+#include "transition.h"
+#include "triggerlink.h"
 
 // --- HUB75 wiring for MatrixPortal ESP32-S3 ---
 uint8_t rgbPins[]  = {42, 41, 40, 38, 39, 37};
@@ -26,76 +65,433 @@ uint8_t clockPin   = 2;
 uint8_t latchPin   = 47;
 uint8_t oePin      = 14;
 
-// Nine 64-wide panels chained together = 576 pixels wide.
+// Chain of config.panelCount 64-wide panels (nine = 576 pixels wide).
 // After setRotation(1) the long axis becomes the Y axis (height).
-Adafruit_Protomatter matrix(
-  64 * 9,          // Width of matrix (or matrix chain) in pixels
-  4,           // Bit depth, 1-6
-  1, rgbPins,  // # of matrix chains, array of 6 RGB pins for each
-  4, addrPins, // # of address pins (height is inferred), array of pins
-  clockPin, latchPin, oePin, // Other matrix control pins
-  true // Double Buffered
-);
+// Created in setup() once the settings have been read.
+Adafruit_Protomatter *matrix = NULL;
 
 // --- Frame rate limiter ---
 elapsedMicros timeSinceFrame = 0;
-elapsedMicros frameTimer = 0;
-const uint8_t maxFPS = 60;
-const unsigned long microsPerFrame = 1000000 / maxFPS;
+unsigned long microsPerFrame = 1000000 / 60;  // Set from config.maxFPS in setup()
+
+// true = waveform mode, false = binary rain / eyes mode.
+// Written by loop(); read by the renderer (which may run on the other core).
+volatile bool analogMode = true;
+
+// Mode the renderer drew last frame, to detect switches
+bool renderedAnalog = true;
+
+// Quality level pinned with the 'g' command, -1 = governor decides
+int forcedQuality = -1;
+
+// true while the network sink owns the display (see loop())
+bool sinkShowing = false;
+
+// true when this board is one node of a sharded wall (see runShard())
+bool sharded = false;
+
+// With the frame scheduler: the mode switch as last read, after its interrupt
+bool switchAnalog = true;
+
+// Serial commands that touch render-thread state. handleSerial() posts
+// them here; applySerialCommands() runs them at the start of a frame.
+const uint32_t COMMAND_PROFILE_RESET = 1 << 0;
+const uint32_t COMMAND_FORCE_QUALITY = 1 << 1;
+const uint32_t COMMAND_TOGGLE_OVERLAY = 1 << 2;
+std::atomic<uint32_t> pendingCommands(0);
+std::atomic<int> pendingQuality(-1);  // Level for COMMAND_FORCE_QUALITY
 
-// true = waveform mode, false = binary rain / eyes mode
-bool analogMode = true;
+// Serial 'c' command line being received (see handleSerial())
+char configLine[32];
+int configLineLength = -1;  // -1 = not receiving a line
+
+
+/**
+ * haltWithConsole()
+ *
+ * Stops the sketch after a startup failure but keeps serial commands
+ * running, so settings that do not fit (too many panels, too deep a bit
+ * depth for RAM) can be changed and saved without reflashing.
+ */
+void haltWithConsole() {
+  Serial.println("Halted: adjust settings with the c command, then c save");
+  for(;;) {
+    handleSerial();
+    delay(10);
+  }
+}
 
 
 /**
  * setup()
  *
- * Arduino entry point. Initializes serial, the LED matrix hardware,
- * pre-computes the vertical spacing for the scrolling digit characters,
- * and seeds the first waveform for analog mode.
+ * Arduino entry point. Initializes serial, loads the boot-time settings,
+ * creates and starts the LED matrix with the configured chain length and
+ * bit depth, sizes the scene arrays, pre-computes the vertical spacing
+ * for the scrolling digit characters, and seeds the first waveform for
+ * analog mode.
  */
 void setup(void) {
   Serial.begin(115200);
 
-  ProtomatterStatus status = matrix.begin();
+  if (!configLoad(config)) Serial.println("No stored config, using defaults");
+  configPrint(config);
+  microsPerFrame = 1000000 / config.maxFPS;
+
+  matrix = new Adafruit_Protomatter(
+    PANEL_WIDTH * config.panelCount, // Width of matrix (or matrix chain) in pixels
+    config.bitDepth,                 // Bit depth, 1-6
+    1, rgbPins,  // # of matrix chains, array of 6 RGB pins for each
+    4, addrPins, // # of address pins (height is inferred), array of pins
+    clockPin, latchPin, oePin, // Other matrix control pins
+    config.doubleBuffer != 0   // Double Buffered
+  );
+
+  ProtomatterStatus status = matrix->begin();
   Serial.print("Protomatter begin() status: ");
   Serial.println((int)status);
   if(status != PROTOMATTER_OK) {
-    for(;;); // Halt if the matrix failed to initialize
+    haltWithConsole(); // Halt if the matrix failed to initialize (e.g. too many panels for RAM)
   }
 
-  // Rotate so the long 576 px chain becomes vertical (Y axis)
-  matrix.setRotation(1);
-  matrix.fillScreen(0);
-  matrix.show();
+  // Rotate so the long panel chain becomes vertical (Y axis)
+  matrix->setRotation(1);
+  matrix->fillScreen(0);
+  matrix->show();
 
   pinMode(A1, INPUT_PULLUP);
+#if FRAME_SCHEDULER
+  schedulerWatchPin(A1);
+#endif
+  // The live show differs on every boot; replays reseed for themselves
+  sceneRandomSeed(((uint64_t)random(0x7FFFFFFF) << 32) | (uint32_t)random(0x7FFFFFFF));
+  triggerLinkBegin();
+  telemetryBegin();
+#if NETWORK_SINK
+  if (!netsinkBegin(*matrix, config.sinkJitter, config.sinkUniverse)) {
+    Serial.println("Network sink allocation failed");
+  }
+#endif
+
+  ditherBegin(config.bitDepth, config.gammaTenths, config.ditherScenes);
+  if (!initDigital(*matrix, config.digitCharCount, config.charScale, config.maxEyes, config.digitTrail) ||
+      !initAnalog(*matrix, config.maxWaves, config.waveGlow != 0)) {
+    Serial.println("Scene allocation failed");
+    haltWithConsole();
+  }
+
+#if WALL_SHARDING
+  if (config.shardCount > 1) {
+    if (!shardBegin(*matrix, config.shardCount, config.shardNode, (uint32_t)random(0x7FFFFFFF))) {
+      Serial.println("Wall shard setup failed (check shards, node and memory)");
+      haltWithConsole();
+    }
+    sharded = true;
+  }
+#endif
+  // Once, so no mode switch ever allocates (shardBegin() did the wall's)
+  if (!sharded && !transitionAllocate(*matrix, config.fadeFrames)) {
+    Serial.println("Fade layer allocation failed, mode switches cut");
+  }
+
+#if FRAME_SCHEDULER
+  schedulerBegin(microsPerFrame);
+#endif
 
-  initDigital(matrix);
-  initAnalog(matrix);
+#if RENDER_PIPELINE
+  // A sharded wall renders from loop(), in step with its pulses
+  if (!sharded && !pipelineBegin(*matrix, renderScene, microsPerFrame)) {
+    Serial.println("Render pipeline failed to start");
+    haltWithConsole();
+  }
+#endif
 
   Serial.println("Setup complete");
 }
 
 
+/**
+ * handleSerial()
+ *
+ * Processes single-character profiler commands from the serial console.
+ * 'c' starts a config command that runs once its line is complete.
+ * Commands that change what the renderer owns (profiler stats, governor
+ * level, overlay) are posted to applySerialCommands(), because the
+ * renderer may be on the other core.
+ */
+void handleSerial() {
+  while (Serial.available() > 0) {
+    int c = Serial.read();
+    if (configLineLength >= 0) {
+      if (c == '\n' || c == '\r') {
+        configLine[configLineLength] = '\0';
+        configLineLength = -1;
+        configCommand(config, configLine);
+      } else if (configLineLength < (int)sizeof(configLine) - 1) {
+        configLine[configLineLength++] = (char)c;
+      }
+      continue;
+    }
+    switch (c) {
+      case 'c':
+        configLineLength = 0;
+        break;
+      case 'p':
+        profilePrint();
+        governorPrint();
+#if RENDER_PIPELINE
+        pipelinePrintStats();
+#endif
+        triggerLinkPrintStats();
+#if NETWORK_SINK
+        netsinkPrintStats();
+#endif
+        if (sharded) shardPrintStats();
+#if FRAME_SCHEDULER
+        schedulerPrintStats();
+#endif
+        break;
+      case 'g':
+        // auto -> full -> ... -> half rows -> auto
+        forcedQuality = (forcedQuality + 2) % (QUALITY_LEVEL_COUNT + 1) - 1;
+        pendingQuality.store(forcedQuality);
+        pendingCommands.fetch_or(COMMAND_FORCE_QUALITY);
+        if (forcedQuality >= 0) Serial.printf("governor: forcing level %d\n", forcedQuality);
+        else Serial.println("governor: automatic");
+        break;
+      case 't':
+        telemetryToggleSerial();
+        break;
+      case 'b':
+        if (sharded) {
+          Serial.println("replay: not available on a sharded wall");
+          break;
+        }
+        Serial.printf("replay: %d frames, seed %lu\n", REPLAY_DEFAULT_FRAMES, (unsigned long)REPLAY_DEFAULT_SEED);
+        replayStart(REPLAY_DEFAULT_FRAMES, REPLAY_DEFAULT_SEED, forcedQuality);
+        break;
+      case 'r':
+        pendingCommands.fetch_or(COMMAND_PROFILE_RESET);
+        Serial.println("Profiler reset");
+        break;
+      case 'o':
+        pendingCommands.fetch_or(COMMAND_TOGGLE_OVERLAY);
+        break;
+    }
+  }
+}
+
+/**
+ * applySerialCommands()
+ *
+ * Runs the commands handleSerial() posted since the last frame. Called
+ * by the thread that renders, before it draws anything, so the profiler,
+ * governor and scenes only ever change between frames.
+ */
+void applySerialCommands() {
+  uint32_t commands = pendingCommands.exchange(0);
+  if (commands == 0) return;
+  if (commands & COMMAND_PROFILE_RESET) profileReset();
+  if (commands & COMMAND_FORCE_QUALITY) governorForceLevel(pendingQuality.load());
+  if (commands & COMMAND_TOGGLE_OVERLAY) {
+    profileSetOverlay(!profileOverlayEnabled());
+    // The analog scene only erases its own rows; wipe the old bars
+    if (!profileOverlayEnabled()) invalidateAnalog();
+  }
+}
+
+
+/**
+ * renderScene()
+ *
+ * Draws one frame of whichever scene is selected into canvas, plus the
+ * profiler overlay (or, during a replay, the next replay frame alone).
+ * Serial commands posted since the last frame apply first. Sensor
+ * triggers that arrived since then open their eyes next, so they show
+ * in this frame. While a mode switch is cross-fading, both scenes are
+ * drawn and blended. Runs inline from loop(), or on the render task when
+ * the pipeline is enabled.
+ */
+void renderScene(GFXcanvas16 &canvas) {
+  applySerialCommands();
+  if (replayRender(canvas)) {
+    profileMark(PHASE_DRAW);
+    return;
+  }
+
+  uint32_t triggers = triggerLinkTake();
+  for (int sensor = 0; triggers != 0; sensor++, triggers >>= 1) {
+    if (triggers & 1) digitalTrigger(canvas, sensor, triggerLinkSensorCount());
+  }
+
+  bool analog = analogMode;
+  if (analog != renderedAnalog) {
+    // Digital mode paints the whole screen; analog only erases its own rows
+    // and enters on a canvas (or fade layer) it didn't draw
+    if (analog) invalidateAnalog();
+    transitionBegin(canvas, config.fadeFrames);
+    renderedAnalog = analog;
+  }
+
+  if (transitionActive()) {
+    transitionRender(canvas, analog ? drawDigital : drawAnalog, analog ? drawAnalog : drawDigital);
+  } else if (analog) {
+    drawAnalog(canvas);
+  } else {
+    drawDigital(canvas);
+  }
+  profileDrawOverlay(canvas, microsPerFrame);
+  profileMark(PHASE_DRAW);
+}
+
+
+/**
+ * showSinkFrames()
+ *
+ * Network sink mode: the streamed frames replace the scenes. With the
+ * pipeline, the render task is parked first so it stops writing to the
+ * matrix. Called from loop() while frames keep arriving.
+ */
+void showSinkFrames() {
+#if RENDER_PIPELINE
+  if (!sharded) {
+    if (!sinkShowing) pipelineSetPaused(true);
+    sinkShowing = true;
+    // Show the render task's last handoff while waiting for it to park
+    bool parked = pipelineParked();
+    pipelinePresent();
+    if (!parked) return;
+  }
+#endif
+  sinkShowing = true;
+  if (netsinkTakeFrame(*matrix, micros(), microsPerFrame)) {
+    unsigned long showStart = micros();
+    matrix->show();
+    telemetryShow(micros() - showStart);
+  }
+}
+
+
+/**
+ * leaveSink()
+ *
+ * Hands the display back to the scenes once the stream has stopped.
+ */
+void leaveSink() {
+  sinkShowing = false;
+#if RENDER_PIPELINE
+  if (!sharded) pipelineSetPaused(false);
+#else
+  // The stream drew over the scene canvas
+  invalidateAnalog();
+#endif
+}
+
+
+/**
+ * runShard()
+ *
+ * Sharded wall (see shard.h): the shared simulation replaces the frame
+ * limiter and renderScene(). The leader starts a frame every period from
+ * the current inputs; every node shows and renders when the pulses say
+ * so. Only the leader's governor decides anything, and it is fed the
+ * render cost here.
+ */
+void runShard() {
+  // Same thread as handleSerial() here, but keep the commands between frames
+  applySerialCommands();
+  if (shardLeader() && timeSinceFrame >= microsPerFrame && shardLeaderReady()) {
+    timeSinceFrame = 0;
+    ShardInput input = {triggerLinkTake(), (uint8_t)triggerLinkSensorCount(), (uint8_t)(analogMode ? 1 : 0),
+                        (uint8_t)governorLevel()};
+    shardLeaderTick(input, micros(), NULL);
+  }
+  shardPoll();
+
+  unsigned long start = micros();
+  ShardStep step = shardService(*matrix, start);
+  if (step == SHARD_SHOW) {
+    matrix->show();
+    telemetryShow(micros() - start);
+  } else if (step == SHARD_RENDERED) {
+    unsigned long work = micros() - start;
+    governorFrameEnd(work, microsPerFrame);
+    telemetryFrameEnd(work, microsPerFrame);
+  }
+}
+
+
 /**
  * loop()
  *
- * Arduino main loop. Enforces a 60 FPS cap, checks serial for a mode-toggle
- * command, then draws either the analog waveform scene or the digital
- * eyes / binary rain scene.
+ * Arduino main loop. Reads the trigger link (or the mode switch) and
+ * serial commands every iteration. With the render pipeline it then presents any frame the
+ * render task has finished; otherwise it enforces the 60 FPS cap itself,
+ * renders the current scene and presents it. Each frame is timed by the
+ * profiler and its cost reported to the quality governor. While the
+ * network sink is receiving, it shows the streamed frames instead, and on
+ * a sharded wall runShard() takes the place of the local frame cycle.
+ * With the frame scheduler, the scene paths end by sleeping until the
+ * next frame is due (or a handoff or switch change wakes it).
  */
 void loop() {
-  // Read pin A1: LOW = analog mode, HIGH = digital mode
-  analogMode = (digitalRead(A1) == LOW);
+  // Digital while any sensor is; without the link, pin A1: LOW = analog, HIGH = digital
+  triggerLinkPoll();
+#if FRAME_SCHEDULER
+  // A1 is only read after its interrupt saw it move
+  if (schedulerPinChanged()) switchAnalog = (digitalRead(A1) == LOW);
+  analogMode = triggerLinkActive() ? !triggerLinkDigital() : switchAnalog;
+#else
+  if (triggerLinkActive()) {
+    analogMode = !triggerLinkDigital();
+  } else {
+    analogMode = (digitalRead(A1) == LOW);
+  }
+#endif
+
+  handleSerial();
+  telemetryPoll(analogMode);
+  replayPoll();
+
+  netsinkPoll();
+  if (netsinkActive(micros())) {
+    showSinkFrames();
+    return;
+  }
+  if (sinkShowing) leaveSink();
+  if (sharded) {
+    runShard();
+    return;
+  }
 
+#if RENDER_PIPELINE
+  pipelinePresent();
+#if FRAME_SCHEDULER
+  // The render task wakes this task when it hands off a frame
+  schedulerSleep(micros() + SCHEDULER_MAX_SLEEP_MICROS);
+#endif
+#else
+#if FRAME_SCHEDULER
+  if (!schedulerFrameDue()) {
+    schedulerSleep(schedulerNextFrame());
+    return;
+  }
+#else
   // Frame rate limiter — skip until enough time has elapsed
   if (timeSinceFrame < microsPerFrame) return;
   timeSinceFrame = 0;
+#endif
 
-  if (analogMode) {
-    drawAnalog(matrix);
-  } else {
-    drawDigital(matrix);
-  }
+  unsigned long frameStart = micros();
+  profileFrameStart();
+  renderScene(*matrix);
+  unsigned long showStart = micros();
+  matrix->show();
+  telemetryShow(micros() - showStart);
+  profileMark(PHASE_SHOW);
+  profileFrameEnd(microsPerFrame);
+  unsigned long work = micros() - frameStart;
+  governorFrameEnd(work, microsPerFrame);
+  telemetryFrameEnd(work, microsPerFrame);
+#endif
 }
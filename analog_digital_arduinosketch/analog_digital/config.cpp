@@ -0,0 +1,200 @@
+/**
+ * config.cpp
+ *
+ * Implements the boot-time settings declared in config.h. Settings are
+ * stored as one versioned blob in the "analogdigital" NVS namespace. A
+ * shorter blob of the same version comes from firmware that predates the
+ * trailing fields and is read over the defaults; a longer one or another
+ * version is ignored rather than misread.
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Preferences.h>
+#endif
+
+SketchConfig config;
+
+/**
+ * ConfigField
+ *
+ * Name, location, range and default of one setting. Drives validation,
+ * printing and the serial setter so a new setting is a single line here.
+ */
+struct ConfigField {
+  const char *key;
+  uint8_t SketchConfig::*member;
+  uint8_t minValue;
+  uint8_t maxValue;
+  uint8_t defaultValue;
+};
+
+static const ConfigField fields[] = {
+  {"panels", &SketchConfig::panelCount,     1,  16,  9},
+  {"depth",  &SketchConfig::bitDepth,       1,   6,  4},
+  {"double", &SketchConfig::doubleBuffer,   0,   1,  1},
+  {"fps",    &SketchConfig::maxFPS,         10, 120, 60},
+  {"waves",  &SketchConfig::maxWaves,       1,  12,  5},   // 12 = palette size
+  {"eyes",   &SketchConfig::maxEyes,        1,  16,  8},
+  {"digits", &SketchConfig::digitCharCount, 2,  40,  12},
+  {"scale",  &SketchConfig::charScale,      1,   8,  4},
+  {"trail",  &SketchConfig::digitTrail,     0,   6,  0},
+  {"fade",   &SketchConfig::fadeFrames,     0, 120, 30},
+  {"glow",   &SketchConfig::waveGlow,       0,   1,  1},
+  {"jitter", &SketchConfig::sinkJitter,     0,   4,  1},   // NETSINK_MAX_JITTER
+  {"universe", &SketchConfig::sinkUniverse, 0, 255,  0},
+  {"shards", &SketchConfig::shardCount,     1,   8,  1},   // SHARD_MAX_NODES
+  {"node",   &SketchConfig::shardNode,      0,   7,  0},
+  {"dither", &SketchConfig::ditherScenes,   0,   3,  0},   // DITHER_ANALOG | DITHER_DIGITAL
+  {"gamma",  &SketchConfig::gammaTenths,    10,  30, 10},
+};
+static const int FIELD_COUNT = sizeof(fields) / sizeof(fields[0]);
+
+/**
+ * findField()
+ *
+ * Looks up a setting by its serial console key.
+ *
+ * @return  The field, or NULL if key is unknown
+ */
+static const ConfigField *findField(const char *key) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (strcmp(fields[i].key, key) == 0) return &fields[i];
+  }
+  return NULL;
+}
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+/** Bump whenever existing SketchConfig fields change layout or meaning (appending is fine). */
+static const uint8_t CONFIG_VERSION = 1;
+
+static const char *NVS_NAMESPACE = "analogdigital";
+static const char *NVS_KEY = "cfg";
+
+/** What goes into NVS: the settings plus a layout version. */
+struct StoredConfig {
+  uint8_t version;
+  SketchConfig settings;
+};
+
+/**
+ * validate()
+ *
+ * Resets any out-of-range field to its default.
+ *
+ * @return  true if every field was already valid
+ */
+static bool validate(SketchConfig &cfg) {
+  bool ok = true;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    uint8_t &value = cfg.*fields[i].member;
+    if (value < fields[i].minValue || value > fields[i].maxValue) {
+      value = fields[i].defaultValue;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+#endif
+
+void configDefaults(SketchConfig &cfg) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    cfg.*fields[i].member = fields[i].defaultValue;
+  }
+}
+
+bool configLoad(SketchConfig &cfg) {
+  configDefaults(cfg);
+#if defined(ARDUINO_ARCH_ESP32)
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) return false;
+  StoredConfig stored;
+  stored.settings = cfg;  // Defaults for any fields an older blob lacks
+  size_t length = prefs.getBytesLength(NVS_KEY);
+  bool found = length > offsetof(StoredConfig, settings) && length <= sizeof(stored) &&
+               prefs.getBytes(NVS_KEY, &stored, length) == length &&
+               stored.version == CONFIG_VERSION;
+  prefs.end();
+  if (!found) return false;
+  cfg = stored.settings;
+  if (!validate(cfg)) Serial.println("config: invalid stored values reset to defaults");
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool configSave(const SketchConfig &cfg) {
+#if defined(ARDUINO_ARCH_ESP32)
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) return false;
+  StoredConfig stored;
+  stored.version = CONFIG_VERSION;
+  stored.settings = cfg;
+  bool ok = prefs.putBytes(NVS_KEY, &stored, sizeof(stored)) == sizeof(stored);
+  prefs.end();
+  return ok;
+#else
+  (void)cfg;
+  return false;
+#endif
+}
+
+void configPrint(const SketchConfig &cfg) {
+  Serial.printf("config: chain %d px wide (applied at boot)\n", PANEL_WIDTH * cfg.panelCount);
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    Serial.printf("  %-7s %3u  (%u-%u, default %u)\n", fields[i].key, cfg.*fields[i].member,
+                  fields[i].minValue, fields[i].maxValue, fields[i].defaultValue);
+  }
+}
+
+void configCommand(SketchConfig &cfg, const char *line) {
+  while (*line == ' ') line++;
+
+  if (*line == '\0') {
+    configPrint(cfg);
+    return;
+  }
+  if (strcmp(line, "defaults") == 0) {
+    configDefaults(cfg);
+    Serial.println("config: defaults restored (c save to apply)");
+    return;
+  }
+  if (strcmp(line, "save") == 0) {
+    if (!configSave(cfg)) {
+      Serial.println("config: save failed");
+      return;
+    }
+    Serial.println("config: saved, restarting");
+#if defined(ARDUINO_ARCH_ESP32)
+    Serial.flush();
+    ESP.restart();
+#endif
+    return;
+  }
+
+  // "<key> <value>"
+  char key[16];
+  int len = 0;
+  while (*line != '\0' && *line != ' ' && len < (int)sizeof(key) - 1) key[len++] = *line++;
+  key[len] = '\0';
+  const ConfigField *field = findField(key);
+  if (field == NULL) {
+    Serial.printf("config: unknown setting '%s'\n", key);
+    return;
+  }
+  char *end;
+  long value = strtol(line, &end, 10);
+  if (end == line || value < field->minValue || value > field->maxValue) {
+    Serial.printf("config: %s must be %u-%u\n", field->key, field->minValue, field->maxValue);
+    return;
+  }
+  cfg.*field->member = (uint8_t)value;
+  Serial.printf("config: %s = %ld (c save to apply)\n", field->key, value);
+}
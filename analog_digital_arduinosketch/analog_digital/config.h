@@ -0,0 +1,108 @@
+/**
+ * config.h
+ *
+ * Per-installation settings read once at boot: panel chain length, HUB75
+ * bit depth and buffering, frame rate cap, and the scene limits that size
+ * the analog/digital arrays. On the ESP32 they are kept in NVS (the
+ * Preferences library), so one firmware image can drive walls with
+ * different panel counts and each site can pick its own depth/FPS
+ * tradeoff from the serial console without reflashing.
+ *
+ * Anything missing or out of range falls back to the compiled-in defaults
+ * in config.cpp (the original nine-panel, 4-bit setup). Settings saved by
+ * an older firmware keep their values; fields added since then start at
+ * their defaults.
+ * Changes take effect on the next boot, since they resize the matrix and
+ * every scene buffer.
+ *
+ * Serial console ('c' followed by a line):
+ *   c                 print the current settings and their ranges
+ *   c <key> <value>   change a setting (not yet saved)
+ *   c defaults        restore the compiled-in defaults (not yet saved)
+ *   c save            write to NVS and restart to apply
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+
+/** Width of one HUB75 panel in pixels. */
+const int PANEL_WIDTH = 64;
+
+/**
+ * SketchConfig
+ *
+ * All runtime settings. Every field is a small unsigned value so the
+ * serial command and validation can treat them uniformly. New fields go
+ * at the end so settings stored by older firmware still line up.
+ */
+struct SketchConfig {
+  uint8_t panelCount;      // 64 px panels in the chain (logical screen height = 64 * panelCount)
+  uint8_t bitDepth;        // Protomatter bit planes per color channel, 1-6
+  uint8_t doubleBuffer;    // 1 = Protomatter double buffering (tear-free, twice the plane memory)
+  uint8_t maxFPS;          // Frame rate cap
+  uint8_t maxWaves;        // Analog wave slots
+  uint8_t maxEyes;         // Digital eye slots
+  uint8_t digitCharCount;  // Characters in the binary rain column
+  uint8_t charScale;       // GFX font scale of the rain characters (8 px base)
+  uint8_t digitTrail;      // Faded ghost copies above each rain character (0 = off)
+  uint8_t fadeFrames;      // Cross-fade length when the mode switch flips (0 = hard cut)
+  uint8_t waveGlow;        // 1 = crossing waves show their colors added together
+  uint8_t sinkJitter;      // Network sink: frame periods a streamed frame is held before showing
+  uint8_t sinkUniverse;    // Network sink: Art-Net universe of the first 170 pixels
+  uint8_t shardCount;      // Sharded wall: nodes (MatrixPortals) in the wall, 1 = not sharded
+  uint8_t shardNode;       // Sharded wall: this node's place from the top, 0 = leader
+  uint8_t ditherScenes;    // Temporal dithering: 1 = analog, 2 = digital, 3 = both, 0 = off
+  uint8_t gammaTenths;     // Gamma of dithered colors times ten (10 = linear)
+};
+
+/** Settings in use, loaded by setup() before anything is allocated. */
+extern SketchConfig config;
+
+/**
+ * configDefaults()
+ *
+ * Fills cfg with the compiled-in defaults.
+ *
+ * @param cfg  Settings to overwrite
+ */
+void configDefaults(SketchConfig &cfg);
+
+/**
+ * configLoad()
+ *
+ * Reads the stored settings (ESP32 NVS) into cfg. Missing or stale data
+ * yields the defaults; individual out-of-range fields are reset to their
+ * default value. Elsewhere this just returns the defaults.
+ *
+ * @param cfg  Settings to fill
+ * @return     true if settings were found in storage
+ */
+bool configLoad(SketchConfig &cfg);
+
+/**
+ * configSave()
+ *
+ * Writes cfg to NVS.
+ *
+ * @param cfg  Settings to store
+ * @return     false if storage is unavailable or the write failed
+ */
+bool configSave(const SketchConfig &cfg);
+
+/** Prints every setting with its allowed range over Serial. */
+void configPrint(const SketchConfig &cfg);
+
+/**
+ * configCommand()
+ *
+ * Executes one serial console command line (the text after 'c', see the
+ * file header) against cfg and prints the result.
+ *
+ * @param cfg   Settings to inspect or modify
+ * @param line  NUL-terminated command text, leading spaces allowed
+ */
+void configCommand(SketchConfig &cfg, const char *line);
+
+#endif
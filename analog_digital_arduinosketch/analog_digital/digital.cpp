@@ -10,18 +10,50 @@
  */
 
 #include "digital.h"
+#include "dither.h"
+#include "fastdraw.h"
+#include "freespace.h"
+#include "governor.h"
+#include "pool.h"
+#include "profiler.h"
+#include "scenerandom.h"
 #include <elapsedMillis.h>
+#include <stdlib.h>
 
-int8_t charOffset;
-DigitChar digitChars[digitCharCount];
+uint8_t charScale = 0;
+uint8_t digitCharCount = 0;
+int16_t charOffset;
+DigitChar *digitChars = NULL;
+
+/** Pre-rotated cells for '0' and '1' at charScale, built by initDigital(). */
+static FastSprite glyphs[2];
+
+/** Ghost copies behind each new character (the config "trail" setting). */
+static uint8_t digitTrailLength = 0;
 
 /** Background red intensity — slowly drifts between 15 and 50 each frame. */
-static uint8_t bgRedVal = 15;
+static const uint8_t BG_RED_START = 15;
+static uint8_t bgRedVal = BG_RED_START;
+
+/** Frames drawn since initDigital(), the phase of the dither cycle (dither.h). */
+static uint8_t ditherPhase = 0;
+
+/**
+ * sceneColor()
+ *
+ * RGB565 for a color chosen this frame: through the dither stage when the
+ * digital scene has it on, else plain color565().
+ *
+ * @param offset  Added to the phase so separate objects step on different frames
+ */
+static uint16_t sceneColor(uint8_t r, uint8_t g, uint8_t b, uint8_t offset) {
+  if (ditherEnabled(DITHER_DIGITAL)) return ditherColor565(r, g, b, ditherPhase + offset);
+  return Adafruit_Protomatter::color565(r, g, b);
+}
 
 /* ------------------------------------------------------------------ */
 /*  Eye system constants                                              */
 /* ------------------------------------------------------------------ */
-static const int MAX_EYES = 8;           // Max concurrent eyes
 static const int EYE_HALF_HEIGHT = 25;   // Vertical half-span of each eye (pixels)
 static const int EYE_MIN_SPACING = 55;   // Minimum Y distance between eyes
 static const int EYE_OPEN_SPEED = 2;     // Pixels per frame for open/close animation
@@ -43,82 +75,112 @@ enum EyeState {
 };
 
 /**
- * Eye
+ * EyePool
  *
- * Holds all state for a single animated eye: position, animation phase,
- * and iris tracking. The eye shape is a diamond (two V-lines meeting at
- * the top and bottom tips) whose horizontal half-width is controlled by
+ * Per-eye state, one array per field indexed by slot (see pool.h): the
+ * animation phase and iris tracking. Every eye is centered horizontally
+ * (eyeCenterX), is EYE_HALF_HEIGHT tall and opens to eyeFullOpen, so
+ * only its Y position is stored. The eye shape is a diamond (two V-lines
+ * meeting at the top and bottom tips) whose horizontal half-width is
  * openAmount.
  */
-struct Eye {
-  int x, y;                              // Center position on screen
-  EyeState state;                        // Current animation state
-  int openAmount;                        // Current horizontal half-width (0 = closed, maxOpen = fully open)
-  int maxOpen;                           // Maximum half-width when fully open
-  int halfHeight;                        // Vertical half-span (top tip to center)
-  int timer;                             // Countdown timer for current state (frames)
-  int blinksLeft;                        // Remaining blinks before the eye closes for good
-  int irisX, irisY;                      // Current iris offset from eye center
-  int irisTargetX, irisTargetY;          // Target iris offset (iris drifts toward this)
-  int lookTimer;                         // Frames until a new random look target is chosen
+struct EyePool {
+  int16_t *y;            // Center Y position
+  int16_t *timer;        // Countdown timer for current state (frames)
+  uint8_t *state;        // Current animation state (EyeState)
+  int8_t *openAmount;    // Current horizontal half-width (0 = closed, eyeFullOpen = fully open)
+  uint8_t *blinksLeft;   // Remaining blinks before the eye closes for good
+  int8_t *irisX;         // Current iris offset from eye center
+  int8_t *irisY;
+  int8_t *irisTargetX;   // Target iris offset (iris drifts toward this)
+  int8_t *irisTargetY;
+  int8_t *lookTimer;     // Frames until a new random look target is chosen
+  ActiveList active;     // Eyes on screen
 };
 
-static Eye eyes[MAX_EYES];
+static EyePool eyes = {};
+static void *eyesBlock = NULL;           // maxEyes slots, allocated by initDigital()
+static int maxEyes = 0;
+static int eyeCenterX = 0;
+static int eyeFullOpen = 0;
+static FreeSpace eyeSpace = {};          // Scratch for spawnEye(), maxEyes intervals from eyesBlock
 
 /* ------------------------------------------------------------------ */
 /*  Ripple system                                                     */
 /*  Black ring effects that expand outward from an eye when it blinks */
 /* ------------------------------------------------------------------ */
 
-/** A single expanding ring drawn in black to "carve" through the scene. */
-struct Ripple {
-  int cx, cy;    // Center of the ring (set to the blinking eye's position)
-  int radius;    // Current ring radius in pixels
-  int speed;     // Expansion rate (pixels per frame)
-  bool active;   // false once the ring has expanded past the screen
+// Drawing cost no longer grows with radius (fastCircle only visits the
+// visible caps), so a full pool is cheap
+static const int MAX_RIPPLES = 24;
+static const int RIPPLE_RING_WIDTH = 2;  // Concentric circles per ring
+
+/**
+ * RipplePool
+ *
+ * Expanding rings drawn in black to "carve" through the scene, packed
+ * densely: entries 0..count-1 are live, and a finished ring is replaced
+ * by the last one. All rings are the same color, so their order does not
+ * matter.
+ */
+struct RipplePool {
+  int16_t cx[MAX_RIPPLES];     // Center of the ring (set to the blinking eye's position)
+  int16_t cy[MAX_RIPPLES];
+  int16_t radius[MAX_RIPPLES]; // Current ring radius in pixels
+  uint8_t speed[MAX_RIPPLES];  // Expansion rate (pixels per frame)
+  int count;
 };
-static const int MAX_RIPPLES = 12;
-static Ripple ripples[MAX_RIPPLES];
+static RipplePool ripples = {};
 
 /**
  * spawnRipples()
  *
- * Creates 1-3 new ripple rings centered on the given eye. Called each time
- * an eye blinks. Each ripple starts at the eye's halfHeight radius (just
- * outside the lid) and expands outward at a random speed.
- *
- * @param eye  The eye that just blinked
- */
-static void spawnRipples(Eye &eye) {
-  int count = random(1, 4);
-  for (int c = 0; c < count; c++) {
-    for (int i = 0; i < MAX_RIPPLES; i++) {
-      if (!ripples[i].active) {
-        ripples[i].cx = eye.x;
-        ripples[i].cy = eye.y;
-        ripples[i].radius = eye.halfHeight;
-        ripples[i].speed = random(1, 4);
-        ripples[i].active = true;
-        break;
-      }
-    }
+ * Creates 1-3 new ripple rings (just one while the governor is shedding
+ * optional spawns) centered on the given eye. Called each time an eye
+ * blinks. Each ripple starts at the eye's half height (just outside the
+ * lid) and expands outward at a random speed.
+ *
+ * @param eye  Slot of the eye that just blinked
+ */
+static void spawnRipples(int eye) {
+  int count = sceneRandom(1, 4);
+  if (governorSheds(QUALITY_NO_EXTRA_SPAWNS)) count = 1;
+  for (int c = 0; c < count && ripples.count < MAX_RIPPLES; c++) {
+    int r = ripples.count++;
+    ripples.cx[r] = eyeCenterX;
+    ripples.cy[r] = eyes.y[eye];
+    ripples.radius[r] = EYE_HALF_HEIGHT;
+    ripples.speed[r] = sceneRandom(1, 4);
   }
 }
 
 /**
  * updateRipples()
  *
- * Advances all active ripples outward by their speed. Deactivates any
- * ripple whose radius exceeds the largest screen dimension.
+ * Advances all active ripples outward by their speed. Retires a ripple
+ * once even its innermost circle encloses the whole screen: every pixel
+ * of a circle of radius r lies more than r - 1 from its center, so no
+ * part of the ring can land on screen once radius - RIPPLE_RING_WIDTH
+ * reaches the distance to the farthest corner.
  */
-static void updateRipples(Adafruit_Protomatter &matrix) {
-  int maxDim = max(matrix.width(), matrix.height());
-  for (int i = 0; i < MAX_RIPPLES; i++) {
-    if (ripples[i].active) {
-      ripples[i].radius += ripples[i].speed;
-      if (ripples[i].radius > maxDim) {
-        ripples[i].active = false;
-      }
+static void updateRipples(GFXcanvas16 &matrix) {
+  int32_t farX = matrix.width() - 1;
+  int32_t farY = matrix.height() - 1;
+  int r = 0;
+  while (r < ripples.count) {
+    ripples.radius[r] += ripples.speed[r];
+    int32_t dx = max((int32_t)ripples.cx[r], farX - ripples.cx[r]);
+    int32_t dy = max((int32_t)ripples.cy[r], farY - ripples.cy[r]);
+    int32_t inner = ripples.radius[r] - RIPPLE_RING_WIDTH;
+    if (inner > 0 && inner * inner >= dx * dx + dy * dy) {
+      // Move the last ring into this entry and look at it next
+      int last = --ripples.count;
+      ripples.cx[r] = ripples.cx[last];
+      ripples.cy[r] = ripples.cy[last];
+      ripples.radius[r] = ripples.radius[last];
+      ripples.speed[r] = ripples.speed[last];
+    } else {
+      r++;
     }
   }
 }
@@ -126,17 +188,16 @@ static void updateRipples(Adafruit_Protomatter &matrix) {
 /**
  * drawRipples()
  *
- * Renders all active ripples as two concentric black circles (the double
- * ring makes them more visible against the busy background).
+ * Renders all active ripples as RIPPLE_RING_WIDTH concentric black
+ * circles (the double ring makes them more visible against the busy
+ * background), or one when the governor sheds to QUALITY_SINGLE_RING.
+ * The circles are the same pixels drawCircle() would produce, but only
+ * the arcs crossing the strip are computed.
  */
-static void drawRipples(Adafruit_Protomatter &matrix) {
-  for (int i = 0; i < MAX_RIPPLES; i++) {
-    if (ripples[i].active) {
-      matrix.drawCircle(ripples[i].cx, ripples[i].cy, ripples[i].radius, 0);
-      if (ripples[i].radius > 0) {
-        matrix.drawCircle(ripples[i].cx, ripples[i].cy, ripples[i].radius - 1, 0);
-      }
-    }
+static void drawRipples(GFXcanvas16 &matrix) {
+  int rings = governorSheds(QUALITY_SINGLE_RING) ? 1 : RIPPLE_RING_WIDTH;
+  for (int r = 0; r < ripples.count; r++) {
+    fastRing(matrix, ripples.cx[r], ripples.cy[r], ripples.radius[r], rings, 0);
   }
 }
 
@@ -152,7 +213,7 @@ static const int LASH_LENGTH = 5;   // Length of each lash line in pixels
  * Returns a random ASCII '0' or '1' for the scrolling binary rain.
  */
 static char oneOrZero() {
-  uint8_t num = random(2);
+  uint8_t num = sceneRandom(2);
   char character = '0' + num;
   return character;
 }
@@ -171,76 +232,473 @@ DigitChar initDigit(int yOffset, int color) {
   digit.yOffset = yOffset;
   digit.character = oneOrZero();
   digit.color = color;
+  digit.trail = digitTrailLength;
   return digit;
 }
 
 /**
- * drawAlmondEye()
+ * blend565()
  *
- * Renders a single eye onto the matrix. The drawing order is:
- *   1. Black diamond fill (the eye interior)
- *   2. Lid outline (four lines forming the diamond border)
- *   3. Eyelashes (fanning outward from evenly-spaced points on each lid)
- *   4. Iris and pupil (filled circles at the iris offset position)
+ * Mixes two RGB565 colors per channel; weight is a's share out of 256.
+ */
+static uint16_t blend565(uint16_t a, uint16_t b, uint16_t weight) {
+  uint16_t inv = 256 - weight;
+  uint16_t r = (((a >> 11) & 0x1F) * weight + ((b >> 11) & 0x1F) * inv) >> 8;
+  uint16_t g = (((a >> 5) & 0x3F) * weight + ((b >> 5) & 0x3F) * inv) >> 8;
+  uint16_t bl = ((a & 0x1F) * weight + (b & 0x1F) * inv) >> 8;
+  return (r << 11) | (g << 5) | bl;
+}
+
+/**
+ * drawDigitTrail()
  *
- * The diamond shape is produced by a linear scanline fill: for each row
- * offset dy from the center, halfWidth = open * (hh - |dy|) / hh. This
- * gives straight edges tapering to points at dy = +/-hh.
+ * Draws a character's faded trail: digit.trail ghost copies of its glyph
+ * stacked above it every 2 * charScale rows, fading from the character's
+ * color toward the background. Only the ghosts' lit pixels are drawn, and
+ * the opaque character cells drawn afterwards cover all but the part the
+ * trail sweeps out above each one.
  *
- * @param eye     The eye to draw
- * @param matrix  Reference to the LED matrix
+ * @param digit   Character whose trail to draw
+ * @param bg      Current background color (what the trail fades into)
+ * @param matrix  Canvas to draw into
  */
-static void drawAlmondEye(Eye &eye, Adafruit_Protomatter &matrix) {
-  int cx = eye.x;
-  int cy = eye.y;
-  int hh = eye.halfHeight;
-  int open = eye.openAmount;
-  uint16_t lidColor = matrix.color565(180, 180, 140);
+static void drawDigitTrail(const DigitChar &digit, uint16_t bg, GFXcanvas16 &matrix) {
+  const FastSprite &glyph = glyphs[digit.character - '0'];
+  int spacing = 2 * charScale;
+  // Farthest (faintest) ghost first so nearer ones draw over it
+  for (int k = digit.trail; k >= 1; k--) {
+    uint16_t weight = 256 * (digit.trail + 1 - k) / (digit.trail + 1);
+    fastBlitSpriteMask(matrix, glyph, charXPos, digit.yOffset - k * spacing, blend565(digit.color, bg, weight));
+  }
+}
 
-  if (open <= 0) {
-    // Fully closed: draw a thin vertical slit in lid color
-    matrix.drawFastVLine(cx, cy - hh, hh * 2 + 1, lidColor);
-    return;
+/* ------------------------------------------------------------------ */
+/*  Rain strip (DIGITAL_RAIN_STRIP)                                   */
+/*  Between wraps the whole column moves down 2 px a frame as one     */
+/*  piece, so it is kept as shade levels in one ring per logical      */
+/*  column of the glyph cells, in framebuffer order. A frame moves    */
+/*  the ring start, rasterizes the newly exposed rows and resolves   */
+/*  each ring through a palette of this frame's colors.               */
+/* ------------------------------------------------------------------ */
+
+#if DIGITAL_RAIN_STRIP
+static const int RAIN_MAX_TRAIL = 6;     // The config "trail" maximum
+
+static uint8_t *rainStrip = NULL;        // rainColumns rings of rainHeight levels
+static int16_t rainHeight = 0;           // Canvas height the strip was sized for
+static int16_t rainColumns = 0;          // Glyph columns that fit on the canvas
+static int16_t rainStart = 0;            // Ring entry at framebuffer address 0
+static bool rainValid = false;           // False until fully rasterized
+
+/** Rows to rasterize again this frame, kept as a top and a bottom band. */
+struct RainDirty {
+  int16_t first[2];
+  int16_t last[2];                       // Exclusive; first >= last = empty
+};
+
+/**
+ * rainStamp()
+ *
+ * Rasterizes rows y0..y1-1 of one glyph with its top at top into the
+ * strip: lit pixels become level, and with opaque the rest of the cell
+ * becomes background (a fastBlitSprite() cell rather than a
+ * fastBlitSpriteMask() ghost).
+ */
+static void rainStamp(const FastSprite &glyph, int top, uint8_t level, bool opaque, int y0, int y1) {
+  int from = top > y0 ? top : y0;
+  int to = top + glyph.height < y1 ? top + glyph.height : y1;
+  for (int col = 0; col < rainColumns; col++) {
+    uint8_t *ring = rainStrip + (int32_t)col * rainHeight;
+    const uint8_t *m = glyph.mask + (int32_t)col * glyph.height;
+    for (int y = from; y < to; y++) {
+      uint8_t lit = m[top + glyph.height - 1 - y];
+      if (lit || opaque) ring[(rainStart + rainHeight - 1 - y) % rainHeight] = lit ? level : 0;
+    }
   }
+}
 
-  // --- 1. Scanline fill the diamond interior with black ---
-  // For each row, the half-width shrinks linearly from 'open' at center
-  // (dy=0) to 0 at the tips (dy=+/-hh), producing straight diamond edges.
-  for (int dy = -hh; dy <= hh; dy++) {
+/**
+ * rainRasterize()
+ *
+ * Redraws rows y0..y1-1 of the column from the characters' current
+ * positions, in the reference order: every trail (farthest ghost first),
+ * then every opaque cell. Level 0 is the background, 1..trail the ghosts
+ * from faintest, trail + 1 the glyph color.
+ */
+static void rainRasterize(int y0, int y1) {
+  if (y0 < 0) y0 = 0;
+  if (y1 > rainHeight) y1 = rainHeight;
+  if (y0 >= y1) return;
+  for (int col = 0; col < rainColumns; col++) {
+    uint8_t *ring = rainStrip + (int32_t)col * rainHeight;
+    for (int y = y0; y < y1; y++) ring[(rainStart + rainHeight - 1 - y) % rainHeight] = 0;
+  }
+  int spacing = 2 * charScale;
+  for (int i = 0; i < digitCharCount; i++) {
+    const DigitChar &digit = digitChars[i];
+    if (digit.trail == 0 || digit.yOffset <= charOffset) continue;
+    for (int k = digit.trail; k >= 1; k--) {
+      rainStamp(glyphs[digit.character - '0'], digit.yOffset - k * spacing, digit.trail + 1 - k, false, y0, y1);
+    }
+  }
+  for (int i = 0; i < digitCharCount; i++) {
+    const DigitChar &digit = digitChars[i];
+    if (digit.yOffset <= charOffset) continue;
+    rainStamp(glyphs[digit.character - '0'], digit.yOffset, digit.trail + 1, true, y0, y1);
+  }
+}
+
+/**
+ * rainTrack()
+ *
+ * Called for each character as it advances from before to after. A
+ * character that only moved down 2 px is already right in the scrolled
+ * strip; one that wrapped or first became visible leaves its old
+ * (scrolled) footprint and its new one to rasterize again.
+ */
+static void rainTrack(RainDirty &dirty, int before, int after) {
+  bool wasDrawn = before > charOffset;
+  bool isDrawn = after > charOffset;
+  if (wasDrawn == isDrawn && (!isDrawn || after == before + 2)) return;
+  int above = digitTrailLength * 2 * charScale;
+  int footprints[2] = {before + 2, after};
+  bool drawn[2] = {wasDrawn, isDrawn};
+  for (int f = 0; f < 2; f++) {
+    if (!drawn[f]) continue;
+    int first = footprints[f] - above;
+    int last = footprints[f] + glyphs[0].height;
+    int band = first + last < rainHeight ? 0 : 1;
+    if (first < dirty.first[band]) dirty.first[band] = first;
+    if (last > dirty.last[band]) dirty.last[band] = last;
+  }
+}
+
+/**
+ * rainResolve()
+ *
+ * Brings the strip up to this frame (scroll 2 rows and rasterize what
+ * changed, or everything after a frame drawn without it) and writes the
+ * canvas: background columns either side, the strip in between.
+ */
+static void rainResolve(GFXcanvas16 &matrix, const RainDirty &dirty, uint16_t bg) {
+  if (!rainValid) {
+    rainStart = 0;
+    rainRasterize(0, rainHeight);
+    rainValid = true;
+  } else {
+    // Content at address a moves to a - 2, so rows 0-1 take the old bottom entries
+    rainStart = (rainStart + 2) % rainHeight;
+    rainRasterize(0, 2);
+    for (int band = 0; band < 2; band++) rainRasterize(dirty.first[band], dirty.last[band]);
+  }
+
+  // Every character is created white, so one palette serves the column
+  uint16_t palette[RAIN_MAX_TRAIL + 2];
+  uint16_t color = digitChars[0].color;
+  palette[0] = bg;
+  for (int level = 1; level <= digitTrailLength; level++) {
+    palette[level] = blend565(color, bg, 256 * level / (digitTrailLength + 1));
+  }
+  palette[digitTrailLength + 1] = color;
+
+  fastFillRect(matrix, 0, 0, charXPos, rainHeight, bg);
+  for (int col = 0; col < rainColumns; col++) {
+    fastBlitRing(matrix, charXPos + col, rainStrip + (int32_t)col * rainHeight, rainStart, palette);
+  }
+  fastFillRect(matrix, charXPos + rainColumns, 0, matrix.width() - charXPos - rainColumns, rainHeight, bg);
+}
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Eye geometry templates                                            */
+/*  An eye's shape depends only on openAmount and halfHeight, so the  */
+/*  pixels of every width are rasterized once by initDigital() and    */
+/*  stored as vertical runs relative to the eye center. Vertical runs */
+/*  are contiguous in the rotated framebuffer, so drawing an eye is a */
+/*  few dozen fastVLine() calls.                                      */
+/* ------------------------------------------------------------------ */
+
+/** Vertical run of pixels at (cx + dx, cy + dy .. cy + dy + length - 1). */
+struct EyeRun {
+  int8_t dx;
+  int8_t dy;
+  uint8_t length;
+};
+
+/** All pixel runs of one eye width, in drawing order. */
+struct EyeTemplate {
+  EyeRun *runs;         // fillRuns, then lidRuns, then lashRuns
+  uint8_t fillRuns;     // Black diamond interior, one run per column
+  uint8_t lidRuns;      // Lid outline
+  uint8_t lashRuns;     // Eyelashes (0 when the eye is too narrow for them)
+};
+
+/** Filled circle as one centered run per column: rows -half[|dx|]..half[|dx|]. */
+struct DiscTemplate {
+  int8_t *half;         // radius + 1 entries, -1 = column not covered
+};
+
+static EyeTemplate *eyeTemplates = NULL;  // Indexed by openAmount, 1..templateMaxOpen
+static DiscTemplate *discTemplates = NULL;  // Indexed by radius, 0..templateMaxOpen / 3
+static int templateMaxOpen = 0;
+
+/**
+ * traceLids()
+ *
+ * The lid outline: four lines connecting top tip -> left widest ->
+ * bottom tip -> right widest.
+ */
+static void traceLids(GFXcanvas16 &canvas, int cx, int cy, int hh, int open, uint16_t color) {
+  canvas.drawLine(cx, cy - hh, cx - open, cy, color);   // Top to left
+  canvas.drawLine(cx - open, cy, cx, cy + hh, color);    // Left to bottom
+  canvas.drawLine(cx, cy - hh, cx + open, cy, color);    // Top to right
+  canvas.drawLine(cx + open, cy, cx, cy + hh, color);    // Right to bottom
+}
+
+/**
+ * traceLashes()
+ *
+ * LASH_COUNT lashes are evenly spaced along each lid from dy=-(hh-4) to
+ * dy=+(hh-4), avoiding the very tips. Each lash radiates outward from the
+ * lid edge; the vertical 'fan' component is proportional to the lash's
+ * dy, so top lashes angle upward, middle ones go straight out, and bottom
+ * ones angle downward.
+ */
+static void traceLashes(GFXcanvas16 &canvas, int cx, int cy, int hh, int open, uint16_t color) {
+  for (int i = 0; i < LASH_COUNT; i++) {
+    // Evenly distribute lash positions from -(hh-4) to +(hh-4)
+    int dy = -(hh - 4) + i * (2 * (hh - 4)) / (LASH_COUNT - 1);
     int halfWidth = (int)((long)open * (hh - abs(dy)) / hh);
-    if (halfWidth > 0) {
-      matrix.drawFastHLine(cx - halfWidth, cy + dy, halfWidth * 2 + 1, 0);
+    // Fan angle: lashes near top fan upward, near bottom fan downward
+    int fan = dy * LASH_LENGTH / hh;
+    // Left lid lash: extends leftward from the left edge
+    canvas.drawLine(cx - halfWidth, cy + dy,
+                    cx - halfWidth - LASH_LENGTH, cy + dy + fan, color);
+    // Right lid lash: extends rightward from the right edge
+    canvas.drawLine(cx + halfWidth, cy + dy,
+                    cx + halfWidth + LASH_LENGTH, cy + dy + fan, color);
+  }
+}
+
+/**
+ * collectRuns()
+ *
+ * Converts the nonzero pixels of a scratch canvas into vertical runs
+ * relative to (cx, cy), appending them at runs[count]. Clears the canvas
+ * afterwards so it can be reused.
+ *
+ * @return  The new run count, or -1 if the runs did not fit in capacity
+ */
+static int collectRuns(GFXcanvas16 &scratch, int cx, int cy, EyeRun *runs, int count, int capacity) {
+  uint16_t *pixels = scratch.getBuffer();
+  int w = scratch.width();
+  int h = scratch.height();
+  for (int x = 0; x < w; x++) {
+    int y = 0;
+    while (y < h) {
+      if (pixels[x + y * w] == 0) {
+        y++;
+        continue;
+      }
+      int top = y;
+      while (y < h && pixels[x + y * w] != 0) y++;
+      if (count >= capacity) return -1;
+      runs[count].dx = x - cx;
+      runs[count].dy = top - cy;
+      runs[count].length = y - top;
+      count++;
+    }
+  }
+  scratch.fillScreen(0);
+  return count;
+}
+
+/**
+ * buildEyeTemplate()
+ *
+ * Rasterizes one eye width into a template. The diamond interior is
+ * defined row by row, halfWidth = open * (hh - |dy|) / hh, which gives
+ * straight edges tapering to points at dy = +/-hh; since halfWidth never
+ * grows away from the center, each column of it is a single run. Lids and
+ * lashes are drawn with GFX drawLine() into a scratch canvas and read
+ * back, so they are the exact Bresenham pixels.
+ */
+static bool buildEyeTemplate(EyeTemplate &t, GFXcanvas16 &scratch, int hh, int open) {
+  int cx = scratch.width() / 2;
+  int cy = scratch.height() / 2;
+  int capacity = (2 * open + 1) + scratch.width() * 8;  // Fill columns + generous line runs
+  EyeRun *runs = (EyeRun *)malloc(capacity * sizeof(EyeRun));
+  if (runs == NULL) return false;
+
+  // Fill: column dx spans the rows whose halfWidth reaches |dx|
+  int count = 0;
+  for (int dx = -open; dx <= open; dx++) {
+    int extent = -1;
+    for (int dy = 0; dy <= hh; dy++) {
+      int halfWidth = (int)((long)open * (hh - dy) / hh);
+      if (halfWidth <= 0 || halfWidth < abs(dx)) break;
+      extent = dy;
     }
+    if (extent < 0) continue;
+    runs[count].dx = dx;
+    runs[count].dy = -extent;
+    runs[count].length = 2 * extent + 1;
+    count++;
   }
+  t.fillRuns = count;
 
-  // --- 2. Lid outline ---
-  // Four lines connecting: top tip -> left widest -> bottom tip -> right widest
-  matrix.drawLine(cx, cy - hh, cx - open, cy, lidColor);   // Top to left
-  matrix.drawLine(cx - open, cy, cx, cy + hh, lidColor);    // Left to bottom
-  matrix.drawLine(cx, cy - hh, cx + open, cy, lidColor);    // Top to right
-  matrix.drawLine(cx + open, cy, cx, cy + hh, lidColor);    // Right to bottom
+  traceLids(scratch, cx, cy, hh, open, 1);
+  int lidEnd = collectRuns(scratch, cx, cy, runs, count, capacity);
+  if (lidEnd < 0) {
+    free(runs);
+    return false;
+  }
+  t.lidRuns = lidEnd - count;
 
-  // --- 3. Eyelashes (only when eye is open enough to show the iris) ---
-  // LASH_COUNT lashes are evenly spaced along each lid from dy=-(hh-4)
-  // to dy=+(hh-4), avoiding the very tips. Each lash radiates outward
-  // from the lid edge; the vertical 'fan' component is proportional to
-  // the lash's dy, so top lashes angle upward, middle ones go straight
-  // out, and bottom ones angle downward.
+  int lashEnd = lidEnd;
   if (open > 3) {
-    for (int i = 0; i < LASH_COUNT; i++) {
-      // Evenly distribute lash positions from -(hh-4) to +(hh-4)
-      int dy = -(hh - 4) + i * (2 * (hh - 4)) / (LASH_COUNT - 1);
-      int halfWidth = (int)((long)open * (hh - abs(dy)) / hh);
-      // Fan angle: lashes near top fan upward, near bottom fan downward
-      int fan = dy * LASH_LENGTH / hh;
-      // Left lid lash: extends leftward from the left edge
-      matrix.drawLine(cx - halfWidth, cy + dy,
-                      cx - halfWidth - LASH_LENGTH, cy + dy + fan, lidColor);
-      // Right lid lash: extends rightward from the right edge
-      matrix.drawLine(cx + halfWidth, cy + dy,
-                      cx + halfWidth + LASH_LENGTH, cy + dy + fan, lidColor);
+    traceLashes(scratch, cx, cy, hh, open, 1);
+    lashEnd = collectRuns(scratch, cx, cy, runs, lidEnd, capacity);
+    if (lashEnd < 0) {
+      free(runs);
+      return false;
+    }
+  }
+  t.lashRuns = lashEnd - lidEnd;
+  t.runs = runs;
+  return true;
+}
+
+/**
+ * buildDiscTemplate()
+ *
+ * Rasterizes GFX fillCircle() of the given radius and records each
+ * column's (centered) vertical extent.
+ */
+static bool buildDiscTemplate(DiscTemplate &d, GFXcanvas16 &scratch, int radius) {
+  d.half = (int8_t *)malloc(radius + 1);
+  if (d.half == NULL) return false;
+  int cx = scratch.width() / 2;
+  int cy = scratch.height() / 2;
+  scratch.fillCircle(cx, cy, radius, 1);
+  uint16_t *pixels = scratch.getBuffer();
+  int w = scratch.width();
+  for (int dx = 0; dx <= radius; dx++) {
+    int top = cy;
+    while (top > 0 && pixels[cx + dx + (top - 1) * w] != 0) top--;
+    d.half[dx] = (pixels[cx + dx + cy * w] != 0) ? cy - top : -1;
+  }
+  scratch.fillScreen(0);
+  return true;
+}
+
+/**
+ * freeEyeTemplates()
+ *
+ * Releases every eye and disc template.
+ */
+static void freeEyeTemplates() {
+  if (eyeTemplates != NULL) {
+    for (int open = 1; open <= templateMaxOpen; open++) free(eyeTemplates[open].runs);
+    free(eyeTemplates);
+  }
+  if (discTemplates != NULL) {
+    for (int r = 0; r <= templateMaxOpen / 3; r++) free(discTemplates[r].half);
+    free(discTemplates);
+  }
+  eyeTemplates = NULL;
+  discTemplates = NULL;
+  templateMaxOpen = 0;
+}
+
+/**
+ * buildEyeTemplates()
+ *
+ * Builds templates for every eye width 1..maxOpen at the given half
+ * height, and iris/pupil discs for every radius an eye of those widths
+ * uses.
+ */
+static bool buildEyeTemplates(int hh, int maxOpen) {
+  freeEyeTemplates();
+  int margin = LASH_LENGTH + 2;
+  GFXcanvas16 scratch(2 * (maxOpen + margin) + 1, 2 * (hh + margin) + 1);
+  eyeTemplates = (EyeTemplate *)calloc(maxOpen + 1, sizeof(EyeTemplate));
+  discTemplates = (DiscTemplate *)calloc(maxOpen / 3 + 1, sizeof(DiscTemplate));
+  if (scratch.getBuffer() == NULL || eyeTemplates == NULL || discTemplates == NULL) {
+    freeEyeTemplates();
+    return false;
+  }
+  templateMaxOpen = maxOpen;
+  for (int open = 1; open <= maxOpen; open++) {
+    if (!buildEyeTemplate(eyeTemplates[open], scratch, hh, open)) {
+      freeEyeTemplates();
+      return false;
+    }
+  }
+  for (int r = 0; r <= maxOpen / 3; r++) {
+    if (!buildDiscTemplate(discTemplates[r], scratch, r)) {
+      freeEyeTemplates();
+      return false;
     }
   }
+  return true;
+}
+
+/**
+ * drawRuns()
+ *
+ * Draws count template runs offset to (cx, cy).
+ */
+static void drawRuns(GFXcanvas16 &matrix, const EyeRun *runs, int count, int cx, int cy, uint16_t color) {
+  for (int i = 0; i < count; i++) {
+    fastVLine(matrix, cx + runs[i].dx, cy + runs[i].dy, runs[i].length, color);
+  }
+}
+
+/**
+ * drawDisc()
+ *
+ * Draws a filled circle from its template, one column run at a time.
+ */
+static void drawDisc(GFXcanvas16 &matrix, const DiscTemplate &d, int radius, int cx, int cy, uint16_t color) {
+  for (int dx = -radius; dx <= radius; dx++) {
+    int half = d.half[abs(dx)];
+    if (half >= 0) fastVLine(matrix, cx + dx, cy - half, 2 * half + 1, color);
+  }
+}
+
+/**
+ * drawAlmondEye()
+ *
+ * Renders a single eye onto the matrix from the template for its current
+ * width. The drawing order is:
+ *   1. Black diamond fill (the eye interior)
+ *   2. Lid outline (four lines forming the diamond border)
+ *   3. Eyelashes (only when the eye is open enough to show the iris, and
+ *      the governor isn't shedding them)
+ *   4. Iris and pupil (filled circles at the iris offset position)
+ *
+ * @param eye     Slot of the eye to draw
+ * @param matrix  Reference to the LED matrix
+ */
+static void drawAlmondEye(int eye, GFXcanvas16 &matrix) {
+  int cx = eyeCenterX;
+  int cy = eyes.y[eye];
+  int hh = EYE_HALF_HEIGHT;
+  int open = min((int)eyes.openAmount[eye], templateMaxOpen);
+  uint16_t lidColor = sceneColor(180, 180, 140, eye);
+
+  if (open <= 0) {
+    // Fully closed: draw a thin vertical slit in lid color
+    fastVLine(matrix, cx, cy - hh, hh * 2 + 1, lidColor);
+    return;
+  }
+
+  // --- 1-3. Interior, lids, lashes ---
+  const EyeTemplate &t = eyeTemplates[open];
+  drawRuns(matrix, t.runs, t.fillRuns, cx, cy, 0);
+  int lineRuns = t.lidRuns + (governorSheds(QUALITY_NO_LASHES) ? 0 : t.lashRuns);
+  drawRuns(matrix, t.runs + t.fillRuns, lineRuns, cx, cy, lidColor);
 
   // --- 4. Iris and pupil ---
   // Drawn last so they appear on top of the black fill. The iris is a
@@ -249,12 +707,12 @@ static void drawAlmondEye(Eye &eye, Adafruit_Protomatter &matrix) {
   if (open > 3) {
     int irisR = open / 3;    // Iris radius scales with eye width
     int pupilR = open / 6;   // Pupil is half the iris size
-    int ix = cx + eye.irisX;
-    int iy = cy + eye.irisY;
-    uint16_t irisColor = matrix.color565(180, 60, 60);
-    matrix.fillCircle(ix, iy, irisR, irisColor);
-    uint16_t pupilColor = matrix.color565(60, 10, 10);
-    matrix.fillCircle(ix, iy, pupilR, pupilColor);
+    int ix = cx + eyes.irisX[eye];
+    int iy = cy + eyes.irisY[eye];
+    uint16_t irisColor = sceneColor(180, 60, 60, eye);
+    drawDisc(matrix, discTemplates[irisR], irisR, ix, iy, irisColor);
+    uint16_t pupilColor = sceneColor(60, 10, 10, eye);
+    drawDisc(matrix, discTemplates[pupilR], pupilR, ix, iy, pupilColor);
   }
 }
 
@@ -266,23 +724,23 @@ static void drawAlmondEye(Eye &eye, Adafruit_Protomatter &matrix) {
  * Horizontal range is wider (openAmount/3) than vertical (halfHeight/5)
  * to keep the iris within the diamond shape.
  *
- * @param eye  The eye whose iris to update
+ * @param eye  Slot of the eye whose iris to update
  */
-static void updateIris(Eye &eye) {
-  if (eye.openAmount <= 3) return;
-  eye.lookTimer--;
-  if (eye.lookTimer <= 0) {
-    int maxH = eye.openAmount / 3;
-    int maxV = eye.halfHeight / 5;
-    eye.irisTargetX = random(-maxH, maxH + 1);
-    eye.irisTargetY = random(-maxV, maxV + 1);
-    eye.lookTimer = random(30, 120);
+static void updateIris(int eye) {
+  int open = eyes.openAmount[eye];
+  if (open <= 3) return;
+  if (--eyes.lookTimer[eye] <= 0) {
+    int maxH = open / 3;
+    int maxV = EYE_HALF_HEIGHT / 5;
+    eyes.irisTargetX[eye] = sceneRandom(-maxH, maxH + 1);
+    eyes.irisTargetY[eye] = sceneRandom(-maxV, maxV + 1);
+    eyes.lookTimer[eye] = sceneRandom(30, 120);
   }
   // Drift toward target 1 pixel per frame on each axis
-  if (eye.irisX < eye.irisTargetX) eye.irisX++;
-  else if (eye.irisX > eye.irisTargetX) eye.irisX--;
-  if (eye.irisY < eye.irisTargetY) eye.irisY++;
-  else if (eye.irisY > eye.irisTargetY) eye.irisY--;
+  if (eyes.irisX[eye] < eyes.irisTargetX[eye]) eyes.irisX[eye]++;
+  else if (eyes.irisX[eye] > eyes.irisTargetX[eye]) eyes.irisX[eye]--;
+  if (eyes.irisY[eye] < eyes.irisTargetY[eye]) eyes.irisY[eye]++;
+  else if (eyes.irisY[eye] > eyes.irisTargetY[eye]) eyes.irisY[eye]--;
 }
 
 /**
@@ -295,53 +753,54 @@ static void updateIris(Eye &eye) {
  *   - BLINKING_CLOSE / CLOSING: openAmount decreases by EYE_OPEN_SPEED
  *   - OPEN: counts down a random timer, then either blinks or closes
  *
- * @param eye  The eye to update
+ * @param eye  Slot of the eye to update
  */
-static void updateEye(Eye &eye) {
-  switch (eye.state) {
+static void updateEye(int eye) {
+  int8_t &open = eyes.openAmount[eye];
+  uint8_t &state = eyes.state[eye];
+  switch (state) {
     case EYE_OPENING:
-      eye.openAmount += EYE_OPEN_SPEED;
-      if (eye.openAmount >= eye.maxOpen) {
-        eye.openAmount = eye.maxOpen;
-        eye.state = EYE_OPEN;
-        eye.timer = random(60, 180); // Hold open for 1-3 seconds at 60fps
+      open += EYE_OPEN_SPEED;
+      if (open >= eyeFullOpen) {
+        open = eyeFullOpen;
+        state = EYE_OPEN;
+        eyes.timer[eye] = sceneRandom(60, 180); // Hold open for 1-3 seconds at 60fps
       }
       updateIris(eye);
       break;
     case EYE_OPEN:
-      eye.timer--;
-      if (eye.timer <= 0) {
-        if (eye.blinksLeft > 0) {
-          eye.state = EYE_BLINKING_CLOSE;
-          eye.blinksLeft--;
+      if (--eyes.timer[eye] <= 0) {
+        if (eyes.blinksLeft[eye] > 0) {
+          state = EYE_BLINKING_CLOSE;
+          eyes.blinksLeft[eye]--;
           spawnRipples(eye);  // Each blink sends out ripple rings
         } else {
-          eye.state = EYE_CLOSING;  // No blinks left — close for good
+          state = EYE_CLOSING;  // No blinks left — close for good
         }
       }
       updateIris(eye);
       break;
     case EYE_BLINKING_CLOSE:
-      eye.openAmount -= EYE_OPEN_SPEED;
-      if (eye.openAmount <= 0) {
-        eye.openAmount = 0;
-        eye.state = EYE_BLINKING_OPEN; // Immediately reopen
+      open -= EYE_OPEN_SPEED;
+      if (open <= 0) {
+        open = 0;
+        state = EYE_BLINKING_OPEN; // Immediately reopen
       }
       break;
     case EYE_BLINKING_OPEN:
-      eye.openAmount += EYE_OPEN_SPEED;
-      if (eye.openAmount >= eye.maxOpen) {
-        eye.openAmount = eye.maxOpen;
-        eye.state = EYE_OPEN;
-        eye.timer = random(60, 180);
+      open += EYE_OPEN_SPEED;
+      if (open >= eyeFullOpen) {
+        open = eyeFullOpen;
+        state = EYE_OPEN;
+        eyes.timer[eye] = sceneRandom(60, 180);
       }
       updateIris(eye);
       break;
     case EYE_CLOSING:
-      eye.openAmount -= EYE_OPEN_SPEED;
-      if (eye.openAmount <= 0) {
-        eye.openAmount = 0;
-        eye.state = EYE_INACTIVE; // Slot is now free
+      open -= EYE_OPEN_SPEED;
+      if (open <= 0) {
+        open = 0;
+        state = EYE_INACTIVE; // Slot is freed once this frame has drawn it
       }
       break;
     case EYE_INACTIVE:
@@ -349,64 +808,150 @@ static void updateEye(Eye &eye) {
   }
 }
 
+/**
+ * eyeMaxOpen()
+ *
+ * Fully open half-width: nearly the full screen width.
+ */
+static int eyeMaxOpen(GFXcanvas16 &matrix) {
+  return matrix.width() / 2 - 2;
+}
+
+/**
+ * placeEye()
+ *
+ * Starts a new eye opening in the given free slot at vertical position y
+ * and adds it to the active list.
+ */
+static void placeEye(int eye, int y) {
+  eyes.y[eye] = y;
+  eyes.state[eye] = EYE_OPENING;
+  eyes.openAmount[eye] = 0;
+  eyes.blinksLeft[eye] = sceneRandom(1, 5);
+  eyes.timer[eye] = 0;
+  eyes.irisX[eye] = 0;
+  eyes.irisY[eye] = 0;
+  eyes.irisTargetX[eye] = 0;
+  eyes.irisTargetY[eye] = 0;
+  eyes.lookTimer[eye] = sceneRandom(20, 60);
+  activeInsert(eyes.active, eye);
+}
+
 /**
  * spawnEye()
  *
- * Finds the first inactive eye slot and places a new eye at a random Y
- * position. Uses rejection sampling (up to 20 attempts) to ensure the
- * new eye is at least EYE_MIN_SPACING pixels away from all other active
- * eyes, preventing overlap. The eye is centered horizontally on the screen.
+ * Takes the lowest free eye slot and places a new eye at a random Y
+ * position at least EYE_MIN_SPACING pixels from every active eye, so eyes
+ * never overlap. The positions too close to an eye are blocked in a
+ * FreeSpace, and the new Y is drawn uniformly from what is left. The eye
+ * is centered horizontally on the screen.
  *
  * @param matrix  Reference to the LED matrix (used for screen dimensions)
+ * @return        false if no slot or no position is free
  */
-static void spawnEye(Adafruit_Protomatter &matrix) {
-  for (int i = 0; i < MAX_EYES; i++) {
-    if (eyes[i].state == EYE_INACTIVE) {
-      int newY = 0;
-      bool valid = false;
-      // Rejection sampling: try random Y positions until one is far enough
-      // from all existing eyes, or give up after 20 attempts.
-      for (int attempt = 0; attempt < 20; attempt++) {
-        newY = random(EYE_HALF_HEIGHT + 2, matrix.height() - EYE_HALF_HEIGHT - 2);
-        valid = true;
-        for (int j = 0; j < MAX_EYES; j++) {
-          if (j != i && eyes[j].state != EYE_INACTIVE) {
-            if (abs(newY - eyes[j].y) < EYE_MIN_SPACING) {
-              valid = false;
-              break;
-            }
-          }
-        }
-        if (valid) break;
-      }
-      if (!valid) return;  // Screen too packed, skip spawning
-      eyes[i].x = matrix.width() / 2;
-      eyes[i].y = newY;
-      eyes[i].halfHeight = EYE_HALF_HEIGHT;
-      eyes[i].maxOpen = matrix.width() / 2 - 2;  // Nearly full screen width
-      eyes[i].state = EYE_OPENING;
-      eyes[i].openAmount = 0;
-      eyes[i].blinksLeft = random(1, 5);
-      eyes[i].timer = 0;
-      eyes[i].irisX = 0;
-      eyes[i].irisY = 0;
-      eyes[i].irisTargetX = 0;
-      eyes[i].irisTargetY = 0;
-      eyes[i].lookTimer = random(20, 60);
-      return;
+static bool spawnEye(GFXcanvas16 &matrix) {
+  int eye = activeLowestFree(eyes.active, maxEyes);
+  if (eye < 0) return false;
+  freeSpaceReset(eyeSpace, EYE_HALF_HEIGHT + 2, matrix.height() - EYE_HALF_HEIGHT - 3);
+  for (int i = 0; i < eyes.active.count; i++) {
+    int y = eyes.y[eyes.active.slots[i]];
+    freeSpaceBlock(eyeSpace, y - EYE_MIN_SPACING + 1, y + EYE_MIN_SPACING - 1);
+  }
+  int free = freeSpaceSize(eyeSpace);
+  if (free == 0) return false;  // Screen too packed
+  placeEye(eye, freeSpaceAt(eyeSpace, sceneRandom(free)));
+  return true;
+}
+
+void digitalTrigger(GFXcanvas16 &matrix, int sensor, int sensorCount) {
+  if (sensorCount < 1 || sensor < 0 || sensor >= sensorCount) return;
+  // Sensor i owns the i-th of sensorCount equal bands of the usable height
+  int top = EYE_HALF_HEIGHT + 2;
+  int span = matrix.height() - 2 * top;
+  int y = top + (2 * sensor + 1) * span / (2 * sensorCount);
+
+  // An eye already there reacts instead of a second one overlapping it
+  for (int i = 0; i < eyes.active.count; i++) {
+    int eye = eyes.active.slots[i];
+    if (eyes.state[eye] == EYE_INACTIVE || abs(y - eyes.y[eye]) >= EYE_MIN_SPACING) continue;
+    if (eyes.state[eye] == EYE_OPEN) {
+      eyes.timer[eye] = 0;  // Blink (with ripples) on its next update
+      if (eyes.blinksLeft[eye] == 0) eyes.blinksLeft[eye] = 1;
+    } else if (eyes.state[eye] == EYE_CLOSING) {
+      eyes.state[eye] = EYE_OPENING;
+      eyes.blinksLeft[eye] = sceneRandom(1, 5);
     }
+    return;
   }
+  int eye = activeLowestFree(eyes.active, maxEyes);
+  if (eye >= 0) placeEye(eye, y);
 }
 
 /**
  * initDigital()
  *
- * Initializes the digital scene. Computes the vertical spacing so that
+ * Initializes the digital scene. Allocates the digit column and the eye
+ * slots (all inactive), computes the vertical spacing so that
  * digitCharCount characters are evenly distributed across the screen
  * height with seamless wrapping, then populates the scrolling column
- * with random '0'/'1' characters.
+ * with random '0'/'1' characters. The two glyphs are rasterized once here
+ * into pre-rotated sprites; drawDigital() only blits them.
  */
-void initDigital(Adafruit_Protomatter &matrix) {
+bool initDigital(GFXcanvas16 &matrix, int charCount, int scale, int eyeCount, int trail) {
+  free(digitChars);
+  free(eyesBlock);
+  fastSpriteFree(glyphs[0]);
+  fastSpriteFree(glyphs[1]);
+  digitChars = (DigitChar *)calloc(charCount, sizeof(DigitChar));
+  // Widest fields first so every array stays aligned
+  size_t eyeBytes = 4 * sizeof(int16_t) + 3 * sizeof(uint8_t) + 6 * sizeof(int8_t);
+  eyesBlock = calloc(eyeCount, eyeBytes);
+  bool glyphsOk = fastSpriteFromChar(glyphs[0], '0', scale) && fastSpriteFromChar(glyphs[1], '1', scale);
+  bool templatesOk = buildEyeTemplates(EYE_HALF_HEIGHT, eyeMaxOpen(matrix));
+#if DIGITAL_RAIN_STRIP
+  free(rainStrip);
+  rainHeight = matrix.height();
+  rainColumns = glyphsOk ? glyphs[0].width : 0;
+  if (rainColumns > matrix.width() - charXPos) rainColumns = matrix.width() - charXPos;
+  if (rainColumns < 0) rainColumns = 0;
+  rainStrip = (uint8_t *)malloc((size_t)rainColumns * rainHeight + 1);
+  rainValid = false;
+  bool stripOk = rainStrip != NULL;
+#else
+  bool stripOk = true;
+#endif
+  if (digitChars == NULL || eyesBlock == NULL || !glyphsOk || !templatesOk || !stripOk) {
+    digitCharCount = 0;
+    maxEyes = 0;
+    eyes.active.count = 0;
+    return false;
+  }
+  digitCharCount = charCount;
+  charScale = scale;
+  maxEyes = eyeCount;
+  digitTrailLength = trail;
+  eyeCenterX = matrix.width() / 2;
+  eyeFullOpen = eyeMaxOpen(matrix);
+
+  uint8_t *cursor = (uint8_t *)eyesBlock;
+  eyes.y = poolCarve<int16_t>(cursor, eyeCount);
+  eyes.timer = poolCarve<int16_t>(cursor, eyeCount);
+  eyeSpace.first = poolCarve<int16_t>(cursor, eyeCount);
+  eyeSpace.last = poolCarve<int16_t>(cursor, eyeCount);
+  eyes.state = poolCarve<uint8_t>(cursor, eyeCount);
+  eyes.blinksLeft = poolCarve<uint8_t>(cursor, eyeCount);
+  eyes.active.slots = poolCarve<uint8_t>(cursor, eyeCount);
+  eyes.openAmount = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.irisX = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.irisY = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.irisTargetX = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.irisTargetY = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.lookTimer = poolCarve<int8_t>(cursor, eyeCount);
+  eyes.active.count = 0;
+  ripples.count = 0;
+  bgRedVal = BG_RED_START;
+  ditherPhase = 0;
+
   // The default GFX font is 8 px tall; charScale multiplies that.
   // charOffset is the negative Y distance between characters, calculated
   // so they tile evenly and wrap from bottom back to top without a gap.
@@ -414,8 +959,9 @@ void initDigital(Adafruit_Protomatter &matrix) {
   charOffset = (((matrix.height() - (charHeight * (digitCharCount - 1))) / (digitCharCount - 1)) + charHeight) * -1;
 
   for (int i = 0; i < digitCharCount; i++) {
-    digitChars[i] = initDigit(charOffset * i, matrix.color565(255, 255, 255));
+    digitChars[i] = initDigit(charOffset * i, Adafruit_Protomatter::color565(255, 255, 255));
   }
+  return true;
 }
 
 /**
@@ -424,70 +970,121 @@ void initDigital(Adafruit_Protomatter &matrix) {
  * Main entry point for the digital scene, called once per frame.
  *
  * Rendering order:
- *   1. Fill screen with a slowly drifting dark-red background
- *   2. Scroll and draw the column of binary digit characters
+ *   1. Fill screen with a slowly drifting dark-red background (dithered
+ *      between panel levels when the dither setting covers this scene)
+ *   2. Scroll the column of binary digit characters, then blit their
+ *      trails (if configured) and their cached glyphs. With the rain
+ *      strip, steps 1-2 are one pass that writes every pixel once
  *   3. Update and draw all active eyes (includes lids, lashes, iris)
  *   4. Spawn new eyes to maintain at least 2 on screen
  *   5. Update and draw expanding ripple rings
- *   6. Push the frame buffer to the display
+ * The caller presents the finished frame with matrix.show().
  *
  * @param matrix  Reference to the LED matrix
  */
-void drawDigital(Adafruit_Protomatter &matrix) {
+void drawDigital(GFXcanvas16 &matrix) {
   // --- Background color drift ---
   // Randomly nudge the red intensity up or down each frame, clamped to 15-50.
   // This creates a subtle breathing/pulsing effect on the background.
-  bool addOrSub = random(2);
+  bool addOrSub = sceneRandom(2);
   if (bgRedVal > 50) addOrSub = false;
   if (bgRedVal < 15) addOrSub = true;
   if(addOrSub) {
-    bgRedVal += random(2);
+    bgRedVal += sceneRandom(2);
   } else {
-    bgRedVal -= random(2);
+    bgRedVal -= sceneRandom(2);
   }
+  ditherPhase++;
+  profileMark(PHASE_UPDATE);
 
-  uint16_t bgRedColor = matrix.color565(bgRedVal, 0, 0);
-  matrix.fillScreen(bgRedColor);
+  uint16_t bgRedColor = sceneColor(bgRedVal, 0, 0, 0);
+#if DIGITAL_RAIN_STRIP
+  // The strip writes every pixel itself, background included
+  bool strip = fastDrawAvailable(matrix) && matrix.height() == rainHeight;
+  if (!strip) rainValid = false;
+  RainDirty dirty = {{INT16_MAX, INT16_MAX}, {INT16_MIN, INT16_MIN}};
+#else
+  bool strip = false;
+#endif
+  if (!strip) matrix.fillScreen(bgRedColor);
+  profileMark(PHASE_CLEAR);
 
   // --- Scrolling binary digits ---
   // Each character advances downward by 2 pixels per frame. When it scrolls
   // past the bottom, it wraps back to the top with a new random '0' or '1'.
   for (int i = 0; i < digitCharCount; i++) {
+#if DIGITAL_RAIN_STRIP
+    int before = digitChars[i].yOffset;
+#endif
     digitChars[i].yOffset = digitChars[i].yOffset + 2;
 
     if (digitChars[i].yOffset > matrix.height()) {
-      digitChars[i] = initDigit(charOffset, matrix.color565(255, 255, 255));
+      digitChars[i] = initDigit(charOffset, Adafruit_Protomatter::color565(255, 255, 255));
     }
+#if DIGITAL_RAIN_STRIP
+    if (strip) rainTrack(dirty, before, digitChars[i].yOffset);
+#endif
+  }
+  profileMark(PHASE_UPDATE);
 
-    // Skip drawing characters that are still above the visible area
+#if DIGITAL_RAIN_STRIP
+  if (strip) rainResolve(matrix, dirty, bgRedColor);
+#endif
+  // Trails go down first so every opaque character cell lands on top.
+  // Characters still above the visible area (just wrapped) are skipped.
+  for (int i = 0; i < digitCharCount && !strip; i++) {
+    if (digitChars[i].trail > 0 && digitChars[i].yOffset > charOffset) {
+      drawDigitTrail(digitChars[i], bgRedColor, matrix);
+    }
+  }
+  for (int i = 0; i < digitCharCount && !strip; i++) {
     if (digitChars[i].yOffset > charOffset) {
-      matrix.drawChar(charXPos, digitChars[i].yOffset, digitChars[i].character, digitChars[i].color, bgRedColor, charScale);
+      fastBlitSprite(matrix, glyphs[digitChars[i].character - '0'], charXPos, digitChars[i].yOffset,
+                     digitChars[i].color, bgRedColor);
     }
   }
+  profileMark(PHASE_DRAW);
 
   // --- Eyes ---
-  int activeEyes = 0;
-  for (int i = 0; i < MAX_EYES; i++) {
-    if (eyes[i].state != EYE_INACTIVE) {
-      updateEye(eyes[i]);
-      drawAlmondEye(eyes[i], matrix);
-      activeEyes++;
-    }
+  // Updated and drawn in separate passes for profiling. An eye that closes
+  // for good during its update still gets drawn this frame (as a slit),
+  // and leaves the active list afterwards.
+  ActiveList &active = eyes.active;
+  int activeEyes = active.count;
+  for (int i = 0; i < active.count; i++) {
+    updateEye(active.slots[i]);
   }
+  profileMark(PHASE_UPDATE);
+  int kept = 0;
+  for (int i = 0; i < active.count; i++) {
+    int eye = active.slots[i];
+    drawAlmondEye(eye, matrix);
+    if (eyes.state[eye] != EYE_INACTIVE) active.slots[kept++] = eye;
+  }
+  active.count = kept;
+  profileMark(PHASE_DRAW);
 
-  // Guarantee at least 2 eyes are always visible
-  while (activeEyes < 2) {
-    spawnEye(matrix);
+  // Guarantee at least 2 eyes are always visible (when they fit)
+  while (activeEyes < 2 && spawnEye(matrix)) {
     activeEyes++;
   }
-  // ~1.1% chance each frame to add another eye (up to 5 concurrent)
-  if (activeEyes < 5 && random(90) == 0) {
+  // ~1.1% chance each frame to add another eye (up to 5/8 of the slots,
+  // 5 of the default 8), unless the governor is shedding optional spawns
+  if (activeEyes < maxEyes * 5 / 8 && !governorSheds(QUALITY_NO_EXTRA_SPAWNS) && sceneRandom(90) == 0) {
     spawnEye(matrix);
   }
 
   // --- Ripples ---
   updateRipples(matrix);
+  profileMark(PHASE_UPDATE);
   drawRipples(matrix);
+  profileMark(PHASE_DRAW);
+}
+
+int digitalActiveEyes() {
+  return eyes.active.count;
+}
 
-  matrix.show();
+int digitalActiveRipples() {
+  return ripples.count;
 }
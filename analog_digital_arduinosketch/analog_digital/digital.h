@@ -14,6 +14,21 @@
 
 #include <Adafruit_Protomatter.h>
 
+/**
+ * DIGITAL_RAIN_STRIP
+ *
+ * 1 = the digit column lives in a ring-buffered strip of shade levels
+ * that scrolls by moving its start: each frame rasterizes only the 2 rows
+ * exposed at the top (plus the rows of a character that wrapped) and
+ * resolves the strip through this frame's background and trail colors,
+ * in place of fillScreen() and the glyph and trail blits. A canvas not
+ * at rotation 1 draws the column the reference way. Output is identical
+ * either way.
+ */
+#ifndef DIGITAL_RAIN_STRIP
+#define DIGITAL_RAIN_STRIP 1
+#endif
+
 /**
  * DigitChar
  *
@@ -25,19 +40,21 @@ struct DigitChar {
   char character;   // The ASCII character to display ('0' or '1')
   uint16_t color;   // 16-bit RGB565 display color
   int16_t yOffset;  // Current vertical position on screen
+  uint8_t trail;    // Faded ghost copies drawn above the character (0 = none)
 };
 
 const uint8_t charXPos =  6;          // X pixel position of the character column
-const uint8_t charScale = 4;          // GFX font scale factor (4x the 8px base)
-const uint8_t digitCharCount = 12;    // Number of characters in the scrolling column
 
-extern int8_t charOffset;
-extern DigitChar digitChars[digitCharCount];
+extern uint8_t charScale;             // GFX font scale factor (e.g. 4x the 8px base), set by initDigital()
+extern uint8_t digitCharCount;        // Number of characters in the scrolling column, set by initDigital()
+extern int16_t charOffset;
+extern DigitChar *digitChars;
 
 /**
  * initDigit()
  *
- * Creates a new DigitChar at the given Y position with a random '0' or '1'.
+ * Creates a new DigitChar at the given Y position with a random '0' or '1'
+ * and the trail length passed to initDigital().
  *
  * @param yOffset  Initial vertical position
  * @param color    16-bit RGB565 color
@@ -45,24 +62,51 @@ extern DigitChar digitChars[digitCharCount];
  */
 DigitChar initDigit(int yOffset, int color);
 
+/**
+ * initDigital()
+ *
+ * Allocates the digit column and eye slots, pre-rasterizes the '0' and '1'
+ * glyphs into rotated sprites, computes character spacing and populates
+ * the scrolling digit column. Call once from setup().
+ *
+ * @param matrix     Canvas to draw into (the LED matrix or an offscreen scene canvas)
+ * @param charCount  Number of characters in the scrolling column (at least 2)
+ * @param scale      GFX font scale of the characters
+ * @param eyeCount   Number of eye slots
+ * @param trail      Faded ghost copies drawn above each character (0 = none)
+ * @return           false if the scene arrays could not be allocated
+ */
+bool initDigital(GFXcanvas16 &matrix, int charCount, int scale, int eyeCount, int trail);
+
 /**
  * drawDigital()
  *
  * Renders one frame of the digital scene: background, scrolling binary
  * digits, animated eyes with eyelashes, and expanding ripple effects.
+ * Does not call matrix.show(); the main loop presents the frame.
  *
- * @param matrix  Reference to the LED matrix
+ * @param matrix  Canvas to draw into (the LED matrix or an offscreen scene canvas)
  */
+void drawDigital(GFXcanvas16 &matrix);
+
 /**
- * initDigital()
+ * digitalTrigger()
  *
- * Initializes the digital scene by computing character spacing and
- * populating the scrolling digit column. Call once from setup().
+ * Reacts to a sensor firing: opens an eye in the band of the screen
+ * mapped to that sensor (sensor 0 at the top), or, if an eye is already
+ * there, makes it blink and send out ripples. Takes effect on the next
+ * drawDigital().
  *
- * @param matrix  Reference to the LED matrix
+ * @param matrix       Canvas the scene draws into (for screen dimensions)
+ * @param sensor       Index of the sensor that fired
+ * @param sensorCount  Number of sensors sharing the screen height
  */
-void initDigital(Adafruit_Protomatter &matrix);
+void digitalTrigger(GFXcanvas16 &matrix, int sensor, int sensorCount);
+
+/** Number of eyes currently on screen (telemetry). */
+int digitalActiveEyes();
 
-void drawDigital(Adafruit_Protomatter &matrix);
+/** Number of ripple rings currently expanding (telemetry). */
+int digitalActiveRipples();
 
 #endif
@@ -0,0 +1,74 @@
+/**
+ * dither.cpp
+ *
+ * Implements the gamma tables and temporal dither declared in dither.h.
+ * Red and blue (5 bits in RGB565) share one pair of tables, green (6
+ * bits) has its own. A channel shows min(depth, its width) bits.
+ */
+
+#include "dither.h"
+#include <math.h>
+
+/** Gamma table and level encoding for one RGB565 channel width. */
+struct DitherChannel {
+  uint8_t target[256];  // 8-bit input -> panel level << DITHER_BITS
+  uint8_t encode[64];   // Panel level -> channel value with that level in its top bits
+};
+
+static DitherChannel channel5 = {};  // Red and blue
+static DitherChannel channel6 = {};  // Green
+static uint8_t ditherScenes = 0;
+
+/** Threshold added before truncating, per frame of the cycle (bit-reversed order). */
+static const uint8_t thresholds[DITHER_FRAMES] = {0, 2, 1, 3};
+
+/**
+ * buildChannel()
+ *
+ * Fills one channel's tables for a channel of width bits of which the
+ * panel shows levelBits.
+ */
+static void buildChannel(DitherChannel &c, int width, int levelBits, float gamma) {
+  int maxLevel = (1 << levelBits) - 1;
+  int maxValue = (1 << width) - 1;
+  for (int v = 0; v < 256; v++) {
+    float linear = powf(v / 255.0f, gamma);
+    c.target[v] = (uint8_t)(linear * (maxLevel << DITHER_BITS) + 0.5f);
+  }
+  // Rounding the scaled level keeps the level in the top levelBits bits
+  for (int level = 0; level <= maxLevel; level++) {
+    c.encode[level] = (uint8_t)((level * maxValue + maxLevel / 2) / maxLevel);
+  }
+}
+
+/**
+ * ditherBegin()
+ *
+ * Builds the gamma tables for the panel's bit depth.
+ */
+void ditherBegin(int depth, int gammaTenths, uint8_t scenes) {
+  float gamma = gammaTenths / 10.0f;
+  buildChannel(channel5, 5, depth < 5 ? depth : 5, gamma);
+  buildChannel(channel6, 6, depth < 6 ? depth : 6, gamma);
+  ditherScenes = scenes;
+}
+
+/** True if the scene dithers its colors. */
+bool ditherEnabled(uint8_t scene) {
+  return (ditherScenes & scene) != 0;
+}
+
+/**
+ * ditherColor565()
+ *
+ * Adds this frame's threshold to each channel's fractional level and
+ * keeps the whole part. Over DITHER_FRAMES frames a fraction of k / 4
+ * rounds up on exactly k of them.
+ */
+uint16_t ditherColor565(uint8_t r, uint8_t g, uint8_t b, uint8_t phase) {
+  uint8_t t = thresholds[phase & (DITHER_FRAMES - 1)];
+  uint16_t red = channel5.encode[(channel5.target[r] + t) >> DITHER_BITS];
+  uint16_t green = channel6.encode[(channel6.target[g] + t) >> DITHER_BITS];
+  uint16_t blue = channel5.encode[(channel5.target[b] + t) >> DITHER_BITS];
+  return (red << 11) | (green << 5) | blue;
+}
@@ -0,0 +1,67 @@
+/**
+ * dither.h
+ *
+ * Gamma and temporal dithering for scene colors. Protomatter shows only
+ * the top `depth` bits of each RGB565 channel, so at the default depth of
+ * 4 a channel has 16 levels: the digital background's red drift (15..50)
+ * covers three of them, and dim palette mixes band. More bit planes cost
+ * refresh rate instead.
+ *
+ * ditherColor565() stands in for Adafruit_Protomatter::color565() where a
+ * scene picks its colors each frame. Each 8-bit channel goes through a
+ * gamma table built once by ditherBegin() into a panel level with
+ * DITHER_BITS extra fractional bits. The level shown then steps between
+ * the two nearest panel levels over a cycle of DITHER_FRAMES frames, in
+ * an ordered (bit-reversed) pattern so a half level alternates every
+ * frame. Averaged over the cycle the panel shows the exact fractional
+ * level: at depth 4, gradients look like 6 bits at the 4-bit refresh
+ * rate. The result is encoded so that the top bits Protomatter keeps are
+ * the chosen level.
+ *
+ * Dithering is switched per scene (config setting dither) so the refresh
+ * versus quality tradeoff can be measured against a higher depth. A scene
+ * with it off uses color565() as before. The scene colors were chosen on
+ * a linear panel, so the gamma setting defaults to 1.0.
+ */
+
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stdint.h>
+
+const int DITHER_BITS = 2;                    // Extra level bits made up over time
+const int DITHER_FRAMES = 1 << DITHER_BITS;   // Frames in one dither cycle
+
+/** Bits of the dither setting. */
+const uint8_t DITHER_ANALOG = 1;
+const uint8_t DITHER_DIGITAL = 2;
+
+/**
+ * ditherBegin()
+ *
+ * Builds the gamma tables for the panel's bit depth. Call before the
+ * scenes are initialized.
+ *
+ * @param depth        Protomatter bit planes per channel, 1-6
+ * @param gammaTenths  Gamma exponent times ten (10 = linear, 22 = 2.2)
+ * @param scenes       DITHER_ANALOG and/or DITHER_DIGITAL, 0 = off
+ */
+void ditherBegin(int depth, int gammaTenths, uint8_t scenes);
+
+/** True if the scene (DITHER_ANALOG or DITHER_DIGITAL) dithers its colors. */
+bool ditherEnabled(uint8_t scene);
+
+/**
+ * ditherColor565()
+ *
+ * RGB565 for this frame of the dither cycle.
+ *
+ * @param r, g, b  8-bit color, before gamma
+ * @param phase    Frame counter of the scene; colors given different
+ *                 offsets step on different frames
+ * @return         A color whose top depth bits per channel are the
+ *                 panel level to show this frame
+ */
+uint16_t ditherColor565(uint8_t r, uint8_t g, uint8_t b, uint8_t phase);
+
+#endif
@@ -0,0 +1,321 @@
+/**
+ * fastdraw.cpp
+ *
+ * Span writers for the pre-rotated canvas layout described in fastdraw.h.
+ * Each routine clips once up front, then runs a tight store loop with no
+ * per-pixel bounds checks or virtual calls.
+ */
+
+#include "fastdraw.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+FastDrawWindow fastDrawWindow = {0, 0, 0};
+
+void fastDrawSetWindow(int16_t height, int16_t top, int16_t bottom) {
+  fastDrawWindow.height = height;
+  fastDrawWindow.top = top;
+  fastDrawWindow.bottom = bottom;
+}
+
+/**
+ * fillRun()
+ *
+ * Fills count contiguous pixels. Split out so the compiler can turn it
+ * into wide stores.
+ */
+static inline void fillRun(uint16_t *p, int32_t count, uint16_t color) {
+  for (int32_t i = 0; i < count; i++) {
+    p[i] = color;
+  }
+}
+
+void fastHLine(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t w, uint16_t color) {
+  if (!fastDrawAvailable(matrix)) {
+    matrix.drawFastHLine(x, y, w, color);
+    return;
+  }
+  int16_t pw = matrix.height();
+  int16_t screenW = matrix.width();
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (y < top || y >= bottom || w <= 0) return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (x + w > screenW) w = screenW - x;
+  if (w <= 0) return;
+
+  uint16_t *p = matrix.getBuffer() + (pw - 1 - y) + (int32_t)x * pw;
+  for (int16_t i = 0; i < w; i++, p += pw) {
+    *p = color;
+  }
+}
+
+void fastVLine(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t h, uint16_t color) {
+  if (!fastDrawAvailable(matrix)) {
+    matrix.drawFastVLine(x, y, h, color);
+    return;
+  }
+  int16_t pw = matrix.height();
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (x < 0 || x >= matrix.width() || h <= 0) return;
+  if (y < top) {
+    h -= top - y;
+    y = top;
+  }
+  if (y + h > bottom) h = bottom - y;
+  if (h <= 0) return;
+
+  // Rows y..y+h-1 map to physical columns pw-y-h..pw-1-y
+  fillRun(matrix.getBuffer() + (pw - y - h) + (int32_t)x * pw, h, color);
+}
+
+void fastBlitRing(GFXcanvas16 &matrix, int16_t x, const uint8_t *ring, int16_t start, const uint16_t *palette) {
+  int16_t pw = matrix.height();
+  if (x < 0 || x >= matrix.width()) return;
+  if (!fastDrawAvailable(matrix)) {
+    for (int16_t i = 0; i < pw; i++) {
+      matrix.drawPixel(x, pw - 1 - i, palette[ring[(start + i) % pw]]);
+    }
+    return;
+  }
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  int16_t from = pw - bottom;  // Framebuffer addresses of the window
+  int16_t to = pw - top;
+  uint16_t *p = matrix.getBuffer() + (int32_t)x * pw;
+  int16_t head = pw - start;  // Entries start..pw-1 come first
+  for (int16_t i = from; i < min(head, to); i++) p[i] = palette[ring[start + i]];
+  for (int16_t i = max(head, from); i < to; i++) p[i] = palette[ring[i - head]];
+}
+
+void fastFillRect(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (!fastDrawAvailable(matrix)) {
+    matrix.fillRect(x, y, w, h, color);
+    return;
+  }
+  int16_t pw = matrix.height();
+  int16_t screenW = matrix.width();
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < top) {
+    h -= top - y;
+    y = top;
+  }
+  if (x + w > screenW) w = screenW - x;
+  if (y + h > bottom) h = bottom - y;
+  if (w <= 0 || h <= 0) return;
+
+  uint16_t *p = matrix.getBuffer() + (pw - y - h) + (int32_t)x * pw;
+  for (int16_t i = 0; i < w; i++, p += pw) {
+    fillRun(p, h, color);
+  }
+}
+
+/**
+ * circlePoints()
+ *
+ * The eight symmetric points drawCircle() plots for one step (x, y).
+ */
+static inline void circlePoints(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int16_t x, int16_t y, uint16_t color) {
+  fastPixel(matrix, cx + x, cy + y, color);
+  fastPixel(matrix, cx - x, cy + y, color);
+  fastPixel(matrix, cx + x, cy - y, color);
+  fastPixel(matrix, cx - x, cy - y, color);
+  fastPixel(matrix, cx + y, cy + x, color);
+  fastPixel(matrix, cx - y, cy + x, color);
+  fastPixel(matrix, cx + y, cy - x, color);
+  fastPixel(matrix, cx - y, cy - x, color);
+}
+
+/**
+ * isqrt()
+ *
+ * Integer square root, floor(sqrt(n)).
+ */
+static uint32_t isqrt(uint32_t n) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > n) bit >>= 2;
+  while (bit != 0) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+/**
+ * circleWalk()
+ *
+ * Runs drawCircle()'s midpoint loop from step (x, y), plotting every step
+ * after it, until the loop would end or x passes xLimit. The decision
+ * variable is f = (x + 1)^2 + y(y - 1) - r^2, which is what GFX's
+ * incremental f/ddF_x/ddF_y bookkeeping tracks.
+ */
+static void circleWalk(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int32_t r, int32_t x, int32_t y,
+                       int32_t xLimit, uint16_t color) {
+  int32_t f = (x + 1) * (x + 1) + y * (y - 1) - r * r;
+  while (x < y && x <= xLimit) {
+    if (f >= 0) {
+      y--;
+      f -= 2 * y;
+    }
+    x++;
+    f += 2 * x + 1;
+    circlePoints(matrix, cx, cy, x, y, color);
+  }
+}
+
+void fastCircle(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int16_t r, uint16_t color) {
+  if (r < 0) return;
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (cy + r < top || cy - r >= bottom) return;  // No row of it in the window
+  fastPixel(matrix, cx, cy + r, color);
+  fastPixel(matrix, cx, cy - r, color);
+  fastPixel(matrix, cx + r, cy, color);
+  fastPixel(matrix, cx - r, cy, color);
+
+  // Every visible pixel is within reach columns of the center
+  int32_t reach = max(abs((int32_t)cx), abs((int32_t)matrix.width() - 1 - cx));
+  int32_t r2 = (int32_t)r * r;
+
+  // Caps: steps (x, y) with x <= reach, straight from the top of the loop
+  circleWalk(matrix, cx, cy, r, 0, r, reach, color);
+
+  // Sides: the steps whose y has come down to reach or less. In the first
+  // octant y at step x is the largest y with x^2 + y(y - 1) < r^2, so the
+  // walk can start just before x^2 >= r^2 - reach(reach + 1), or where the
+  // caps walk stopped if that is later.
+  int32_t sideFrom = r2 - reach * (reach + 1);
+  int32_t x = (sideFrom > 0) ? (int32_t)isqrt(sideFrom) - 1 : 0;
+  x = max(x, reach + 1);
+  if (x >= r) return;
+  int32_t m = r2 - x * x;
+  int32_t y = (1 + (int32_t)isqrt(4 * m - 3)) / 2;
+  while (y * (y - 1) >= m) y--;
+  while ((y + 1) * y < m) y++;
+  if (x >= y) return;  // Loop ends before the sides come into view
+  circlePoints(matrix, cx, cy, x, y, color);
+  circleWalk(matrix, cx, cy, r, x, y, INT32_MAX, color);
+}
+
+void fastRing(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int16_t r, int16_t thickness, uint16_t color) {
+  for (int16_t i = 0; i < thickness && r - i >= 0; i++) {
+    fastCircle(matrix, cx, cy, r - i, color);
+  }
+}
+
+bool fastSpriteFromChar(FastSprite &sprite, char c, uint8_t scale) {
+  sprite.width = 6 * scale;
+  sprite.height = 8 * scale;
+  sprite.mask = (uint8_t *)malloc((size_t)sprite.width * sprite.height);
+  GFXcanvas16 scratch(sprite.width, sprite.height);
+  uint16_t *pixels = scratch.getBuffer();
+  if (sprite.mask == NULL || pixels == NULL) {
+    fastSpriteFree(sprite);
+    return false;
+  }
+
+  scratch.drawChar(0, 0, c, 1, 0, scale);
+  uint8_t *m = sprite.mask;
+  for (int16_t col = 0; col < sprite.width; col++) {
+    for (int16_t row = sprite.height - 1; row >= 0; row--) {
+      *m++ = (pixels[col + (int32_t)row * sprite.width] != 0);
+    }
+  }
+  return true;
+}
+
+void fastSpriteFree(FastSprite &sprite) {
+  free(sprite.mask);
+  sprite.mask = NULL;
+}
+
+/**
+ * spriteRows()
+ *
+ * Clips a sprite placed at logical row y against the rows matrix may be
+ * drawn in. Returns the number of visible rows and sets skipBottom to how
+ * many of the sprite's bottom rows fall below them (the first stored
+ * entries of each column). Zero if nothing is visible.
+ */
+static int16_t spriteRows(GFXcanvas16 &matrix, const FastSprite &sprite, int16_t y, int16_t &skipBottom) {
+  int16_t firstRow, endRow;
+  fastDrawRows(matrix, firstRow, endRow);
+  int16_t top = max(firstRow, y);
+  int16_t bottom = min((int16_t)(y + sprite.height), endRow);  // Exclusive
+  skipBottom = (y + sprite.height) - bottom;
+  return bottom - top;
+}
+
+void fastBlitSprite(GFXcanvas16 &matrix, const FastSprite &sprite, int16_t x, int16_t y, uint16_t fg, uint16_t bg) {
+  if (!fastDrawAvailable(matrix)) {
+    for (int16_t col = 0; col < sprite.width; col++) {
+      const uint8_t *m = sprite.mask + (int32_t)col * sprite.height;
+      for (int16_t row = 0; row < sprite.height; row++) {
+        matrix.drawPixel(x + col, y + sprite.height - 1 - row, m[row] ? fg : bg);
+      }
+    }
+    return;
+  }
+  int16_t pw = matrix.height();
+  int16_t screenW = matrix.width();
+  int16_t skipBottom;
+  int16_t rows = spriteRows(matrix, sprite, y, skipBottom);
+  if (rows <= 0) return;
+
+  // The sprite's (clipped) bottom row is the lowest address of each column
+  int16_t bottomRow = y + sprite.height - 1 - skipBottom;
+  uint16_t *base = matrix.getBuffer() + (pw - 1 - bottomRow);
+  for (int16_t col = 0; col < sprite.width; col++) {
+    int16_t sx = x + col;
+    if (sx < 0 || sx >= screenW) continue;
+    const uint8_t *m = sprite.mask + (int32_t)col * sprite.height + skipBottom;
+    uint16_t *p = base + (int32_t)sx * pw;
+    for (int16_t i = 0; i < rows; i++) {
+      p[i] = m[i] ? fg : bg;
+    }
+  }
+}
+
+void fastBlitSpriteMask(GFXcanvas16 &matrix, const FastSprite &sprite, int16_t x, int16_t y, uint16_t fg) {
+  if (!fastDrawAvailable(matrix)) {
+    for (int16_t col = 0; col < sprite.width; col++) {
+      const uint8_t *m = sprite.mask + (int32_t)col * sprite.height;
+      for (int16_t row = 0; row < sprite.height; row++) {
+        if (m[row]) matrix.drawPixel(x + col, y + sprite.height - 1 - row, fg);
+      }
+    }
+    return;
+  }
+  int16_t pw = matrix.height();
+  int16_t screenW = matrix.width();
+  int16_t skipBottom;
+  int16_t rows = spriteRows(matrix, sprite, y, skipBottom);
+  if (rows <= 0) return;
+
+  int16_t bottomRow = y + sprite.height - 1 - skipBottom;
+  uint16_t *base = matrix.getBuffer() + (pw - 1 - bottomRow);
+  for (int16_t col = 0; col < sprite.width; col++) {
+    int16_t sx = x + col;
+    if (sx < 0 || sx >= screenW) continue;
+    const uint8_t *m = sprite.mask + (int32_t)col * sprite.height + skipBottom;
+    uint16_t *p = base + (int32_t)sx * pw;
+    for (int16_t i = 0; i < rows; i++) {
+      if (m[i]) p[i] = fg;
+    }
+  }
+}
@@ -0,0 +1,221 @@
+/**
+ * fastdraw.h
+ *
+ * Thin rendering layer shared by the analog and digital scenes for the
+ * hottest primitives. Instead of going through Adafruit_GFX's virtual
+ * drawPixel() (which re-applies the setRotation(1) transform and clips on
+ * every pixel), these write straight into the RGB565 canvas (the
+ * Protomatter matrix, whose show() converts it to bit planes, or an
+ * offscreen GFXcanvas16 of the same geometry) with the rotation baked in.
+ *
+ * Coordinates are logical (post-rotation: x across the 32 px strip, y
+ * along the 576 px chain), exactly like the GFX calls they replace, and
+ * are clipped to the screen. Under rotation 1, logical pixel (x, y) lives
+ * at buffer[(W - 1 - y) + x * W] where W is the physical chain width, so:
+ *   - a logical vertical run is contiguous in memory (descending address)
+ *   - a logical horizontal run steps by W per pixel
+ * If the matrix is not at rotation 1 every call falls back to GFX.
+ *
+ * A draw window (fastDrawSetWindow()) can further limit the writers to a
+ * band of rows on canvases of one height: a sharded wall paints only the
+ * rows its node shows (shard.h).
+ */
+
+#ifndef FASTDRAW_H
+#define FASTDRAW_H
+
+#include <Adafruit_Protomatter.h>
+
+/**
+ * fastDrawAvailable()
+ *
+ * True when the canvas layout matches the baked-in rotation.
+ */
+inline bool fastDrawAvailable(GFXcanvas16 &matrix) {
+  return matrix.getRotation() == 1 && matrix.getBuffer() != NULL;
+}
+
+/**
+ * FastDrawWindow
+ *
+ * Logical rows top .. bottom - 1, applied to canvases height rows tall.
+ * height 0 = no window.
+ */
+struct FastDrawWindow {
+  int16_t height;
+  int16_t top;
+  int16_t bottom;
+};
+extern FastDrawWindow fastDrawWindow;
+
+/**
+ * fastDrawSetWindow()
+ *
+ * Limits every fastdraw writer, indexedExpand() and the transition mixer
+ * to logical rows top .. bottom - 1 on canvases height rows tall (the
+ * sharded wall and its fade layers); canvases of any other height, such
+ * as the node's own chain, are drawn in full. The GFX fallbacks and plain
+ * GFX calls are not limited. Pixels inside the window come out exactly as
+ * without it, because no writer reads a pixel other than its own. height
+ * 0 lifts the window.
+ */
+void fastDrawSetWindow(int16_t height, int16_t top, int16_t bottom);
+
+/**
+ * fastDrawRows()
+ *
+ * The logical rows the writers may touch on matrix: the window if it
+ * applies, else all of them.
+ */
+inline void fastDrawRows(GFXcanvas16 &matrix, int16_t &top, int16_t &bottom) {
+  int16_t h = matrix.height();
+  if (fastDrawWindow.height == h && fastDrawAvailable(matrix)) {
+    top = fastDrawWindow.top;
+    bottom = fastDrawWindow.bottom;
+  } else {
+    top = 0;
+    bottom = h;
+  }
+}
+
+/**
+ * fastPixel()
+ *
+ * Single clipped pixel.
+ */
+inline void fastPixel(GFXcanvas16 &matrix, int16_t x, int16_t y, uint16_t color) {
+  if (!fastDrawAvailable(matrix)) {
+    matrix.drawPixel(x, y, color);
+    return;
+  }
+  int16_t w = matrix.height();  // Physical width under rotation 1
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (x < 0 || y < top || x >= matrix.width() || y >= bottom) return;
+  matrix.getBuffer()[(w - 1 - y) + (int32_t)x * w] = color;
+}
+
+/**
+ * fastTrace()
+ *
+ * 2-pixel-wide trace segment at (x, y) and (x + 1, y), the unit the
+ * waveform renderer draws for every row.
+ */
+inline void fastTrace(GFXcanvas16 &matrix, int16_t x, int16_t y, uint16_t color) {
+  if (!fastDrawAvailable(matrix)) {
+    matrix.drawPixel(x, y, color);
+    if (x + 1 < matrix.width()) matrix.drawPixel(x + 1, y, color);
+    return;
+  }
+  int16_t w = matrix.height();
+  int16_t top, bottom;
+  fastDrawRows(matrix, top, bottom);
+  if (y < top || y >= bottom || x >= matrix.width() || x < -1) return;
+  uint16_t *p = matrix.getBuffer() + (w - 1 - y) + (int32_t)x * w;
+  if (x >= 0) p[0] = color;
+  if (x + 1 < matrix.width()) p[w] = color;
+}
+
+/**
+ * fastHLine()
+ *
+ * Logical horizontal run of w pixels starting at (x, y). This is a
+ * vertical run in physical space (one pixel per panel row).
+ */
+void fastHLine(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t w, uint16_t color);
+
+/**
+ * fastVLine()
+ *
+ * Logical vertical run of h pixels starting at (x, y). Contiguous in the
+ * framebuffer, so this is a straight memory fill.
+ */
+void fastVLine(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t h, uint16_t color);
+
+/**
+ * fastFillRect()
+ *
+ * Solid rectangle, filled as one contiguous run per logical column.
+ */
+void fastFillRect(GFXcanvas16 &matrix, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+/**
+ * fastCircle()
+ *
+ * Circle outline with exactly the pixels of GFX drawCircle(), but only
+ * the parts that can reach the canvas are walked. Against a 32 px wide
+ * strip that means the two caps where the circle crosses the columns,
+ * plus the sides once the radius is small enough for them to be on
+ * screen: O(screen width) steps instead of O(radius).
+ */
+void fastCircle(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int16_t r, uint16_t color);
+
+/**
+ * fastRing()
+ *
+ * thickness concentric fastCircle()s, radius r inward, drawn in one call
+ * (the same pixels as that many drawCircle() calls).
+ */
+void fastRing(GFXcanvas16 &matrix, int16_t cx, int16_t cy, int16_t r, int16_t thickness, uint16_t color);
+
+/**
+ * fastBlitRing()
+ *
+ * Fills the whole of logical column x (within the window) through a
+ * palette: ring holds matrix.height() palette indices in framebuffer
+ * order, and entry (start + i) % matrix.height() lands at framebuffer
+ * address i (logical row matrix.height() - 1 - i). Two straight memory
+ * walks, so a strip kept as a ring scrolls by moving start instead of its
+ * contents.
+ */
+void fastBlitRing(GFXcanvas16 &matrix, int16_t x, const uint8_t *ring, int16_t start, const uint16_t *palette);
+
+/**
+ * FastSprite
+ *
+ * One-color bitmap (e.g. a font glyph) pre-rotated into the canvas
+ * layout: column c's rows are stored bottom row first, matching the
+ * descending framebuffer addresses of a logical vertical run, so a blit
+ * is one straight memory walk per column. One byte per pixel, nonzero =
+ * foreground.
+ */
+struct FastSprite {
+  int16_t width;   // Logical width in pixels
+  int16_t height;  // Logical height in pixels
+  uint8_t *mask;   // width * height entries, column-major, bottom row first
+};
+
+/**
+ * fastSpriteFromChar()
+ *
+ * Rasterizes a character with GFX's drawChar() (default font, opaque
+ * background, so the cell is 6 * scale by 8 * scale) into a new sprite.
+ * The pixels match drawChar() exactly. Free the sprite with fastSpriteFree().
+ *
+ * @param sprite  Sprite to fill
+ * @param c       Character to rasterize
+ * @param scale   GFX font scale
+ * @return        false if memory could not be allocated
+ */
+bool fastSpriteFromChar(FastSprite &sprite, char c, uint8_t scale);
+
+/** Releases a sprite's bitmap. */
+void fastSpriteFree(FastSprite &sprite);
+
+/**
+ * fastBlitSprite()
+ *
+ * Draws the whole sprite cell at (x, y): foreground pixels in fg, the
+ * rest in bg. Identical output to drawChar() with a background color.
+ */
+void fastBlitSprite(GFXcanvas16 &matrix, const FastSprite &sprite, int16_t x, int16_t y, uint16_t fg, uint16_t bg);
+
+/**
+ * fastBlitSpriteMask()
+ *
+ * Draws only the sprite's foreground pixels at (x, y), leaving the rest
+ * of the cell untouched.
+ */
+void fastBlitSpriteMask(GFXcanvas16 &matrix, const FastSprite &sprite, int16_t x, int16_t y, uint16_t fg);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * freespace.h
+ *
+ * Free-space allocator for placing things along one axis with a minimum
+ * distance between them. The blocked positions are kept as sorted,
+ * disjoint intervals. Every position not in one is free, so a caller can
+ * count the free positions and pick the index-th of them directly.
+ * Compared with drawing random positions until one fits, placement costs
+ * one pass over the intervals. It uses one random draw and always succeeds
+ * when space exists.
+ *
+ * Drawing the index uniformly from [0, freeSpaceSize()) gives the same
+ * distribution as rejection sampling that never gives up.
+ */
+
+#ifndef FREESPACE_H
+#define FREESPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * FreeSpace
+ *
+ * Positions lo..hi (inclusive) minus count blocked intervals, ascending
+ * and neither overlapping nor touching. first and last belong to the
+ * caller and need room for one interval per freeSpaceBlock() call since
+ * the last reset.
+ */
+struct FreeSpace {
+  int16_t lo;
+  int16_t hi;
+  int16_t *first;
+  int16_t *last;
+  int count;
+};
+
+/** Makes every position in lo..hi free again. */
+static inline void freeSpaceReset(FreeSpace &space, int lo, int hi) {
+  space.lo = lo;
+  space.hi = hi;
+  space.count = 0;
+}
+
+/**
+ * freeSpaceBlock()
+ *
+ * Marks first..last (inclusive, clipped to the range) as taken, merging
+ * it with any intervals it overlaps or touches.
+ */
+static inline void freeSpaceBlock(FreeSpace &space, int first, int last) {
+  if (first < space.lo) first = space.lo;
+  if (last > space.hi) last = space.hi;
+  if (first > last) return;
+  int i = 0;
+  while (i < space.count && space.last[i] < first - 1) i++;
+  int j = i;
+  while (j < space.count && space.first[j] <= last + 1) {
+    if (space.first[j] < first) first = space.first[j];
+    if (space.last[j] > last) last = space.last[j];
+    j++;
+  }
+  // Intervals i..j-1 collapse into one at i
+  int tail = space.count - j;
+  int shift = 1 - (j - i);
+  if (shift != 0) {
+    memmove(space.first + j + shift, space.first + j, tail * sizeof(int16_t));
+    memmove(space.last + j + shift, space.last + j, tail * sizeof(int16_t));
+  }
+  space.first[i] = first;
+  space.last[i] = last;
+  space.count += shift;
+}
+
+/** Number of free positions. */
+static inline int freeSpaceSize(const FreeSpace &space) {
+  int size = space.hi - space.lo + 1;
+  for (int i = 0; i < space.count; i++) size -= space.last[i] - space.first[i] + 1;
+  return size < 0 ? 0 : size;
+}
+
+/**
+ * freeSpaceAt()
+ *
+ * @param index  0 .. freeSpaceSize() - 1
+ * @return       The index-th free position, counting up from lo
+ */
+static inline int freeSpaceAt(const FreeSpace &space, int index) {
+  int pos = space.lo;
+  for (int i = 0; i < space.count; i++) {
+    int gap = space.first[i] - pos;
+    if (index < gap) break;
+    index -= gap;
+    pos = space.last[i] + 1;
+  }
+  return pos + index;
+}
+
+#endif
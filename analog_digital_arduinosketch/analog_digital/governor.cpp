@@ -0,0 +1,111 @@
+/**
+ * governor.cpp
+ *
+ * Implements the quality governor declared in governor.h. Frame cost is
+ * smoothed with an exponential moving average (1/8 weight per frame, kept
+ * scaled by 8 to stay in integers). A level is shed when the average
+ * crosses SHED_PERCENT of the budget or a single frame overruns, and
+ * restored after RESTORE_HOLD_FRAMES consecutive frames under
+ * RESTORE_PERCENT. After any change the governor waits SETTLE_FRAMES so
+ * the average reflects the new level before it acts again.
+ */
+
+#include "governor.h"
+
+#if GOVERNOR_ENABLED
+
+static const unsigned long SHED_PERCENT = 85;
+static const unsigned long RESTORE_PERCENT = 55;
+static const int SETTLE_FRAMES = 6;
+static const long RESTORE_HOLD_FRAMES = 120;   // 2 s at 60 FPS
+static const int MAX_HOLD_SHIFT = 4;           // Hold grows up to 16x when restores bounce
+static const long STABLE_FRAMES = 3600;        // 1 min without a shed forgets past bouncing
+
+// Written on the rendering thread; read by governorPrint() from the loop task
+static volatile int level = QUALITY_FULL;
+static int forcedLevel = -1;
+static unsigned long smoothedMicros8 = 0;      // Moving average of frame cost, times 8
+static int settleFrames = 0;
+static long headroomFrames = 0;
+static long framesSinceChange = 0;
+static bool lastChangeWasRestore = false;
+static int holdShift = 0;
+static uint32_t shedCount = 0;
+static uint32_t restoreCount = 0;
+
+/**
+ * changeLevel()
+ *
+ * Moves one level in the given direction and starts the settle window.
+ */
+static void changeLevel(int delta) {
+  level += delta;
+  if (delta > 0) shedCount++;
+  else restoreCount++;
+  lastChangeWasRestore = (delta < 0);
+  settleFrames = SETTLE_FRAMES;
+  headroomFrames = 0;
+  framesSinceChange = 0;
+}
+
+void governorFrameEnd(unsigned long workMicros, unsigned long budgetMicros) {
+  if (smoothedMicros8 == 0) smoothedMicros8 = workMicros << 3;
+  else smoothedMicros8 = smoothedMicros8 + workMicros - (smoothedMicros8 >> 3);
+  unsigned long average = smoothedMicros8 >> 3;
+  framesSinceChange++;
+
+  if (forcedLevel >= 0) {
+    level = forcedLevel;
+    return;
+  }
+  if (settleFrames > 0) {
+    settleFrames--;
+    return;
+  }
+
+  if (workMicros > budgetMicros || average * 100 > budgetMicros * SHED_PERCENT) {
+    if (level < QUALITY_LEVEL_COUNT - 1) {
+      // The last restore didn't hold: wait longer before the next one
+      if (lastChangeWasRestore && framesSinceChange < RESTORE_HOLD_FRAMES && holdShift < MAX_HOLD_SHIFT) {
+        holdShift++;
+      }
+      changeLevel(+1);
+    }
+    return;
+  }
+
+  if (framesSinceChange > STABLE_FRAMES) holdShift = 0;
+
+  if (average * 100 < budgetMicros * RESTORE_PERCENT) headroomFrames++;
+  else headroomFrames = 0;
+  if (level > QUALITY_FULL && headroomFrames >= (RESTORE_HOLD_FRAMES << holdShift)) {
+    changeLevel(-1);
+  }
+}
+
+QualityLevel governorLevel() {
+  return (QualityLevel)level;
+}
+
+void governorForceLevel(int forced) {
+  if (forced >= QUALITY_LEVEL_COUNT) forced = QUALITY_LEVEL_COUNT - 1;
+  forcedLevel = forced;
+  if (forced >= 0) {
+    level = forced;
+  } else {
+    settleFrames = SETTLE_FRAMES;
+    headroomFrames = 0;
+  }
+}
+
+void governorPrint() {
+  static const char *levelNames[QUALITY_LEVEL_COUNT] = {
+    "full", "no extra spawns", "no lashes", "single ring", "half rows"
+  };
+  Serial.printf("governor: level %d (%s)%s  avg %lu us  shed %lu  restored %lu  hold x%d\n",
+                (int)level, levelNames[level], forcedLevel >= 0 ? " forced" : "",
+                smoothedMicros8 >> 3, (unsigned long)shedCount, (unsigned long)restoreCount,
+                1 << holdShift);
+}
+
+#endif
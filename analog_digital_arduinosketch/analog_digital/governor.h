@@ -0,0 +1,99 @@
+/**
+ * governor.h
+ *
+ * Adaptive quality governor. The code that paces frames reports how long
+ * each frame's rendering work took. The governor keeps a smoothed cost
+ * and, when frames start running long, sheds detail one level at a time in
+ * a fixed order, so a busy moment (five lashed eyes plus a dozen ripples,
+ * or several long-tailed waves) costs some detail rather than visibly
+ * stuttering:
+ *   1. no optional spawns (the random extra waves/eyes; blinks emit one ripple)
+ *   2. no eyelashes
+ *   3. ripples drawn as a single ring instead of two
+ *   4. half vertical resolution: wave traces are drawn in 2-row strips
+ * Levels are restored one at a time once there is sustained headroom
+ * again. The gap between the shed and restore thresholds, plus a hold time
+ * that grows if a restore is immediately undone, keeps it from oscillating.
+ *
+ * Scenes ask governorSheds(level) at each optional piece of work. Build
+ * with GOVERNOR_ENABLED 0 to always render at full quality.
+ */
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <Arduino.h>
+
+#ifndef GOVERNOR_ENABLED
+#define GOVERNOR_ENABLED 1
+#endif
+
+/**
+ * QualityLevel
+ *
+ * Shedding steps in the order they are applied. Each level includes all
+ * the ones before it.
+ */
+enum QualityLevel {
+  QUALITY_FULL,             // Everything drawn
+  QUALITY_NO_EXTRA_SPAWNS,  // Random extra waves/eyes suppressed, one ripple per blink
+  QUALITY_NO_LASHES,        // Eyelashes skipped
+  QUALITY_SINGLE_RING,      // Ripples drawn as one circle
+  QUALITY_HALF_ROWS,        // Wave traces drawn in 2-row strips
+  QUALITY_LEVEL_COUNT
+};
+
+#if GOVERNOR_ENABLED
+
+/**
+ * governorFrameEnd()
+ *
+ * Reports one frame's rendering cost and, if warranted, moves the quality
+ * level. Call once per frame from the thread that renders, after the
+ * scene has drawn. Exclude time spent waiting on the display, which
+ * shedding detail cannot reduce.
+ *
+ * @param workMicros    Time spent rendering (and presenting, if done inline)
+ * @param budgetMicros  Time available per frame
+ */
+void governorFrameEnd(unsigned long workMicros, unsigned long budgetMicros);
+
+/** Current quality level. */
+QualityLevel governorLevel();
+
+/**
+ * governorSheds()
+ *
+ * True if the piece of work that level removes should be skipped this
+ * frame.
+ *
+ * @param level  The shedding step that covers the work
+ */
+inline bool governorSheds(QualityLevel level) {
+  return governorLevel() >= level;
+}
+
+/**
+ * governorForceLevel()
+ *
+ * Pins the quality level (for testing or benchmarking a level), or
+ * returns to automatic control.
+ *
+ * @param level  Level to hold, or -1 for automatic
+ */
+void governorForceLevel(int level);
+
+/** Prints the current level, smoothed cost and shed/restore counts over Serial. */
+void governorPrint();
+
+#else
+
+inline void governorFrameEnd(unsigned long, unsigned long) {}
+inline QualityLevel governorLevel() { return QUALITY_FULL; }
+inline bool governorSheds(QualityLevel) { return false; }
+inline void governorForceLevel(int) {}
+inline void governorPrint() {}
+
+#endif
+
+#endif
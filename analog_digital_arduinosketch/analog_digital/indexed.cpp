@@ -0,0 +1,96 @@
+/**
+ * indexed.cpp
+ *
+ * Implements the palette-indexed canvas declared in indexed.h.
+ */
+
+#include "indexed.h"
+#include "fastdraw.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool indexedCreate(IndexedCanvas &canvas, int16_t width, int16_t height) {
+  canvas.width = width;
+  canvas.height = height;
+  canvas.pixels = (uint8_t *)calloc((size_t)width * height, 1);
+  canvas.dirtyRows = (uint8_t *)malloc(height);
+  if (canvas.pixels == NULL || canvas.dirtyRows == NULL) {
+    indexedFree(canvas);
+    return false;
+  }
+  memset(canvas.dirtyRows, 1, height);
+  return true;
+}
+
+void indexedFree(IndexedCanvas &canvas) {
+  free(canvas.pixels);
+  free(canvas.dirtyRows);
+  canvas.pixels = NULL;
+  canvas.dirtyRows = NULL;
+}
+
+void indexedHLine(IndexedCanvas &canvas, int16_t x, int16_t y, int16_t w, uint8_t top) {
+  int16_t h = canvas.height;
+  if (y < 0 || y >= h) return;
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (x + w > canvas.width) w = canvas.width - x;
+  if (w <= 0) return;
+  uint8_t *p = canvas.pixels + (h - 1 - y) + (int32_t)x * h;
+  for (int16_t i = 0; i < w; i++, p += h) *p = indexedMerge(*p, top);
+  canvas.dirtyRows[y] = 1;
+}
+
+void indexedClearRows(IndexedCanvas &canvas, int16_t y, int16_t rows) {
+  int16_t h = canvas.height;
+  if (y < 0) {
+    rows += y;
+    y = 0;
+  }
+  if (y + rows > h) rows = h - y;
+  if (rows <= 0) return;
+  // Rows y..y+rows-1 are one contiguous run in every column
+  uint8_t *p = canvas.pixels + (h - y - rows);
+  for (int16_t x = 0; x < canvas.width; x++, p += h) memset(p, 0, rows);
+  memset(canvas.dirtyRows + y, 1, rows);
+}
+
+/**
+ * expandRows()
+ *
+ * Converts rows y..y+rows-1 of every column into target.
+ */
+static void expandRows(IndexedCanvas &canvas, GFXcanvas16 &target, int16_t y, int16_t rows, const uint16_t *colors) {
+  int16_t h = canvas.height;
+  if (!fastDrawAvailable(target)) {
+    for (int16_t x = 0; x < canvas.width; x++) {
+      for (int16_t r = y; r < y + rows; r++) {
+        target.drawPixel(x, r, colors[canvas.pixels[(h - 1 - r) + (int32_t)x * h]]);
+      }
+    }
+    return;
+  }
+  int32_t offset = h - y - rows;
+  const uint8_t *src = canvas.pixels + offset;
+  uint16_t *dst = target.getBuffer() + offset;
+  for (int16_t x = 0; x < canvas.width; x++, src += h, dst += h) {
+    for (int16_t i = 0; i < rows; i++) dst[i] = colors[src[i]];
+  }
+}
+
+void indexedExpand(IndexedCanvas &canvas, GFXcanvas16 &target, const uint16_t *colors) {
+  // Rows outside the draw window are never shown; they keep their marks
+  int16_t y, h;
+  fastDrawRows(target, y, h);
+  while (y < h) {
+    if (!canvas.dirtyRows[y]) {
+      y++;
+      continue;
+    }
+    int16_t start = y;
+    while (y < h && canvas.dirtyRows[y]) canvas.dirtyRows[y++] = 0;
+    expandRows(canvas, target, start, y - start, colors);
+  }
+}
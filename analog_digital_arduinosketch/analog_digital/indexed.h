@@ -0,0 +1,103 @@
+/**
+ * indexed.h
+ *
+ * Palette-indexed render target: one byte per pixel instead of RGB565,
+ * for scenes whose colors come from a small palette. A byte holds two
+ * 4-bit palette slots (0 = nothing): the low nibble is the color drawn
+ * last at that pixel and the high nibble the one it was drawn over. A
+ * 256-entry color table built by the scene then maps each byte to its
+ * final RGB565 color, so the table decides whether overlaps simply show
+ * the top color or glow with the sum of both. No RGB math happens per
+ * pixel.
+ *
+ * The buffer uses the same pre-rotated layout as fastdraw.h (logical
+ * vertical runs are contiguous) and records which logical rows changed.
+ * indexedExpand() writes just those rows into the RGB565 canvas, which
+ * must otherwise be left alone between frames.
+ */
+
+#ifndef INDEXED_H
+#define INDEXED_H
+
+#include <Adafruit_Protomatter.h>
+
+/** Color table entries: every possible pixel byte. */
+const int INDEXED_COLORS = 256;
+
+/**
+ * IndexedCanvas
+ *
+ * Logical width x height pixels; pixel (x, y) is pixels[(height - 1 - y) + x * height].
+ */
+struct IndexedCanvas {
+  int16_t width;      // Logical width (across the strip)
+  int16_t height;     // Logical height (along the chain)
+  uint8_t *pixels;
+  uint8_t *dirtyRows; // Nonzero = row changed since the last indexedExpand()
+};
+
+/**
+ * indexedCreate()
+ *
+ * Allocates a cleared canvas with every row marked dirty, so the first
+ * indexedExpand() paints the whole target.
+ *
+ * @return  false if out of memory
+ */
+bool indexedCreate(IndexedCanvas &canvas, int16_t width, int16_t height);
+
+/** Releases the canvas buffers. */
+void indexedFree(IndexedCanvas &canvas);
+
+/**
+ * indexedMerge()
+ *
+ * The byte that results from drawing palette slot top (1-15) over
+ * existing. Redrawing the color already on top keeps what is underneath.
+ */
+inline uint8_t indexedMerge(uint8_t existing, uint8_t top) {
+  if ((existing & 0x0F) == top) return existing;
+  return (uint8_t)((existing << 4) | top);
+}
+
+/**
+ * indexedTrace()
+ *
+ * Merges top into (x, y) and (x + 1, y), clipped like fastTrace().
+ */
+inline void indexedTrace(IndexedCanvas &canvas, int16_t x, int16_t y, uint8_t top) {
+  int16_t h = canvas.height;
+  if (y < 0 || y >= h || x >= canvas.width || x < -1) return;
+  uint8_t *p = canvas.pixels + (h - 1 - y) + (int32_t)x * h;
+  if (x >= 0) p[0] = indexedMerge(p[0], top);
+  if (x + 1 < canvas.width) p[h] = indexedMerge(p[h], top);
+  canvas.dirtyRows[y] = 1;
+}
+
+/**
+ * indexedHLine()
+ *
+ * Merges top into a logical horizontal run of w pixels from (x, y).
+ */
+void indexedHLine(IndexedCanvas &canvas, int16_t x, int16_t y, int16_t w, uint8_t top);
+
+/**
+ * indexedClearRows()
+ *
+ * Clears rows logical rows starting at y to 0 (nothing drawn).
+ */
+void indexedClearRows(IndexedCanvas &canvas, int16_t y, int16_t rows);
+
+/**
+ * indexedExpand()
+ *
+ * Writes every dirty row into target through colors and clears the dirty
+ * marks. Only rows inside target's draw window (fastdraw.h) are written.
+ *
+ * @param canvas  Source pixels, same logical size as target
+ * @param target  RGB565 canvas to update
+ * @param colors  INDEXED_COLORS RGB565 entries, one per pixel byte
+ */
+void indexedExpand(IndexedCanvas &canvas, GFXcanvas16 &target, const uint16_t *colors);
+
+#endif
@@ -0,0 +1,270 @@
+/**
+ * netsink.cpp
+ *
+ * Implements the network pixel sink declared in netsink.h. Everything
+ * runs on the loop task: netsinkPoll() fills the ring, and
+ * netsinkTakeFrame() drains it.
+ *
+ * The ring holds jitter + 2 canvas-sized slots. From the oldest, there
+ * are "finished" frames waiting to be shown, then at most one frame being
+ * assembled. The slot just before the one being assembled always holds
+ * the newest complete frame, so a new frame starts as a copy of it and
+ * pixels a sender does not resend keep their colour.
+ */
+
+#include "netsink.h"
+#include <string.h>
+#include "network.h"
+
+#if NETWORK_SINK
+#if !NETWORK_WIFI
+#error "NETWORK_SINK needs WiFi: define WIFI_SSID and WIFI_PASSWORD (see network.h)"
+#endif
+#include <WiFiUdp.h>
+#endif
+
+static const int DDP_HEADER_BYTES = 10;
+static const int DDP_TIMECODE_BYTES = 4;
+static const uint8_t DDP_VERSION_MASK = 0xC0;
+static const uint8_t DDP_VERSION_1 = 0x40;
+static const uint8_t DDP_FLAG_TIMECODE = 0x10;
+static const uint8_t DDP_FLAG_QUERY = 0x02;
+static const uint8_t DDP_FLAG_PUSH = 0x01;
+static const uint8_t DDP_ID_DISPLAY = 1;
+static const uint8_t DDP_ID_ALL = 255;
+static const uint8_t DDP_TYPE_UNDEFINED = 0x00;
+static const uint8_t DDP_TYPE_LEGACY_RGB = 0x01;
+static const uint8_t DDP_TYPE_RGB8 = 0x0B;
+
+static const int ARTNET_HEADER_BYTES = 18;
+static const uint16_t ARTNET_OP_DMX = 0x5000;
+static const uint16_t ARTNET_OP_SYNC = 0x5200;
+static const uint32_t ARTNET_SYNC_TIMEOUT_MICROS = 4000000;   // Art-Net 4: back to unsynced after 4 s
+
+static const int MAX_SLOTS = NETSINK_MAX_JITTER + 2;
+static const int MAX_PACKETS_PER_POLL = 64;   // Per port; one 9-panel frame is 26 DDP packets
+
+// Ring (see the file header)
+static uint16_t *ring = NULL;
+static uint32_t slotPixels = 0;
+static int slotCount = 0;
+static int head = 0;             // Oldest finished frame
+static int finished = 0;         // Finished frames waiting from head on
+static int filling = -1;         // Slot being assembled, -1 = none
+static uint32_t finishedMicros[MAX_SLOTS];
+
+static int jitter = 0;
+static int universeBase = 0;
+static int universeCount = 0;    // Art-Net universes that cover the canvas
+
+// Traffic
+static bool receiving = false;
+static uint32_t lastPacketMicros = 0;
+static uint32_t lastSyncMicros = 0;
+static bool syncSeen = false;
+
+// Playback
+static bool presenting = false;
+static uint32_t nextPresentMicros = 0;
+
+// Stats
+static uint32_t packetsDdp = 0;
+static uint32_t packetsArtnet = 0;
+static uint32_t packetsRejected = 0;
+static uint32_t framesReceived = 0;
+static uint32_t framesShown = 0;
+static uint32_t framesDropped = 0;
+
+#if NETWORK_SINK
+static WiFiUDP ddpUdp;
+static WiFiUDP artnetUdp;
+static uint8_t packetBuffer[1500];
+#endif
+
+static uint16_t *slot(int index) {
+  return ring + (size_t)index * slotPixels;
+}
+
+bool netsinkBegin(GFXcanvas16 &canvas, int jitterFrames, int firstUniverse) {
+  jitter = min(max(jitterFrames, 0), NETSINK_MAX_JITTER);
+  universeBase = firstUniverse;
+  slotPixels = (uint32_t)canvas.width() * canvas.height();
+  universeCount = (slotPixels + ARTNET_PIXELS_PER_UNIVERSE - 1) / ARTNET_PIXELS_PER_UNIVERSE;
+  slotCount = jitter + 2;
+  free(ring);
+  ring = (uint16_t *)calloc((size_t)slotCount * slotPixels, sizeof(uint16_t));
+  if (ring == NULL) return false;
+  head = 0;
+  finished = 0;
+  filling = -1;
+
+#if NETWORK_SINK
+  networkBegin();
+  ddpUdp.begin(DDP_PORT);
+  artnetUdp.begin(ARTNET_PORT);
+#endif
+  return true;
+}
+
+/**
+ * noteTraffic()
+ *
+ * Records an accepted packet. After a silence long enough to have left
+ * sink mode, playback timing starts over.
+ */
+static void noteTraffic(uint32_t nowMicros) {
+  if (!netsinkActive(nowMicros)) presenting = false;
+  receiving = true;
+  lastPacketMicros = nowMicros;
+}
+
+/**
+ * fillSlot()
+ *
+ * The slot the current frame is assembled in, starting a new frame if
+ * none is open. When every slot holds a finished frame, the oldest is
+ * dropped to make room.
+ */
+static uint16_t *fillSlot() {
+  if (filling < 0) {
+    if (finished == slotCount) {
+      head = (head + 1) % slotCount;
+      finished--;
+      framesDropped++;
+    }
+    filling = (head + finished) % slotCount;
+    memcpy(slot(filling), slot((filling + slotCount - 1) % slotCount), slotPixels * sizeof(uint16_t));
+  }
+  return slot(filling);
+}
+
+/** Closes the frame being assembled (if any) and queues it for playback. */
+static void finishFrame(uint32_t nowMicros) {
+  if (filling < 0) return;
+  finishedMicros[filling] = nowMicros;
+  finished++;
+  filling = -1;
+  framesReceived++;
+}
+
+/**
+ * writePixels()
+ *
+ * Converts count RGB888 pixels into the frame being assembled from pixel
+ * index first on, clipped to the canvas.
+ */
+static void writePixels(uint32_t first, const uint8_t *rgb, uint32_t count) {
+  if (first >= slotPixels) return;
+  if (count > slotPixels - first) count = slotPixels - first;
+  uint16_t *out = fillSlot() + first;
+  for (uint32_t i = 0; i < count; i++, rgb += 3) {
+    out[i] = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3);
+  }
+}
+
+bool netsinkFeedDdp(const uint8_t *packet, int length, uint32_t nowMicros) {
+  if (ring == NULL || length < DDP_HEADER_BYTES) return false;
+  uint8_t flags = packet[0];
+  uint8_t type = packet[2];
+  uint8_t id = packet[3];
+  if ((flags & DDP_VERSION_MASK) != DDP_VERSION_1 || (flags & DDP_FLAG_QUERY) ||
+      (id != DDP_ID_DISPLAY && id != DDP_ID_ALL) ||
+      (type != DDP_TYPE_UNDEFINED && type != DDP_TYPE_LEGACY_RGB && type != DDP_TYPE_RGB8)) {
+    packetsRejected++;
+    return false;
+  }
+  uint32_t offset = ((uint32_t)packet[4] << 24) | ((uint32_t)packet[5] << 16) | ((uint32_t)packet[6] << 8) | packet[7];
+  uint32_t dataBytes = ((uint32_t)packet[8] << 8) | packet[9];
+  int dataStart = DDP_HEADER_BYTES + ((flags & DDP_FLAG_TIMECODE) ? DDP_TIMECODE_BYTES : 0);
+  if (offset % 3 != 0 || dataBytes % 3 != 0 || dataStart + (int)dataBytes > length) {
+    packetsRejected++;
+    return false;
+  }
+
+  packetsDdp++;
+  noteTraffic(nowMicros);
+  if (dataBytes > 0) writePixels(offset / 3, packet + dataStart, dataBytes / 3);
+  if (flags & DDP_FLAG_PUSH) finishFrame(nowMicros);
+  return true;
+}
+
+bool netsinkFeedArtnet(const uint8_t *packet, int length, uint32_t nowMicros) {
+  if (ring == NULL || length < 12 || memcmp(packet, "Art-Net", 8) != 0) return false;
+  uint16_t op = packet[8] | (packet[9] << 8);
+
+  if (op == ARTNET_OP_SYNC) {
+    syncSeen = true;
+    lastSyncMicros = nowMicros;
+    // A sync on its own (no data since the last frame) is not traffic
+    if (filling >= 0) {
+      noteTraffic(nowMicros);
+      finishFrame(nowMicros);
+    }
+    return true;
+  }
+  if (op != ARTNET_OP_DMX) return true;
+
+  if (length < ARTNET_HEADER_BYTES) {
+    packetsRejected++;
+    return false;
+  }
+  int universe = (packet[15] << 8) | packet[14];
+  int dataBytes = (packet[16] << 8) | packet[17];
+  if (dataBytes > length - ARTNET_HEADER_BYTES) dataBytes = length - ARTNET_HEADER_BYTES;
+  int index = universe - universeBase;
+  if (index < 0 || index >= universeCount) return false;
+
+  packetsArtnet++;
+  noteTraffic(nowMicros);
+  writePixels((uint32_t)index * ARTNET_PIXELS_PER_UNIVERSE, packet + ARTNET_HEADER_BYTES,
+              min(dataBytes / 3, ARTNET_PIXELS_PER_UNIVERSE));
+  if (syncSeen && nowMicros - lastSyncMicros >= ARTNET_SYNC_TIMEOUT_MICROS) syncSeen = false;
+  if (!syncSeen && index == universeCount - 1) finishFrame(nowMicros);
+  return true;
+}
+
+void netsinkPoll() {
+#if NETWORK_SINK
+  if (ring == NULL) return;
+  for (int i = 0; i < MAX_PACKETS_PER_POLL && ddpUdp.parsePacket() > 0; i++) {
+    int length = ddpUdp.read(packetBuffer, sizeof(packetBuffer));
+    if (length > 0) netsinkFeedDdp(packetBuffer, length, micros());
+  }
+  for (int i = 0; i < MAX_PACKETS_PER_POLL && artnetUdp.parsePacket() > 0; i++) {
+    int length = artnetUdp.read(packetBuffer, sizeof(packetBuffer));
+    if (length > 0) netsinkFeedArtnet(packetBuffer, length, micros());
+  }
+#endif
+}
+
+bool netsinkActive(uint32_t nowMicros) {
+  return receiving && nowMicros - lastPacketMicros < NETSINK_TIMEOUT_MS * 1000UL;
+}
+
+bool netsinkTakeFrame(GFXcanvas16 &canvas, uint32_t nowMicros, unsigned long microsPerFrame) {
+  if (finished == 0) return false;
+  if ((int32_t)(nowMicros - finishedMicros[head]) < (int32_t)(jitter * microsPerFrame)) return false;
+  if (presenting && (int32_t)(nowMicros - nextPresentMicros) < 0) return false;
+
+  memcpy(canvas.getBuffer(), slot(head), slotPixels * sizeof(uint16_t));
+  head = (head + 1) % slotCount;
+  finished--;
+  framesShown++;
+
+  // One frame per period; after a gap, restart the cadence from now
+  if (!presenting || (int32_t)(nowMicros - nextPresentMicros) > (int32_t)microsPerFrame) {
+    nextPresentMicros = nowMicros + microsPerFrame;
+  } else {
+    nextPresentMicros += microsPerFrame;
+  }
+  presenting = true;
+  return true;
+}
+
+void netsinkPrintStats() {
+  Serial.printf("netsink: frames in %lu  shown %lu  dropped %lu  waiting %d  (jitter %d)\n",
+                (unsigned long)framesReceived, (unsigned long)framesShown, (unsigned long)framesDropped,
+                finished, jitter);
+  Serial.printf("netsink: packets ddp %lu  art-net %lu  rejected %lu\n",
+                (unsigned long)packetsDdp, (unsigned long)packetsArtnet, (unsigned long)packetsRejected);
+}
@@ -0,0 +1,120 @@
+/**
+ * netsink.h
+ *
+ * Network pixel sink: a third display mode in which the wall shows
+ * frames streamed over WiFi from QLC+, a media server or a pixel mapper,
+ * instead of the built-in scenes. Two protocols are accepted:
+ *   DDP      UDP port 4048. RGB, 8 bits per channel. A packet's data
+ *            offset is in bytes, and a packet with the PUSH flag ends the
+ *            frame. Offsets and lengths must be whole pixels, which
+ *            1440-byte (480-pixel) packets always are.
+ *   Art-Net  UDP port 6454. ArtDmx universes of 170 RGB pixels, from
+ *            config setting "universe" upward. ArtSync ends the frame. A
+ *            sender that never sends ArtSync ends it with the last
+ *            universe the wall needs.
+ * Pixels arrive in the panel chain's own order. There are 32 rows of 64 *
+ * panels pixels, row-major, starting at the chain's first pixel. On the
+ * wall row r is screen column r, and each row runs bottom to top. This
+ * is also the layout of the Protomatter canvas, so each packet lands with
+ * one sequential RGB888 -> RGB565 pass and no per-pixel remapping.
+ *
+ * Frames are assembled in a ring of canvas-sized slots. A finished frame
+ * is held for "jitter" frame periods (config setting, 0-4), then
+ * presented at one frame per period. Uneven packet arrival over WiFi
+ * then smooths out into steady playback. If the sender is faster than
+ * the display, the oldest waiting frame is dropped.
+ *
+ * The sink takes over the display while frames keep arriving and hands
+ * it back to the scenes NETSINK_TIMEOUT_MS after the last one. Build
+ * with NETWORK_SINK 1 and WiFi (network.h) to enable it. The packet
+ * parsers are portable so the host bench can drive them.
+ */
+
+#ifndef NETSINK_H
+#define NETSINK_H
+
+#include <Adafruit_Protomatter.h>
+
+#ifndef NETWORK_SINK
+#define NETWORK_SINK 0
+#endif
+
+const uint16_t DDP_PORT = 4048;
+const uint16_t ARTNET_PORT = 6454;
+const int ARTNET_PIXELS_PER_UNIVERSE = 170;
+const uint32_t NETSINK_TIMEOUT_MS = 1000;
+const int NETSINK_MAX_JITTER = 4;
+
+/**
+ * netsinkBegin()
+ *
+ * Allocates the frame ring for canvas's geometry and, when built with
+ * NETWORK_SINK, joins WiFi and opens the DDP and Art-Net ports.
+ *
+ * @param canvas         Canvas frames are presented into (for its size)
+ * @param jitterFrames   Frame periods a finished frame waits before
+ *                       playback (0 = show as soon as due)
+ * @param firstUniverse  Art-Net universe carrying the first 170 pixels
+ * @return               false if the ring could not be allocated
+ */
+bool netsinkBegin(GFXcanvas16 &canvas, int jitterFrames, int firstUniverse);
+
+/**
+ * netsinkPoll()
+ *
+ * Reads every waiting DDP and Art-Net packet into the ring. Call from
+ * loop() each iteration.
+ */
+void netsinkPoll();
+
+/**
+ * netsinkFeedDdp()
+ *
+ * Applies one DDP packet.
+ *
+ * @param packet      UDP payload
+ * @param length      Bytes in packet
+ * @param nowMicros   Arrival time
+ * @return            false if the packet was malformed or not for us
+ */
+bool netsinkFeedDdp(const uint8_t *packet, int length, uint32_t nowMicros);
+
+/**
+ * netsinkFeedArtnet()
+ *
+ * Applies one Art-Net packet (ArtDmx or ArtSync; other opcodes are
+ * ignored).
+ *
+ * @param packet      UDP payload
+ * @param length      Bytes in packet
+ * @param nowMicros   Arrival time
+ * @return            false if the packet was malformed or not for us
+ */
+bool netsinkFeedArtnet(const uint8_t *packet, int length, uint32_t nowMicros);
+
+/**
+ * netsinkActive()
+ *
+ * @param nowMicros  Current time
+ * @return           true while frames keep arriving (the last packet was
+ *                   under NETSINK_TIMEOUT_MS ago)
+ */
+bool netsinkActive(uint32_t nowMicros);
+
+/**
+ * netsinkTakeFrame()
+ *
+ * Copies the next frame into canvas, once its jitter delay has passed
+ * and a frame period has gone by since the last one.
+ *
+ * @param canvas          The canvas about to be shown
+ * @param nowMicros       Current time
+ * @param microsPerFrame  Playback frame period
+ * @return                true if canvas changed and should be shown
+ */
+bool netsinkTakeFrame(GFXcanvas16 &canvas, uint32_t nowMicros, unsigned long microsPerFrame);
+
+/** Prints frame, packet and drop counts over Serial. */
+void netsinkPrintStats();
+
+#endif
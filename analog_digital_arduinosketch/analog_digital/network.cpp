@@ -0,0 +1,35 @@
+/**
+ * network.cpp
+ *
+ * Implements the shared WiFi station declared in network.h.
+ */
+
+#include "network.h"
+
+#if NETWORK_WIFI
+#include <WiFi.h>
+
+static bool started = false;
+#endif
+
+bool networkBegin() {
+#if NETWORK_WIFI
+  if (!started) {
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(true);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    started = true;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool networkConnected() {
+#if NETWORK_WIFI
+  return started && WiFi.status() == WL_CONNECTED;
+#else
+  return false;
+#endif
+}
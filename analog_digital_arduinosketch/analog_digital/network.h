@@ -0,0 +1,36 @@
+/**
+ * network.h
+ *
+ * WiFi for the features that can use it (UDP telemetry, the network
+ * pixel sink). WiFi is compiled in only when the build defines both
+ * WIFI_SSID and WIFI_PASSWORD, e.g.
+ *   -DWIFI_SSID='"installation"' -DWIFI_PASSWORD='"secret"'
+ * and is started by the first feature that asks for it. The station
+ * reconnects by itself if the access point goes away.
+ */
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(WIFI_SSID) && defined(WIFI_PASSWORD)
+#define NETWORK_WIFI 1
+#else
+#define NETWORK_WIFI 0
+#endif
+
+/**
+ * networkBegin()
+ *
+ * Starts joining the network (once; later calls do nothing). Does not
+ * wait for the connection.
+ *
+ * @return  false if the build has no WiFi
+ */
+bool networkBegin();
+
+/** True while WiFi is connected. */
+bool networkConnected();
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * pipeline.cpp
+ *
+ * Implements the core 0 render task and the core 1 presentation side of
+ * the frame handoff described in pipeline.h.
+ */
+
+#include "pipeline.h"
+
+#if RENDER_PIPELINE
+
+#include <atomic>
+#include <string.h>
+#include "governor.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "telemetry.h"
+
+static const uint32_t RENDER_STACK_BYTES = 8192;
+static const UBaseType_t RENDER_PRIORITY = 1;
+static const BaseType_t RENDER_CORE = 0;   // Arduino loop() runs on core 1
+
+static Adafruit_Protomatter *presentMatrix = NULL;
+static GFXcanvas16 *sceneCanvas = NULL;
+static RenderFunction renderFrame = NULL;
+static unsigned long framePeriod = 0;
+static size_t canvasBytes = 0;
+
+/**
+ * Handoff slot. true = the matrix canvas holds a finished frame the loop
+ * task has not shown yet; only the render task sets it, only the loop task
+ * clears it. Acquire/release ordering makes the canvas copy visible to the
+ * other core before the flag flips.
+ */
+static std::atomic<bool> frameReady(false);
+
+// Pause request from the loop task, and the render task's acknowledgement
+static std::atomic<bool> pauseRequested(false);
+static std::atomic<bool> parked(false);
+
+// Presentation stats (written on core 1 only)
+static uint32_t framesShown = 0;
+static unsigned long showMinMicros = 0;
+static unsigned long showMaxMicros = 0;
+static uint64_t showTotalMicros = 0;
+
+// Render-side stats (written on core 0 only)
+static volatile uint32_t handoffWaits = 0;
+
+#if !FRAME_SCHEDULER
+/**
+ * waitUntil()
+ *
+ * Sleeps the render task until the given micros() deadline. Whole
+ * milliseconds are slept with vTaskDelay so the core 0 idle task (and its
+ * watchdog) gets to run; the final stretch of under 2 ms is spun.
+ */
+static void waitUntil(unsigned long deadline) {
+  for (;;) {
+    long remaining = (long)(deadline - micros());
+    if (remaining <= 0) return;
+    if (remaining >= 2000) {
+      vTaskDelay(pdMS_TO_TICKS(remaining / 1000 - 1));
+    }
+  }
+}
+#endif
+
+/**
+ * renderTask()
+ *
+ * Core 0 loop: pace to the frame period, render into the scene canvas,
+ * then hand the frame to the loop task, wake it to show the frame, and
+ * report the render cost to the quality governor.
+ */
+static void renderTask(void *) {
+#if !FRAME_SCHEDULER
+  unsigned long nextFrame = micros();
+#endif
+  for (;;) {
+    if (pauseRequested.load()) {
+      parked.store(true);
+      vTaskDelay(1);
+#if !FRAME_SCHEDULER
+      nextFrame = micros();
+#endif
+      continue;
+    }
+#if FRAME_SCHEDULER
+    while (!schedulerFrameDue()) schedulerSleep(schedulerNextFrame());
+#else
+    waitUntil(nextFrame);
+    nextFrame += framePeriod;
+    // Fell more than a frame behind: don't try to catch up with a burst
+    if ((long)(micros() - nextFrame) > (long)framePeriod) nextFrame = micros() + framePeriod;
+#endif
+
+    unsigned long frameStart = micros();
+    profileFrameStart();
+    renderFrame(*sceneCanvas);
+
+    // Slot still holds the previous frame: it is being shown right now,
+    // which takes a few ms at most, so spin rather than sleep a whole tick
+    unsigned long waited = 0;
+    if (frameReady.load(std::memory_order_acquire)) {
+      handoffWaits++;
+      unsigned long waitStart = micros();
+      while (frameReady.load(std::memory_order_acquire)) {
+        taskYIELD();
+      }
+      waited = micros() - waitStart;
+    }
+    memcpy(presentMatrix->getBuffer(), sceneCanvas->getBuffer(), canvasBytes);
+    frameReady.store(true, std::memory_order_release);
+#if FRAME_SCHEDULER
+    schedulerWake();
+#endif
+    profileMark(PHASE_SHOW);  // Handoff: waiting for the slot plus the copy
+    profileFrameEnd(framePeriod);
+    // Waiting on show() is not something shedding detail can fix
+    unsigned long work = micros() - frameStart - waited;
+    governorFrameEnd(work, framePeriod);
+    telemetryFrameEnd(work, framePeriod);
+  }
+}
+
+bool pipelineBegin(Adafruit_Protomatter &matrix, RenderFunction render, unsigned long microsPerFrame) {
+  presentMatrix = &matrix;
+  renderFrame = render;
+  framePeriod = microsPerFrame;
+
+  // Physical geometry: undo the rotation to get the raw canvas size
+  uint8_t rotation = matrix.getRotation();
+  matrix.setRotation(0);
+  sceneCanvas = new GFXcanvas16(matrix.width(), matrix.height());
+  matrix.setRotation(rotation);
+  if (sceneCanvas == NULL || sceneCanvas->getBuffer() == NULL) return false;
+  sceneCanvas->setRotation(rotation);
+  canvasBytes = (size_t)matrix.width() * matrix.height() * sizeof(uint16_t);
+  memcpy(sceneCanvas->getBuffer(), matrix.getBuffer(), canvasBytes);
+
+  BaseType_t ok = xTaskCreatePinnedToCore(renderTask, "render", RENDER_STACK_BYTES, NULL,
+                                          RENDER_PRIORITY, NULL, RENDER_CORE);
+  return ok == pdPASS;
+}
+
+void pipelinePresent() {
+  if (!frameReady.load(std::memory_order_acquire)) return;
+
+  unsigned long start = micros();
+  presentMatrix->show();
+  unsigned long elapsed = micros() - start;
+  frameReady.store(false, std::memory_order_release);
+
+  if (framesShown == 0 || elapsed < showMinMicros) showMinMicros = elapsed;
+  if (elapsed > showMaxMicros) showMaxMicros = elapsed;
+  showTotalMicros += elapsed;
+  framesShown++;
+  telemetryShow(elapsed);
+}
+
+void pipelineSetPaused(bool paused) {
+  if (!paused) parked.store(false);
+  pauseRequested.store(paused);
+}
+
+bool pipelineParked() {
+  return parked.load();
+}
+
+void pipelinePrintStats() {
+  Serial.printf("pipeline: shown %lu  render waited on show %lu\n",
+                (unsigned long)framesShown, (unsigned long)handoffWaits);
+  if (framesShown == 0) return;
+  Serial.printf("show() us  min %lu  avg %lu  max %lu\n", showMinMicros,
+                (unsigned long)(showTotalMicros / framesShown), showMaxMicros);
+}
+
+#endif
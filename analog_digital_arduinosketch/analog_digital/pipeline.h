@@ -0,0 +1,84 @@
+/**
+ * pipeline.h
+ *
+ * Dual-core render pipeline for the ESP32-S3. Scene simulation and
+ * rasterization run in a FreeRTOS task pinned to core 0, drawing into an
+ * offscreen scene canvas. The Arduino loop task on core 1 stays free for
+ * presentation (matrix.show(), which converts the canvas to bit planes)
+ * and for input/serial polling.
+ *
+ * The two sides exchange frames through a single lock-free handoff slot:
+ *   render task: draw frame N+1 into the scene canvas while the loop task
+ *                is still presenting frame N, then wait for the slot to
+ *                empty, copy the scene canvas into the matrix canvas and
+ *                mark the slot full
+ *   loop task:   when the slot is full, show() it and mark it empty
+ * The scene canvas is never reset between frames, so renderers that only
+ * erase what they drew last frame (analog dirty spans) keep working.
+ *
+ * With the frame scheduler (scheduler.h) the render task sleeps until
+ * schedulerFrameDue() and wakes the loop task after each handoff.
+ *
+ * Enabled by default on ESP32 targets; elsewhere (and with
+ * RENDER_PIPELINE 0) the sketch renders and presents inline in loop().
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <Adafruit_Protomatter.h>
+
+#ifndef RENDER_PIPELINE
+#if defined(ARDUINO_ARCH_ESP32)
+#define RENDER_PIPELINE 1
+#else
+#define RENDER_PIPELINE 0
+#endif
+#endif
+
+#if RENDER_PIPELINE
+
+/** Renders one complete frame of the current scene into canvas. */
+typedef void (*RenderFunction)(GFXcanvas16 &canvas);
+
+/**
+ * pipelineBegin()
+ *
+ * Allocates the offscreen scene canvas (same geometry and rotation as the
+ * matrix) and starts the render task on core 0.
+ *
+ * @param matrix         The LED matrix frames are presented on
+ * @param render         Called by the render task once per frame
+ * @param microsPerFrame Frame period the render task paces itself to
+ * @return               false if the canvas or task could not be created
+ */
+bool pipelineBegin(Adafruit_Protomatter &matrix, RenderFunction render, unsigned long microsPerFrame);
+
+/**
+ * pipelinePresent()
+ *
+ * Call from loop(). If the render task has handed off a frame, shows it
+ * and frees the slot for the next one. Returns immediately otherwise.
+ */
+void pipelinePresent();
+
+/**
+ * pipelineSetPaused()
+ *
+ * Pauses or resumes the render task, for a loop task that wants to draw
+ * on the matrix itself (the network sink). A pause takes effect once the
+ * frame in progress has been handed off; keep calling pipelinePresent()
+ * until pipelineParked() says so. The scene canvas is left alone, so
+ * the scenes carry on where they stopped.
+ */
+void pipelineSetPaused(bool paused);
+
+/** True once a paused render task has stopped touching the matrix. */
+bool pipelineParked();
+
+/** Prints show() timing and handoff counters over Serial. */
+void pipelinePrintStats();
+
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * pool.h
+ *
+ * Helpers for the scenes' entity pools. A pool keeps each field of its
+ * entities in its own array indexed by slot, all carved from one
+ * allocation, using the narrowest type the field needs. The slots in use
+ * are listed in an ActiveList, so per-frame loops walk only live entities.
+ *
+ * The list is kept in ascending slot order, and a new entity takes the
+ * lowest free slot. Entities therefore update and draw in the same order
+ * the old scan-every-slot loops used, which matters wherever they overlap
+ * (later waves and eyes land on top), and output stays identical.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * poolCarve()
+ *
+ * Hands out the next count elements of a pool block and advances cursor
+ * past them. Carve the widest types first to keep every array aligned.
+ */
+template <typename T>
+static inline T *poolCarve(uint8_t *&cursor, int count) {
+  T *array = (T *)cursor;
+  cursor += (size_t)count * sizeof(T);
+  return array;
+}
+
+/** Slots in use, ascending. slots has room for the pool's capacity. */
+struct ActiveList {
+  uint8_t *slots;
+  int count;
+};
+
+/**
+ * activeLowestFree()
+ *
+ * @param list      Slots in use
+ * @param capacity  Slots in the pool
+ * @return          The lowest slot not in list, or -1 if all are in use
+ */
+static inline int activeLowestFree(const ActiveList &list, int capacity) {
+  int slot = 0;
+  while (slot < list.count && list.slots[slot] == slot) slot++;
+  return slot < capacity ? slot : -1;
+}
+
+/**
+ * activeInsert()
+ *
+ * Adds slot (not yet in list) at its place in ascending order.
+ */
+static inline void activeInsert(ActiveList &list, int slot) {
+  int pos = list.count;
+  while (pos > 0 && list.slots[pos - 1] > slot) pos--;
+  memmove(list.slots + pos + 1, list.slots + pos, list.count - pos);
+  list.slots[pos] = slot;
+  list.count++;
+}
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * profiler.cpp
+ *
+ * Implements the frame profiler declared in profiler.h. Phase durations
+ * are binned into a two-speed histogram: 32 us buckets up to 4 ms (where
+ * individual phases live) and 512 us buckets beyond that (whole frames
+ * and overruns), which keeps p99 meaningful for both without storing any
+ * samples.
+ */
+
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include "fastdraw.h"
+
+static const int PROFILE_BUCKETS = 256;
+static const int FINE_BUCKETS = 128;        // 32 us each, 0..4096 us
+static const unsigned long FINE_LIMIT = 4096;
+
+/** Running stats for one phase. */
+struct PhaseStats {
+  unsigned long minMicros;
+  unsigned long maxMicros;
+  unsigned long lastMicros;
+  uint64_t totalMicros;
+  uint32_t histogram[PROFILE_BUCKETS];
+};
+
+static PhaseStats stats[PROFILE_PHASE_COUNT];
+static unsigned long frameAccum[PROFILE_PHASE_COUNT];
+static uint32_t frameCount = 0;
+static uint32_t missedFrames = 0;
+static unsigned long frameStartMicros = 0;
+static unsigned long lastMarkMicros = 0;
+static bool overlayEnabled = false;
+
+static const char *phaseNames[PROFILE_PHASE_COUNT] = {"update", "clear", "draw", "show", "frame"};
+
+/**
+ * bucketFor()
+ *
+ * Histogram bucket index for a duration.
+ */
+static int bucketFor(unsigned long micros) {
+  if (micros < FINE_LIMIT) return micros >> 5;
+  unsigned long coarse = FINE_BUCKETS + ((micros - FINE_LIMIT) >> 9);
+  return coarse < (unsigned long)PROFILE_BUCKETS ? coarse : PROFILE_BUCKETS - 1;
+}
+
+/**
+ * bucketUpperBound()
+ *
+ * Largest duration that lands in the given bucket (used to report p99).
+ */
+static unsigned long bucketUpperBound(int bucket) {
+  if (bucket < FINE_BUCKETS) return ((unsigned long)bucket + 1) * 32 - 1;
+  return FINE_LIMIT + ((unsigned long)(bucket - FINE_BUCKETS) + 1) * 512 - 1;
+}
+
+void profileReset() {
+  for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+    stats[p].minMicros = ~0UL;
+    stats[p].maxMicros = 0;
+    stats[p].lastMicros = 0;
+    stats[p].totalMicros = 0;
+    for (int b = 0; b < PROFILE_BUCKETS; b++) stats[p].histogram[b] = 0;
+  }
+  frameCount = 0;
+  missedFrames = 0;
+}
+
+void profileFrameStart() {
+  frameStartMicros = micros();
+  lastMarkMicros = frameStartMicros;
+  for (int p = 0; p < PROFILE_PHASE_COUNT; p++) frameAccum[p] = 0;
+}
+
+void profileMark(ProfilePhase phase) {
+  unsigned long now = micros();
+  frameAccum[phase] += now - lastMarkMicros;
+  lastMarkMicros = now;
+}
+
+void profileFrameEnd(unsigned long budgetMicros) {
+  frameAccum[PHASE_FRAME] = micros() - frameStartMicros;
+  for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+    unsigned long t = frameAccum[p];
+    PhaseStats &s = stats[p];
+    s.lastMicros = t;
+    s.totalMicros += t;
+    if (frameCount == 0 || t < s.minMicros) s.minMicros = t;
+    if (t > s.maxMicros) s.maxMicros = t;
+    s.histogram[bucketFor(t)]++;
+  }
+  frameCount++;
+  if (frameAccum[PHASE_FRAME] > budgetMicros) missedFrames++;
+}
+
+/**
+ * percentile()
+ *
+ * Upper bound of the bucket containing the given percentile.
+ */
+static unsigned long percentile(const PhaseStats &s, uint32_t pct) {
+  uint32_t target = (uint32_t)(((uint64_t)frameCount * pct + 99) / 100);
+  uint32_t seen = 0;
+  for (int b = 0; b < PROFILE_BUCKETS; b++) {
+    seen += s.histogram[b];
+    if (seen >= target) return min(bucketUpperBound(b), s.maxMicros);
+  }
+  return s.maxMicros;
+}
+
+void profilePrint() {
+  Serial.printf("frames %lu  missed %lu\n", (unsigned long)frameCount, (unsigned long)missedFrames);
+  if (frameCount == 0) return;
+  Serial.println("phase      min     avg     p99     max  (us)");
+  for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+    const PhaseStats &s = stats[p];
+    Serial.printf("%-7s %6lu  %6lu  %6lu  %6lu\n", phaseNames[p], s.minMicros,
+                  (unsigned long)(s.totalMicros / frameCount), percentile(s, 99), s.maxMicros);
+  }
+}
+
+void profileSetOverlay(bool enabled) {
+  overlayEnabled = enabled;
+}
+
+bool profileOverlayEnabled() {
+  return overlayEnabled;
+}
+
+void profileDrawOverlay(GFXcanvas16 &matrix, unsigned long budgetMicros) {
+  if (!overlayEnabled || frameCount == 0) return;
+
+  static const uint16_t phaseColors[PHASE_FRAME] = {
+    Adafruit_Protomatter::color565(0, 80, 255),    // update: blue
+    Adafruit_Protomatter::color565(0, 200, 0),     // clear: green
+    Adafruit_Protomatter::color565(255, 200, 0),   // draw: yellow
+    Adafruit_Protomatter::color565(220, 0, 220),   // show: magenta
+  };
+  int x = matrix.width() - 2;
+  int maxRows = PROFILE_OVERLAY_BUDGET_PX * 3 / 2;
+
+  // The overlay owns its strip: wipe it so old bars never linger
+  fastFillRect(matrix, x, 0, 2, maxRows + 1, 0);
+
+  int y = 0;
+  for (int p = 0; p < PHASE_FRAME && y < maxRows; p++) {
+    int rows = (int)((uint64_t)stats[p].lastMicros * PROFILE_OVERLAY_BUDGET_PX / budgetMicros);
+    rows = min(rows, maxRows - y);
+    fastFillRect(matrix, x, y, 2, rows, phaseColors[p]);
+    y += rows;
+  }
+  // Budget tick turns red while the last frame overran
+  bool overran = stats[PHASE_FRAME].lastMicros > budgetMicros;
+  uint16_t tickColor = overran ? Adafruit_Protomatter::color565(255, 0, 0) : Adafruit_Protomatter::color565(255, 255, 255);
+  fastFillRect(matrix, x - 2, PROFILE_OVERLAY_BUDGET_PX, 4, 1, tickColor);
+}
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * profiler.h
+ *
+ * Frame-time instrumentation for the render loop. Each frame is split
+ * into phases (update, clear, draw, show); the scenes call profileMark()
+ * at the end of each stretch of work and the elapsed time since the
+ * previous mark is charged to that phase. Per-phase min/avg/max/p99 are
+ * kept in a histogram so percentiles cost nothing to maintain, along with
+ * a count of frames that overran their budget.
+ *
+ * Stats are printed over Serial on demand and can optionally be drawn as
+ * a small stacked bar graph along the right edge of the matrix.
+ *
+ * Build with PROFILER_ENABLED 0 to compile every call away.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Adafruit_Protomatter.h>
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+/**
+ * ProfilePhase
+ *
+ * Buckets of work within a frame. PHASE_FRAME is the whole frame from
+ * profileFrameStart() to profileFrameEnd() and is recorded automatically.
+ */
+enum ProfilePhase {
+  PHASE_UPDATE,   // Scene simulation: movement, spawning, state machines
+  PHASE_CLEAR,    // Erasing the previous frame
+  PHASE_DRAW,     // Rasterizing the scene into the canvas
+  PHASE_SHOW,     // matrix.show(): canvas to bit-plane conversion and swap
+  PHASE_FRAME,    // Total frame time
+  PROFILE_PHASE_COUNT
+};
+
+#if PROFILER_ENABLED
+
+/** Overlay rows that represent one full frame budget. */
+const int PROFILE_OVERLAY_BUDGET_PX = 120;
+
+/** Starts timing a new frame. Call right before the scene's draw function. */
+void profileFrameStart();
+
+/**
+ * profileMark()
+ *
+ * Charges the time since the previous mark (or frame start) to phase.
+ * A phase may be marked several times per frame; the pieces add up.
+ *
+ * @param phase  Phase the just-finished work belongs to
+ */
+void profileMark(ProfilePhase phase);
+
+/**
+ * profileFrameEnd()
+ *
+ * Closes the frame, folds its phase times into the running stats, and
+ * counts it as missed if the total exceeded the frame budget.
+ *
+ * @param budgetMicros  Time available per frame (e.g. 1000000 / 60)
+ */
+void profileFrameEnd(unsigned long budgetMicros);
+
+/** Prints min/avg/p99/max for every phase plus missed frames over Serial. */
+void profilePrint();
+
+/** Clears all accumulated stats. */
+void profileReset();
+
+/** Enables or disables the on-matrix bar graph. */
+void profileSetOverlay(bool enabled);
+
+/** True while the on-matrix bar graph is enabled. */
+bool profileOverlayEnabled();
+
+/**
+ * profileDrawOverlay()
+ *
+ * Draws the last frame's phase times as a stacked 2-pixel bar along the
+ * right edge, scaled so the frame budget is PROFILE_OVERLAY_BUDGET_PX
+ * rows; a white tick marks the budget line. Does nothing when disabled.
+ *
+ * @param matrix        Canvas to draw into
+ * @param budgetMicros  Time available per frame
+ */
+void profileDrawOverlay(GFXcanvas16 &matrix, unsigned long budgetMicros);
+
+#else
+
+inline void profileFrameStart() {}
+inline void profileMark(ProfilePhase) {}
+inline void profileFrameEnd(unsigned long) {}
+inline void profilePrint() {}
+inline void profileReset() {}
+inline void profileSetOverlay(bool) {}
+inline bool profileOverlayEnabled() { return false; }
+inline void profileDrawOverlay(GFXcanvas16 &, unsigned long) {}
+
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * replay.cpp
+ *
+ * Implements the replay scenario declared in replay.h. The request and
+ * the finished result cross between the loop task and the render thread
+ * through atomics; everything else is touched by the render thread only.
+ */
+
+#include "replay.h"
+#include <atomic>
+#include "analog.h"
+#include "config.h"
+#include "digital.h"
+#include "governor.h"
+#include "scenerandom.h"
+#include "transition.h"
+
+static const int TIME_BUCKETS = 256;
+static const unsigned long BUCKET_MICROS = 64;   // 0 .. ~16 ms, slower frames in the last bucket
+
+// Request (written by the loop task, taken by the renderer)
+static std::atomic<bool> requested(false);
+static volatile int requestFrames = 0;
+static volatile uint32_t requestSeed = 0;
+static volatile int requestRestoreLevel = -1;
+
+// Run state (render thread)
+static volatile bool running = false;
+static int totalFrames = 0;
+static int frame = 0;
+static bool replayAnalog = true;
+static uint64_t savedRandomState = 0;
+static int restoreLevel = -1;
+static uint32_t seed = 0;
+
+// Result (filled by the render thread, printed by the loop task)
+static uint32_t histogram[TIME_BUCKETS];
+static unsigned long minMicros = 0;
+static unsigned long maxMicros = 0;
+static uint64_t totalMicros = 0;
+static uint64_t pixelHash = 0;
+static bool failed = false;
+static std::atomic<bool> resultReady(false);
+
+void replayStart(int frames, uint32_t replaySeed, int level) {
+  if (frames <= 0 || replayActive()) return;
+  requestFrames = frames;
+  requestSeed = replaySeed;
+  requestRestoreLevel = level;
+  requested.store(true, std::memory_order_release);
+}
+
+bool replayActive() {
+  return requested.load(std::memory_order_acquire) || running;
+}
+
+/**
+ * hashCanvas()
+ *
+ * Folds the canvas pixels into the running FNV-1a hash.
+ */
+static void hashCanvas(GFXcanvas16 &canvas) {
+  const uint16_t *pixels = canvas.getBuffer();
+  uint32_t count = (uint32_t)canvas.width() * canvas.height();
+  uint64_t h = pixelHash;
+  for (uint32_t i = 0; i < count; i++) {
+    h ^= pixels[i];
+    h *= 1099511628211ULL;
+  }
+  pixelHash = h;
+}
+
+/**
+ * beginReplay()
+ *
+ * Takes the pending request: saves the generator state, rebuilds both
+ * scenes from the seed on a black canvas and pins full quality.
+ */
+static void beginReplay(GFXcanvas16 &canvas) {
+  totalFrames = requestFrames;
+  seed = requestSeed;
+  restoreLevel = requestRestoreLevel;
+  frame = 0;
+  replayAnalog = true;
+  for (int b = 0; b < TIME_BUCKETS; b++) histogram[b] = 0;
+  minMicros = ~0UL;
+  maxMicros = 0;
+  totalMicros = 0;
+  pixelHash = 14695981039346656037ULL;
+
+  savedRandomState = sceneRandomState();
+  transitionCancel();
+  canvas.fillScreen(0);
+  sceneRandomSeed(seed);
+  failed = !initDigital(canvas, config.digitCharCount, config.charScale, config.maxEyes, config.digitTrail) ||
+           !initAnalog(canvas, config.maxWaves, config.waveGlow != 0);
+  governorForceLevel(QUALITY_FULL);
+  running = true;
+}
+
+/**
+ * endReplay()
+ *
+ * Hands the result to the loop task and puts the show back: generator
+ * state, governor mode, and a full analog repaint.
+ */
+static void endReplay() {
+  running = false;
+  sceneRandomRestore(savedRandomState);
+  governorForceLevel(restoreLevel);
+  invalidateAnalog();
+  resultReady.store(true, std::memory_order_release);
+}
+
+/**
+ * drawScenarioFrame()
+ *
+ * Frame number frame of the fixed scenario.
+ */
+static void drawScenarioFrame(GFXcanvas16 &canvas) {
+  if (frame > 0 && frame % REPLAY_SWITCH_FRAMES == 0) {
+    replayAnalog = !replayAnalog;
+    if (replayAnalog) invalidateAnalog();
+    transitionBegin(canvas, config.fadeFrames);
+  }
+  if (!replayAnalog && frame % REPLAY_TRIGGER_FRAMES == 0) {
+    digitalTrigger(canvas, (frame / REPLAY_TRIGGER_FRAMES) % REPLAY_SENSORS, REPLAY_SENSORS);
+  }
+  if (transitionActive()) {
+    transitionRender(canvas, replayAnalog ? drawDigital : drawAnalog, replayAnalog ? drawAnalog : drawDigital);
+  } else if (replayAnalog) {
+    drawAnalog(canvas);
+  } else {
+    drawDigital(canvas);
+  }
+}
+
+bool replayRender(GFXcanvas16 &canvas) {
+  if (!running) {
+    if (!requested.load(std::memory_order_acquire)) return false;
+    beginReplay(canvas);
+    requested.store(false, std::memory_order_release);
+    if (failed) {
+      endReplay();
+      return false;
+    }
+  }
+
+  unsigned long start = micros();
+  drawScenarioFrame(canvas);
+  unsigned long elapsed = micros() - start;
+
+  unsigned long bucket = elapsed / BUCKET_MICROS;
+  histogram[bucket < (unsigned long)TIME_BUCKETS ? bucket : TIME_BUCKETS - 1]++;
+  if (elapsed < minMicros) minMicros = elapsed;
+  if (elapsed > maxMicros) maxMicros = elapsed;
+  totalMicros += elapsed;
+  hashCanvas(canvas);
+
+  if (++frame >= totalFrames) endReplay();
+  return true;
+}
+
+/**
+ * percentile()
+ *
+ * Upper edge of the bucket holding the given percentile, capped at the
+ * slowest frame.
+ */
+static unsigned long percentile(uint32_t pct) {
+  uint32_t target = (uint32_t)(((uint64_t)totalFrames * pct + 99) / 100);
+  uint32_t seen = 0;
+  for (int b = 0; b < TIME_BUCKETS; b++) {
+    seen += histogram[b];
+    if (seen >= target) return min((b + 1) * BUCKET_MICROS - 1, maxMicros);
+  }
+  return maxMicros;
+}
+
+void replayPoll() {
+  if (!resultReady.load(std::memory_order_acquire)) return;
+  resultReady.store(false, std::memory_order_relaxed);
+  if (failed) {
+    Serial.println("replay: scene allocation failed");
+    return;
+  }
+  Serial.printf("replay seed %lu, %d frames: render us min %lu avg %lu p50 %lu p99 %lu max %lu, pixels %016llx\n",
+                (unsigned long)seed, totalFrames, minMicros, (unsigned long)(totalMicros / totalFrames),
+                percentile(50), percentile(99), maxMicros, (unsigned long long)pixelHash);
+}
@@ -0,0 +1,71 @@
+/**
+ * replay.h
+ *
+ * Deterministic replay for comparing frame cost across firmware builds.
+ * A replay reseeds the scene generator (scenerandom.h), rebuilds both
+ * scenes from scratch, pins the governor at full quality, then renders
+ * a fixed scenario for N frames:
+ *   - analog first, switching mode (with the configured cross-fade)
+ *     every REPLAY_SWITCH_FRAMES frames
+ *   - while digital, a trigger from the next of REPLAY_SENSORS sensors
+ *     every REPLAY_TRIGGER_FRAMES frames
+ * Each frame's render time is recorded, and every finished frame is
+ * hashed outside the timed region. At the end it prints a signature:
+ * render time min/avg/p50/p99/max and the pixel hash.
+ *
+ * The host bench runs the same scenario (bench --mode replay). With the
+ * same seed, frame count and settings, both print the same pixel hash.
+ * The timings can then be compared like-for-like, and a hash mismatch
+ * means a build changed what is drawn. Afterwards the generator state
+ * and governor setting are restored, and the show carries on.
+ *
+ * Serial 'b' starts a REPLAY_DEFAULT_FRAMES replay with
+ * REPLAY_DEFAULT_SEED, matching the bench's defaults.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <Adafruit_Protomatter.h>
+
+const int REPLAY_SWITCH_FRAMES = 240;
+const int REPLAY_TRIGGER_FRAMES = 45;
+const int REPLAY_SENSORS = 5;
+const int REPLAY_DEFAULT_FRAMES = 3600;
+const uint32_t REPLAY_DEFAULT_SEED = 1;
+
+/**
+ * replayStart()
+ *
+ * Asks the renderer to run a replay from its next frame. Ignored while
+ * one is already running.
+ *
+ * @param frames        Frames to render
+ * @param seed          Scene generator seed
+ * @param restoreLevel  Governor level to return to afterwards (-1 = automatic)
+ */
+void replayStart(int frames, uint32_t seed, int restoreLevel);
+
+/** True from replayStart() until the last replay frame has rendered. */
+bool replayActive();
+
+/**
+ * replayRender()
+ *
+ * Renders the next replay frame into canvas if a replay is running.
+ * Call at the top of the scene render function, on the render thread.
+ *
+ * @param canvas  The output canvas
+ * @return        true if a replay frame was drawn and the normal scene
+ *                should be skipped this frame
+ */
+bool replayRender(GFXcanvas16 &canvas);
+
+/**
+ * replayPoll()
+ *
+ * Prints the signature once a replay has finished. Call from loop().
+ */
+void replayPoll();
+
+#endif
@@ -0,0 +1,47 @@
+/**
+ * scenerandom.cpp
+ *
+ * PCG32 (XSH RR output, 64-bit LCG state, fixed stream) as described by
+ * O'Neill. Bounded draws use a 32x32->64 multiply instead of a modulo;
+ * the bias is below 2^-20 for every range the scenes use.
+ */
+
+#include "scenerandom.h"
+
+static const uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+static const uint64_t PCG_INCREMENT = 1442695040888963407ULL;
+
+static uint64_t state = 0x853C49E6748FEA9BULL;
+
+void sceneRandomSeed(uint64_t seed) {
+  state = 0;
+  sceneRandomNext();
+  state += seed;
+  sceneRandomNext();
+}
+
+uint64_t sceneRandomState() {
+  return state;
+}
+
+void sceneRandomRestore(uint64_t saved) {
+  state = saved;
+}
+
+uint32_t sceneRandomNext() {
+  uint64_t old = state;
+  state = old * PCG_MULTIPLIER + PCG_INCREMENT;
+  uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+  uint32_t rot = (uint32_t)(old >> 59);
+  return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+long sceneRandom(long howbig) {
+  if (howbig <= 0) return 0;
+  return (long)(((uint64_t)sceneRandomNext() * (uint32_t)howbig) >> 32);
+}
+
+long sceneRandom(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return sceneRandom(howbig - howsmall) + howsmall;
+}
@@ -0,0 +1,49 @@
+/**
+ * scenerandom.h
+ *
+ * The scenes' own random number generator. Every spawn, shape, color,
+ * blink and background drift in analog.cpp and digital.cpp draws from
+ * this PCG32 generator instead of Arduino random(), so a run is fully
+ * determined by its seed on any target. The host bench and the replay
+ * mode (replay.h) rely on this. The whole state is one 64-bit word that
+ * can be read and restored, so the normal show can resume after a replay.
+ *
+ * Scene code runs on one thread (the render task under the pipeline), so
+ * the generator is a single unsynchronized global. Anything else that
+ * needs randomness (seeding, hardware) keeps using random().
+ */
+
+#ifndef SCENERANDOM_H
+#define SCENERANDOM_H
+
+#include <stdint.h>
+
+/** Restarts the sequence from seed. */
+void sceneRandomSeed(uint64_t seed);
+
+/** The generator state, for sceneRandomRestore(). */
+uint64_t sceneRandomState();
+
+/** Continues the sequence from a state returned by sceneRandomState(). */
+void sceneRandomRestore(uint64_t state);
+
+/** Next 32 uniformly distributed bits. */
+uint32_t sceneRandomNext();
+
+/**
+ * sceneRandom()
+ *
+ * Drop-in for Arduino random(howbig): a value in [0, howbig), or 0 if
+ * howbig is not positive.
+ */
+long sceneRandom(long howbig);
+
+/**
+ * sceneRandom()
+ *
+ * Drop-in for Arduino random(howsmall, howbig): a value in
+ * [howsmall, howbig), or howsmall if the range is empty.
+ */
+long sceneRandom(long howsmall, long howbig);
+
+#endif
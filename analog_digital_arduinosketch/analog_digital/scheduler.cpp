@@ -0,0 +1,102 @@
+/**
+ * scheduler.cpp
+ *
+ * Implements the frame deadlines and FreeRTOS sleeping described in
+ * scheduler.h. Deadlines belong to the thread that paces frames (the
+ * render task with the pipeline, else the loop task); wake-ups may come
+ * from any task or an ISR.
+ */
+
+#include "scheduler.h"
+#include <atomic>
+
+static unsigned long framePeriod = 1000000 / 60;
+static unsigned long lastDeadline = 0;
+
+void schedulerBegin(unsigned long microsPerFrame) {
+  framePeriod = microsPerFrame;
+  lastDeadline = micros();
+}
+
+bool schedulerFrameDue() {
+  long late = (long)(micros() - (lastDeadline + framePeriod));
+  if (late < 0) return false;
+  lastDeadline += framePeriod;
+  // Fell more than a frame behind: start over from now
+  if (late > (long)framePeriod) lastDeadline = micros();
+  return true;
+}
+
+unsigned long schedulerNextFrame() {
+  return lastDeadline + framePeriod;
+}
+
+#if FRAME_SCHEDULER
+
+static const int MAX_SLEEPERS = 2;  // The loop task and the render task
+static std::atomic<TaskHandle_t> sleepers[MAX_SLEEPERS];
+static std::atomic<bool> pinChanged(false);
+
+// Sleep stats since the last schedulerPrintStats()
+static std::atomic<uint32_t> sleeps(0);
+static std::atomic<uint32_t> sleptUnits(0);  // 64 us units, so days fit
+static unsigned long statsSince = 0;          // millis()
+
+/** Records the calling task so wake-ups can reach it. */
+static void registerSleeper(TaskHandle_t self) {
+  for (int i = 0; i < MAX_SLEEPERS; i++) {
+    TaskHandle_t expected = NULL;
+    if (sleepers[i].compare_exchange_strong(expected, self) || expected == self) return;
+  }
+}
+
+void schedulerSleep(unsigned long deadline) {
+  long remaining = (long)(deadline - micros());
+  if (remaining <= 0) return;
+  if (remaining > (long)SCHEDULER_MAX_SLEEP_MICROS) remaining = SCHEDULER_MAX_SLEEP_MICROS;
+  registerSleeper(xTaskGetCurrentTaskHandle());
+  const long tickMicros = portTICK_PERIOD_MS * 1000L;
+  unsigned long start = micros();
+  ulTaskNotifyTake(pdTRUE, (remaining + tickMicros - 1) / tickMicros);
+  sleeps.fetch_add(1, std::memory_order_relaxed);
+  sleptUnits.fetch_add((micros() - start) >> 6, std::memory_order_relaxed);
+}
+
+void schedulerWake() {
+  TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  for (int i = 0; i < MAX_SLEEPERS; i++) {
+    TaskHandle_t task = sleepers[i].load();
+    if (task != NULL && task != self) xTaskNotifyGive(task);
+  }
+}
+
+static void IRAM_ATTR pinInterrupt() {
+  pinChanged.store(true);
+  BaseType_t woken = pdFALSE;
+  for (int i = 0; i < MAX_SLEEPERS; i++) {
+    TaskHandle_t task = sleepers[i].load();
+    if (task != NULL) vTaskNotifyGiveFromISR(task, &woken);
+  }
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void schedulerWatchPin(uint8_t pin) {
+  pinChanged.store(true);
+  attachInterrupt(digitalPinToInterrupt(pin), pinInterrupt, CHANGE);
+}
+
+bool schedulerPinChanged() {
+  return pinChanged.exchange(false);
+}
+
+void schedulerPrintStats() {
+  // Both tasks sleep, so the share can reach 200%
+  unsigned long now = millis();
+  unsigned long window = now - statsSince;
+  uint64_t slept = (uint64_t)sleptUnits.exchange(0) << 6;
+  Serial.printf("scheduler: %lu sleeps, asleep %lu%% of the last %lu ms (loop + render task)\n",
+                (unsigned long)sleeps.exchange(0), window > 0 ? (unsigned long)(slept / 10 / window) : 0UL, window);
+  statsSince = now;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * scheduler.h
+ *
+ * Power-aware frame scheduling. Without it the loop task re-runs loop()
+ * flat out between frames, re-reading A1 every pass, and the core never
+ * gets to idle. The scheduler:
+ *   - sleeps the loop task (and the render task, see pipeline.h) in
+ *     FreeRTOS blocking waits until the next frame deadline, at most
+ *     SCHEDULER_MAX_SLEEP_MICROS at a time so serial, the trigger link
+ *     and the network are still polled often enough. Blocked tasks let
+ *     the idle task clock-gate the core.
+ *   - watches the mode switch pin by interrupt, so the loop only reads it
+ *     when it changed, and the change wakes it at once.
+ *
+ * Real light sleep is not used: it stops the clocks the HUB75 refresh
+ * runs on, and the wall would go dark between frames.
+ *
+ * Sleeping and the pin interrupt need FreeRTOS. Enabled by default on
+ * ESP32 targets; with FRAME_SCHEDULER 0 the loop spins and polls A1 as
+ * before. A sharded wall keeps its own pacing (see shard.h), and the
+ * network sink is polled without sleeping while it streams.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Adafruit_Protomatter.h>
+
+#ifndef FRAME_SCHEDULER
+#if defined(ARDUINO_ARCH_ESP32)
+#define FRAME_SCHEDULER 1
+#else
+#define FRAME_SCHEDULER 0
+#endif
+#endif
+
+const unsigned long SCHEDULER_MAX_SLEEP_MICROS = 2000;
+
+/**
+ * schedulerBegin()
+ *
+ * Starts pacing frames microsPerFrame apart, the first one a period
+ * from now.
+ *
+ * @param microsPerFrame  Frame period
+ */
+void schedulerBegin(unsigned long microsPerFrame);
+
+/**
+ * schedulerFrameDue()
+ *
+ * True once the current frame deadline has passed; the deadline then
+ * moves on by one frame period. A frame more than a period late does not
+ * cause a catch-up burst. Call from the thread that paces frames.
+ */
+bool schedulerFrameDue();
+
+/** micros() at which the next frame is due. */
+unsigned long schedulerNextFrame();
+
+#if FRAME_SCHEDULER
+
+/**
+ * schedulerSleep()
+ *
+ * Blocks the calling task until deadline (micros()), for at most
+ * SCHEDULER_MAX_SLEEP_MICROS, or until schedulerWake() or a watched pin
+ * change. Sleeps whole ticks and may wake up to one tick late rather
+ * than spin. Callers re-check what they wait for.
+ */
+void schedulerSleep(unsigned long deadline);
+
+/** Wakes every task sleeping in schedulerSleep() other than the caller. */
+void schedulerWake();
+
+/**
+ * schedulerWatchPin()
+ *
+ * Attaches a change interrupt to pin (already configured as an input).
+ * schedulerPinChanged() then reports true once, so the first read happens.
+ */
+void schedulerWatchPin(uint8_t pin);
+
+/** True (once) if the watched pin changed since the last call. */
+bool schedulerPinChanged();
+
+/** Prints sleep stats over Serial. */
+void schedulerPrintStats();
+
+#endif
+
+#endif
@@ -0,0 +1,440 @@
+/**
+ * shard.cpp
+ *
+ * Implements the sharded wall declared in shard.h. Everything runs on the
+ * loop task.
+ *
+ * Frame numbers count from 0 at the start of each epoch. Inputs are kept
+ * in a ring of SHARD_HISTORY entries indexed by frame. A pulse for frame
+ * f refills the entries after the newest known frame (knownFrame), and a
+ * follower can render any frame up to knownFrame whose entry has not yet
+ * been overwritten.
+ */
+
+#include "shard.h"
+#include <string.h>
+#include "analog.h"
+#include "config.h"
+#include "digital.h"
+#include "fastdraw.h"
+#include "governor.h"
+#include "network.h"
+#include "scenerandom.h"
+#include "transition.h"
+
+#if WALL_SHARDING
+#if !NETWORK_WIFI
+#error "WALL_SHARDING needs WiFi: define WIFI_SSID and WIFI_PASSWORD (see network.h)"
+#endif
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#endif
+
+static const uint8_t SHARD_VERSION = 1;
+static const int SHARD_INPUT_BYTES = 7;
+static const int CLOCK_WINDOW_PULSES = 120;             // Offset minimum kept over 2-4 s
+static const uint32_t JOIN_INTERVAL_MICROS = 1000000;   // Follower: join requests at most 1/s
+static const uint32_t EPOCH_HOLD_MICROS = 2000000;      // Leader: restarts at most every 2 s
+static const uint32_t LATE_MICROS = 2000;               // Shown this late counts as late
+static const int MAX_PACKETS_PER_POLL = 16;
+
+// Geometry
+static GFXcanvas16 *wall = NULL;
+static int nodeCount = 0;
+static int nodeIndex = 0;
+static int16_t viewportY = 0;    // First wall row of this node
+
+// Simulation
+static bool synced = false;      // Following an epoch (always, on the leader)
+static uint32_t epoch = 0;
+static int32_t renderedFrame = -1;
+static int32_t knownFrame = -1;
+static ShardInput inputs[SHARD_HISTORY];
+static bool simAnalog = true;
+static bool scenesFailed = false;
+
+// Presentation
+static bool presentPending = false;
+static int32_t presentFrame = 0;
+static int32_t lastScheduled = -1;     // Newest frame ever scheduled this epoch
+static uint32_t presentAtMicros = 0;   // Local clock
+
+// Follower clock: smallest (arrival - leader time) this window and last
+static bool clockValid = false;
+static int32_t offsetMin = 0;
+static int32_t offsetPreviousMin = 0;
+static int windowPulses = 0;
+
+// Leader
+static uint8_t pulse[SHARD_PULSE_BYTES];
+static bool pulsePending = false;
+static bool joinRequested = false;
+static uint32_t epochStartMicros = 0;
+
+// Follower
+static uint32_t lastJoinMicros = 0;
+static bool joinSent = false;
+
+// Stats
+static uint32_t epochsStarted = 0;
+static uint32_t framesShown = 0;
+static uint32_t framesLate = 0;
+static uint32_t framesMissed = 0;      // Never shown (pulse lost, or not rendered in time)
+static uint32_t pulsesReceived = 0;
+static uint32_t pulsesRejected = 0;
+static uint32_t resyncs = 0;
+
+#if WALL_SHARDING
+static WiFiUDP udp;
+static IPAddress leaderAddress;
+static bool leaderKnown = false;
+#endif
+
+static void put32(uint8_t *p, uint32_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t *p) {
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static ShardInput &inputFor(int32_t frame) {
+  return inputs[frame % SHARD_HISTORY];
+}
+
+/**
+ * beginEpoch()
+ *
+ * Starts the shared simulation over from seed: both scenes rebuilt for
+ * the whole wall on a black canvas, the same way on every node.
+ */
+static void beginEpoch(uint32_t seed) {
+  epoch = seed;
+  renderedFrame = -1;
+  knownFrame = -1;
+  presentPending = false;
+  lastScheduled = -1;
+  simAnalog = true;
+  transitionCancel();
+  wall->fillScreen(0);
+  sceneRandomSeed(seed);
+  scenesFailed = !initDigital(*wall, config.digitCharCount, config.charScale, config.maxEyes, config.digitTrail) ||
+                 !initAnalog(*wall, config.maxWaves, config.waveGlow != 0);
+  synced = !scenesFailed;
+  epochsStarted++;
+}
+
+bool shardBegin(GFXcanvas16 &canvas, int nodes, int node, uint32_t seed) {
+  if (nodes < 2 || nodes > SHARD_MAX_NODES || node < 0 || node >= nodes) return false;
+  nodeCount = nodes;
+  nodeIndex = node;
+  viewportY = node * canvas.height();
+
+  // Physical geometry: the chain grows along the raw width
+  uint8_t rotation = canvas.getRotation();
+  canvas.setRotation(0);
+  delete wall;
+  wall = new GFXcanvas16(canvas.width() * nodes, canvas.height());
+  canvas.setRotation(rotation);
+  if (wall == NULL || wall->getBuffer() == NULL) return false;
+  wall->setRotation(rotation);
+  // Simulate the whole wall, but paint only the rows this node shows
+  fastDrawSetWindow(wall->height(), viewportY, viewportY + canvas.height());
+  // Wall-sized fade layers, once, in place of the single chain's
+  if (!transitionAllocate(*wall, config.fadeFrames)) {
+    Serial.println("shard: no memory for the fade layers, mode switches cut");
+  }
+
+  synced = false;
+  clockValid = false;
+  joinSent = false;
+  epochsStarted = framesShown = framesLate = framesMissed = 0;
+  pulsesReceived = pulsesRejected = resyncs = 0;
+  if (shardLeader()) {
+    beginEpoch(seed);
+    if (scenesFailed) return false;
+  }
+
+#if WALL_SHARDING
+  networkBegin();
+  udp.begin(SHARD_PORT);
+#endif
+  return true;
+}
+
+bool shardLeader() {
+  return nodeIndex == 0;
+}
+
+/**
+ * copyViewport()
+ *
+ * Copies this node's rows of the wall into canvas. At rotation 1 they are
+ * one contiguous stretch of each framebuffer line.
+ */
+static void copyViewport(GFXcanvas16 &canvas) {
+  if (!fastDrawAvailable(canvas)) {
+    for (int16_t y = 0; y < canvas.height(); y++) {
+      for (int16_t x = 0; x < canvas.width(); x++) {
+        canvas.drawPixel(x, y, wall->getPixel(x, viewportY + y));
+      }
+    }
+    return;
+  }
+  int16_t lineLength = canvas.height();
+  int16_t wallLineLength = wall->height();
+  const uint16_t *from = wall->getBuffer() + (wallLineLength - viewportY - lineLength);
+  uint16_t *to = canvas.getBuffer();
+  for (int16_t x = 0; x < canvas.width(); x++) {
+    memcpy(to + (int32_t)x * lineLength, from + (int32_t)x * wallLineLength, lineLength * sizeof(uint16_t));
+  }
+}
+
+/**
+ * renderFrame()
+ *
+ * Renders frame renderedFrame + 1 of the wall from its inputs, the way
+ * renderScene() renders a frame on a single chain.
+ */
+static void renderFrame() {
+  int32_t frame = renderedFrame + 1;
+  const ShardInput &input = inputFor(frame);
+  // The leader's own governor chose this level; followers follow it
+  if (!shardLeader()) governorForceLevel(input.quality);
+
+  uint32_t triggers = input.triggers;
+  for (int sensor = 0; triggers != 0; sensor++, triggers >>= 1) {
+    if (triggers & 1) digitalTrigger(*wall, sensor, input.sensorCount);
+  }
+  bool analog = input.analog != 0;
+  if (analog != simAnalog) {
+    if (analog) invalidateAnalog();
+    transitionBegin(*wall, config.fadeFrames);
+    simAnalog = analog;
+  }
+  if (transitionActive()) {
+    transitionRender(*wall, analog ? drawDigital : drawAnalog, analog ? drawAnalog : drawDigital);
+  } else if (analog) {
+    drawAnalog(*wall);
+  } else {
+    drawDigital(*wall);
+  }
+  renderedFrame = frame;
+}
+
+/**
+ * schedulePresent()
+ *
+ * Asks for frame to be shown at local time atMicros. A frame still due
+ * from an earlier pulse is given up: showing it now would be out of step.
+ */
+static void schedulePresent(int32_t frame, uint32_t atMicros) {
+  if (presentPending) framesMissed++;
+  framesMissed += frame - lastScheduled - 1;
+  lastScheduled = frame;
+  presentPending = true;
+  presentFrame = frame;
+  presentAtMicros = atMicros;
+}
+
+bool shardLeaderReady() {
+  return renderedFrame == knownFrame;
+}
+
+void shardLeaderTick(const ShardInput &input, uint32_t nowMicros, uint8_t *packet) {
+  if (joinRequested) {
+    joinRequested = false;
+    epochStartMicros = nowMicros;
+    beginEpoch(epoch * 1664525UL + 1013904223UL + nowMicros);
+  }
+  int32_t frame = knownFrame + 1;
+  inputFor(frame) = input;
+  knownFrame = frame;
+  uint32_t presentAt = nowMicros + SHARD_PRESENT_DELAY_US;
+  if (frame > 0) schedulePresent(frame - 1, presentAt);
+
+  memcpy(pulse, "ADSP", 4);
+  pulse[4] = SHARD_VERSION;
+  pulse[5] = nodeCount;
+  put32(pulse + 6, epoch);
+  put32(pulse + 10, frame);
+  put32(pulse + 14, nowMicros);
+  put32(pulse + 18, presentAt);
+  for (int i = 0; i < SHARD_HISTORY; i++) {
+    uint8_t *p = pulse + 22 + i * SHARD_INPUT_BYTES;
+    ShardInput past = {0, 0, 1, 0};   // Before frame 0: nothing happened
+    if (frame - i >= 0) past = inputFor(frame - i);
+    put32(p, past.triggers);
+    p[4] = past.sensorCount;
+    p[5] = past.analog;
+    p[6] = past.quality;
+  }
+  pulsePending = true;
+  if (packet != NULL) memcpy(packet, pulse, SHARD_PULSE_BYTES);
+}
+
+/**
+ * updateClock()
+ *
+ * Folds one pulse's (arrival - leader time) into the offset estimate.
+ * Network delay only ever adds to it, so the smallest recent value is
+ * the closest to the true clock offset. Two windows bound how long a
+ * stale minimum (clock drift) can stick.
+ */
+static void updateClock(uint32_t leaderMicros, uint32_t nowMicros) {
+  int32_t sample = (int32_t)(nowMicros - leaderMicros);
+  if (!clockValid) {
+    offsetMin = sample;
+    offsetPreviousMin = sample;
+    windowPulses = 0;
+    clockValid = true;
+  }
+  if (sample - offsetMin < 0) offsetMin = sample;
+  if (++windowPulses >= CLOCK_WINDOW_PULSES) {
+    offsetPreviousMin = offsetMin;
+    offsetMin = sample;
+    windowPulses = 0;
+  }
+}
+
+static int32_t clockOffset() {
+  return (offsetPreviousMin - offsetMin < 0) ? offsetPreviousMin : offsetMin;
+}
+
+/**
+ * feedPulse()
+ *
+ * Follower side of a vsync pulse: joins its epoch if it started recently
+ * enough to replay from frame 0, stores the new inputs and schedules the
+ * previous frame's presentation.
+ */
+static bool feedPulse(const uint8_t *packet, uint32_t nowMicros) {
+  uint32_t pulseEpoch = get32(packet + 6);
+  int32_t frame = (int32_t)get32(packet + 10);
+  uint32_t leaderMicros = get32(packet + 14);
+  uint32_t presentAt = get32(packet + 18);
+  if (packet[5] != nodeCount || frame < 0) {
+    pulsesRejected++;
+    return false;
+  }
+  pulsesReceived++;
+  updateClock(leaderMicros, nowMicros);
+
+  if (!synced || pulseEpoch != epoch) {
+    // Inputs from frame 0 on must all still be in this pulse
+    if (frame >= SHARD_HISTORY) {
+      synced = false;
+      return true;
+    }
+    beginEpoch(pulseEpoch);
+    if (!synced) return true;
+  }
+  if (frame <= knownFrame) return true;   // Duplicate or out of order
+  if (frame - renderedFrame > SHARD_HISTORY) {
+    // The inputs of the next frame to render are gone: start over
+    synced = false;
+    resyncs++;
+    return true;
+  }
+
+  int32_t first = max(knownFrame + 1, frame - SHARD_HISTORY + 1);
+  for (int32_t f = first; f <= frame; f++) {
+    const uint8_t *p = packet + 22 + (frame - f) * SHARD_INPUT_BYTES;
+    ShardInput &input = inputFor(f);
+    input.triggers = get32(p);
+    input.sensorCount = p[4];
+    input.analog = p[5];
+    input.quality = p[6];
+  }
+  knownFrame = frame;
+  if (frame > 0) schedulePresent(frame - 1, presentAt + clockOffset());
+  return true;
+}
+
+bool shardFeed(const uint8_t *packet, int length, uint32_t nowMicros) {
+  if (wall == NULL || length < 5 || packet[4] != SHARD_VERSION) return false;
+  if (memcmp(packet, "ADSP", 4) == 0) {
+    if (shardLeader() || length < SHARD_PULSE_BYTES) return false;
+    return feedPulse(packet, nowMicros);
+  }
+  if (memcmp(packet, "ADSJ", 4) == 0 && length >= SHARD_JOIN_BYTES) {
+    if (!shardLeader()) return false;
+    // Every follower that boots asks; one restart serves them all
+    if ((uint32_t)(nowMicros - epochStartMicros) >= EPOCH_HOLD_MICROS) joinRequested = true;
+    return true;
+  }
+  return false;
+}
+
+bool shardJoinRequest(uint8_t *packet, uint32_t nowMicros) {
+  if (shardLeader() || synced || wall == NULL) return false;
+  if (joinSent && nowMicros - lastJoinMicros < JOIN_INTERVAL_MICROS) return false;
+  joinSent = true;
+  lastJoinMicros = nowMicros;
+  memcpy(packet, "ADSJ", 4);
+  packet[4] = SHARD_VERSION;
+  return true;
+}
+
+void shardPoll() {
+#if WALL_SHARDING
+  if (wall == NULL) return;
+  if (pulsePending) {
+    udp.beginPacket(IPAddress(255, 255, 255, 255), SHARD_PORT);
+    udp.write(pulse, SHARD_PULSE_BYTES);
+    udp.endPacket();
+    pulsePending = false;
+  }
+  uint8_t join[SHARD_JOIN_BYTES];
+  if (shardJoinRequest(join, micros())) {
+    udp.beginPacket(leaderKnown ? leaderAddress : IPAddress(255, 255, 255, 255), SHARD_PORT);
+    udp.write(join, SHARD_JOIN_BYTES);
+    udp.endPacket();
+  }
+  uint8_t packet[SHARD_PULSE_BYTES];
+  for (int i = 0; i < MAX_PACKETS_PER_POLL && udp.parsePacket() > 0; i++) {
+    IPAddress from = udp.remoteIP();
+    int length = udp.read(packet, sizeof(packet));
+    if (length > 0 && shardFeed(packet, length, micros()) && !shardLeader()) {
+      leaderAddress = from;
+      leaderKnown = true;
+    }
+  }
+#else
+  pulsePending = false;
+#endif
+}
+
+ShardStep shardService(GFXcanvas16 &canvas, uint32_t nowMicros) {
+  if (!synced) return SHARD_IDLE;
+  if (presentPending && renderedFrame == presentFrame && (int32_t)(nowMicros - presentAtMicros) >= 0) {
+    presentPending = false;
+    framesShown++;
+    if (nowMicros - presentAtMicros > LATE_MICROS) framesLate++;
+    return SHARD_SHOW;
+  }
+  // Never overwrite a frame that is still waiting to be shown
+  if (renderedFrame < knownFrame && !(presentPending && renderedFrame == presentFrame)) {
+    renderFrame();
+    copyViewport(canvas);
+    return SHARD_RENDERED;
+  }
+  return SHARD_IDLE;
+}
+
+int32_t shardFrame() {
+  return renderedFrame;
+}
+
+void shardPrintStats() {
+  Serial.printf("shard: node %d of %d  %s  epoch %08lx  frame %ld  clock offset %ld us\n",
+                nodeIndex, nodeCount, synced ? "synced" : "waiting", (unsigned long)epoch,
+                (long)renderedFrame, (long)clockOffset());
+  Serial.printf("shard: shown %lu  late %lu  missed %lu  pulses %lu  rejected %lu  resyncs %lu  epochs %lu\n",
+                (unsigned long)framesShown, (unsigned long)framesLate, (unsigned long)framesMissed,
+                (unsigned long)pulsesReceived, (unsigned long)pulsesRejected, (unsigned long)resyncs,
+                (unsigned long)epochsStarted);
+}
@@ -0,0 +1,174 @@
+/**
+ * shard.h
+ *
+ * Wall sharding: drives one long installation from several MatrixPortals.
+ * Each board (node) drives its own chain, which keeps scan time, and so
+ * refresh rate and bit depth, the same as a single short wall, while the
+ * scenes still run as one continuous picture.
+ *
+ * Every node runs the same simulation. All of them reseed the scene
+ * generator (scenerandom.h) with the same epoch seed, rebuild both scenes
+ * for the whole wall, and step every frame on an offscreen canvas of the
+ * whole wall from the same inputs. Node k shows logical rows
+ * k * H .. (k + 1) * H - 1, where H is the height of one node's chain,
+ * and paints only those: the wall canvas carries a fastdraw window
+ * (fastdraw.h) over the viewport, so a node's drawing cost stays that of
+ * one chain however many nodes there are. The node then copies its
+ * viewport into its own chain. Node 0 is the top of the wall. Waves and
+ * ripples cross a seam exactly as they would on one chain, because no
+ * writer reads a neighboring pixel: a viewport's pixels are those of the
+ * same frame drawn whole, and need no margin rows.
+ *
+ * Memory still grows with the wall: the wall canvas, its two fade
+ * layers, the analog scene's indexed copy and the rain strip take about
+ * 8 bytes per wall pixel, some 145 KB per node of nine panels and 1.2 MB
+ * at SHARD_MAX_NODES, which needs the board's PSRAM.
+ *
+ * Node 0 is the leader. It reads the inputs (mode, sensor triggers,
+ * governor quality) and, once per frame period, broadcasts a vsync pulse
+ * on UDP port SHARD_PORT. The pulse for frame f carries:
+ *   - the epoch seed and f
+ *   - the inputs of frames f - SHARD_HISTORY + 1 .. f
+ *   - the leader's clock, and the leader time at which frame f - 1 is to
+ *     be shown (SHARD_PRESENT_DELAY_US from sending)
+ * Each follower keeps the smallest recent gap between a pulse's leader
+ * time and its own arrival time as its clock offset. With it, the
+ * follower shows f - 1 at the same moment as the leader, whatever delay
+ * the WiFi adds to a single pulse. A node renders f only after f - 1 is
+ * on its panels. A follower that missed pulses catches up from the
+ * inputs in the next one, and its panels hold the last frame meanwhile.
+ * A follower that is too far behind, or has just booted, asks the leader
+ * to start a new epoch, and the whole wall restarts its scenes together.
+ *
+ * All nodes need the same settings, except "node". The governor runs on
+ * the leader and its level is sent with each frame. Build with
+ * WALL_SHARDING 1 and WiFi (network.h), then set "shards" (nodes in the
+ * wall, 1 = off) and "node" (this board's place from the top). The
+ * simulation and the pulse format are portable so the host bench can
+ * drive them.
+ */
+
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <Adafruit_Protomatter.h>
+
+#ifndef WALL_SHARDING
+#define WALL_SHARDING 0
+#endif
+
+const uint16_t SHARD_PORT = 4050;
+const int SHARD_MAX_NODES = 8;
+const int SHARD_HISTORY = 8;                     // Frames of inputs per pulse
+const uint32_t SHARD_PRESENT_DELAY_US = 8000;    // Pulse to presentation, covers WiFi delay
+const int SHARD_PULSE_BYTES = 22 + SHARD_HISTORY * 7;
+const int SHARD_JOIN_BYTES = 5;
+
+/** Everything outside the simulation that one frame depends on. */
+struct ShardInput {
+  uint32_t triggers;     // Sensor trigger bits (see triggerLinkTake())
+  uint8_t sensorCount;   // Sensors the trigger bits are spread over
+  uint8_t analog;        // 1 = analog scene selected
+  uint8_t quality;       // Governor level the frame renders at
+};
+
+/**
+ * shardBegin()
+ *
+ * Allocates the whole-wall canvas this node renders into and its fade
+ * layers, limits drawing on it to this node's viewport, and starts a new
+ * epoch (on the leader) or waits for one (followers).
+ *
+ * @param canvas  This node's output canvas (for its size and rotation)
+ * @param nodes   Nodes in the wall, 2 .. SHARD_MAX_NODES
+ * @param node    This node, 0 = leader at the top
+ * @param seed    Epoch seed (leader only)
+ * @return        false if the wall canvas or scenes could not be allocated
+ */
+bool shardBegin(GFXcanvas16 &canvas, int nodes, int node, uint32_t seed);
+
+/** True on node 0. */
+bool shardLeader();
+
+/**
+ * shardLeaderReady()
+ *
+ * Leader only: true once the last frame started has rendered, so a new
+ * one may start. Inputs read for a frame must match the governor level
+ * it will render at, so the leader never runs more than one frame ahead.
+ */
+bool shardLeaderReady();
+
+/**
+ * shardLeaderTick()
+ *
+ * Leader only, once per frame period when shardLeaderReady(): starts the
+ * next frame with input and builds its pulse (broadcast by shardPoll()).
+ * Starts a new epoch first if a follower asked to join.
+ *
+ * @param input      Inputs of the new frame
+ * @param nowMicros  Current time
+ * @param packet     SHARD_PULSE_BYTES for a copy of the pulse, or NULL
+ */
+void shardLeaderTick(const ShardInput &input, uint32_t nowMicros, uint8_t *packet);
+
+/**
+ * shardFeed()
+ *
+ * Applies one packet received on SHARD_PORT: a pulse on a follower, a
+ * join request on the leader.
+ *
+ * @param packet     UDP payload
+ * @param length     Bytes in packet
+ * @param nowMicros  Arrival time
+ * @return           false if the packet was malformed or not for us
+ */
+bool shardFeed(const uint8_t *packet, int length, uint32_t nowMicros);
+
+/**
+ * shardJoinRequest()
+ *
+ * Follower only: builds the join request to send, if one is due.
+ *
+ * @param packet     SHARD_JOIN_BYTES for the request
+ * @param nowMicros  Current time
+ * @return           true if packet should be sent to the leader
+ */
+bool shardJoinRequest(uint8_t *packet, uint32_t nowMicros);
+
+/**
+ * shardPoll()
+ *
+ * Sends the leader's latest pulse and a follower's join requests, and
+ * reads every waiting packet. Call from loop() each iteration.
+ */
+void shardPoll();
+
+/** What shardService() did. */
+enum ShardStep {
+  SHARD_IDLE,       // Nothing due
+  SHARD_SHOW,       // canvas holds the frame due on the panels; show it now
+  SHARD_RENDERED    // Rendered a wall frame and copied the viewport into canvas
+};
+
+/**
+ * shardService()
+ *
+ * Presents or renders, whichever is due. Call from loop() each
+ * iteration. A frame is rendered only once the one before it has been
+ * shown, and a follower that fell behind renders the missed frames one
+ * call at a time.
+ *
+ * @param canvas     This node's output canvas
+ * @param nowMicros  Current time
+ * @return           The step taken
+ */
+ShardStep shardService(GFXcanvas16 &canvas, uint32_t nowMicros);
+
+/** Last frame rendered in the current epoch (the one a SHARD_SHOW shows), -1 = none. */
+int32_t shardFrame();
+
+/** Prints epoch, frame, clock offset and drop counts over Serial. */
+void shardPrintStats();
+
+#endif
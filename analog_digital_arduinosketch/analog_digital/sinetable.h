@@ -0,0 +1,39 @@
+/**
+ * sinetable.h
+ *
+ * Shared integer sine lookup used by the fixed-point rendering paths.
+ * Angles are expressed as a Q15 fraction of a full turn (SINE_TURN =
+ * 32768 = 2*PI) so phase accumulators can wrap with a simple mask, and
+ * results are Q15 amplitudes in the range -32767..32767.
+ */
+
+#ifndef SINETABLE_H
+#define SINETABLE_H
+
+#include <stdint.h>
+
+/** Phase units per full turn (Q15: 32768 = 2*PI). */
+const uint32_t SINE_TURN = 32768;
+
+/**
+ * sinQ15()
+ *
+ * Integer sine of a Q15 phase. Any phase is accepted; only the low 15
+ * bits are used, so a free-running accumulator wraps correctly.
+ *
+ * @param phase  Angle in Q15 turns
+ * @return       sin(phase) scaled to -32767..32767
+ */
+int16_t sinQ15(uint32_t phase);
+
+/**
+ * cosQ15()
+ *
+ * Integer cosine of a Q15 phase (sine shifted by a quarter turn).
+ *
+ * @param phase  Angle in Q15 turns
+ * @return       cos(phase) scaled to -32767..32767
+ */
+int16_t cosQ15(uint32_t phase);
+
+#endif
@@ -0,0 +1,243 @@
+/**
+ * telemetry.cpp
+ *
+ * Implements the telemetry stream declared in telemetry.h. The rendering
+ * thread fills one interval record; when the interval is over it copies
+ * the record into the handoff slot (if the loop task has emptied it) and
+ * starts the next. The loop task adds its show() stats, encodes the
+ * packet and writes it to every subscriber.
+ */
+
+#include "telemetry.h"
+#include <atomic>
+#include <string.h>
+#include "analog.h"
+#include "digital.h"
+#include "governor.h"
+#include "network.h"
+
+#if TELEMETRY_UDP
+#if !NETWORK_WIFI
+#error "TELEMETRY_UDP needs WiFi: define WIFI_SSID and WIFI_PASSWORD (see network.h)"
+#endif
+#include <WiFiUdp.h>
+#endif
+
+static const uint8_t SYNC_0 = 0xA5;
+static const uint8_t SYNC_1 = 0x5A;
+static const int HEADER_BYTES = 6;         // Sync, source, version, length
+static const int MAX_PACKET_BYTES = 96;
+
+/** One interval of render-side stats. */
+struct Interval {
+  uint32_t startMillis;
+  uint32_t endMillis;
+  uint32_t budgetMicros;
+  uint32_t worstMicros;
+  uint16_t frames;
+  uint16_t missed;
+  uint16_t histogram[TELEMETRY_BUCKETS];
+  uint8_t waves, eyes, ripples, quality;
+};
+
+static std::atomic<bool> subscribed(false);
+
+// Rendering thread only
+static Interval collecting;
+static bool collectingStarted = false;
+
+/** Handoff slot: filled by the rendering thread, emptied by the loop task. */
+static Interval ready;
+static std::atomic<bool> readyFull(false);
+
+// Loop task only
+static bool serialSubscribed = false;
+static uint32_t showCount = 0;
+static uint64_t showTotalMicros = 0;
+static uint32_t showMaxMicros = 0;
+static uint16_t sequence = 0;
+static uint16_t serialDrops = 0;
+
+#if TELEMETRY_UDP
+static WiFiUDP udp;
+static IPAddress leaseAddress;
+static uint16_t leasePort = 0;
+static uint32_t leaseStartMillis = 0;
+static bool leaseActive = false;
+#endif
+
+void telemetryBegin() {
+#if TELEMETRY_UDP
+  networkBegin();
+  udp.begin(TELEMETRY_UDP_PORT);
+#endif
+}
+
+/**
+ * updateSubscribed()
+ *
+ * Recomputes the flag the rendering thread checks every frame.
+ */
+static void updateSubscribed() {
+  bool any = serialSubscribed;
+#if TELEMETRY_UDP
+  any = any || leaseActive;
+#endif
+  subscribed.store(any, std::memory_order_relaxed);
+}
+
+void telemetryToggleSerial() {
+  serialSubscribed = !serialSubscribed;
+  updateSubscribed();
+}
+
+bool telemetrySubscribed() {
+  return subscribed.load(std::memory_order_relaxed);
+}
+
+void telemetryFrameEnd(unsigned long workMicros, unsigned long budgetMicros) {
+  if (!subscribed.load(std::memory_order_relaxed)) {
+    collectingStarted = false;
+    return;
+  }
+  uint32_t now = millis();
+  if (!collectingStarted) {
+    memset(&collecting, 0, sizeof(collecting));
+    collecting.startMillis = now;
+    collectingStarted = true;
+  }
+
+  collecting.budgetMicros = budgetMicros;
+  if (collecting.frames < 0xFFFF) collecting.frames++;
+  if (workMicros > budgetMicros && collecting.missed < 0xFFFF) collecting.missed++;
+  if (workMicros > collecting.worstMicros) collecting.worstMicros = workMicros;
+  unsigned long bucket = budgetMicros > 0 ? workMicros * 8 / budgetMicros : TELEMETRY_BUCKETS - 1;
+  if (bucket >= (unsigned long)TELEMETRY_BUCKETS) bucket = TELEMETRY_BUCKETS - 1;
+  if (collecting.histogram[bucket] < 0xFFFF) collecting.histogram[bucket]++;
+
+  if (now - collecting.startMillis < TELEMETRY_INTERVAL_MS) return;
+  collecting.endMillis = now;
+  collecting.waves = analogActiveWaves();
+  collecting.eyes = digitalActiveEyes();
+  collecting.ripples = digitalActiveRipples();
+  collecting.quality = governorLevel();
+  // If the loop task has not sent the last interval yet, this one is lost
+  if (!readyFull.load(std::memory_order_acquire)) {
+    ready = collecting;
+    readyFull.store(true, std::memory_order_release);
+  }
+  collectingStarted = false;
+}
+
+void telemetryShow(unsigned long showMicros) {
+  if (!subscribed.load(std::memory_order_relaxed)) return;
+  showCount++;
+  showTotalMicros += showMicros;
+  if (showMicros > showMaxMicros) showMaxMicros = showMicros;
+}
+
+/** Little-endian packet builder. */
+struct PacketWriter {
+  uint8_t bytes[MAX_PACKET_BYTES];
+  int length;
+
+  void put8(uint8_t v) { bytes[length++] = v; }
+  void put16(uint16_t v) { put8(v); put8(v >> 8); }
+  void put32(uint32_t v) { put16(v); put16(v >> 16); }
+};
+
+/**
+ * encodePacket()
+ *
+ * Builds the display packet for interval into out, consuming the loop
+ * task's show() stats.
+ */
+static void encodePacket(PacketWriter &out, const Interval &interval, bool analog) {
+  out.length = 0;
+  out.put8(SYNC_0);
+  out.put8(SYNC_1);
+  out.put8(TELEMETRY_SOURCE_DISPLAY);
+  out.put8(TELEMETRY_VERSION);
+  out.put16(0);  // Payload length, patched below
+
+  out.put16(sequence++);
+  out.put32(interval.endMillis);
+  out.put16(interval.endMillis - interval.startMillis);
+  out.put16(interval.frames);
+  out.put16(interval.missed);
+  out.put32(interval.budgetMicros);
+  out.put32(interval.worstMicros);
+  for (int b = 0; b < TELEMETRY_BUCKETS; b++) out.put16(interval.histogram[b]);
+  out.put16(showCount > 0xFFFF ? 0xFFFF : showCount);
+  out.put32(showCount > 0 ? (uint32_t)(showTotalMicros / showCount) : 0);
+  out.put32(showMaxMicros);
+  out.put8(interval.waves);
+  out.put8(interval.eyes);
+  out.put8(interval.ripples);
+  out.put8(interval.quality);
+  out.put8(analog ? 0 : 1);
+#if defined(ARDUINO_ARCH_ESP32)
+  out.put32(ESP.getFreeHeap());
+#else
+  out.put32(0);
+#endif
+  out.put16(serialDrops);
+
+  int payload = out.length - HEADER_BYTES;
+  out.bytes[4] = payload;
+  out.bytes[5] = payload >> 8;
+  uint8_t check = 0;
+  for (int i = 2; i < out.length; i++) check ^= out.bytes[i];
+  out.put8(check);
+
+  showCount = 0;
+  showTotalMicros = 0;
+  showMaxMicros = 0;
+}
+
+/**
+ * pollUdp()
+ *
+ * Renews the lease of whoever sent a datagram, and lets it lapse after
+ * TELEMETRY_LEASE_MS of silence.
+ */
+static void pollUdp() {
+#if TELEMETRY_UDP
+  int size = udp.parsePacket();
+  if (size > 0) {
+    uint8_t discard[16];
+    while (udp.read(discard, sizeof(discard)) > 0) {}
+    leaseAddress = udp.remoteIP();
+    leasePort = udp.remotePort();
+    leaseStartMillis = millis();
+    leaseActive = true;
+  } else if (leaseActive && millis() - leaseStartMillis >= TELEMETRY_LEASE_MS) {
+    leaseActive = false;
+  }
+  updateSubscribed();
+#endif
+}
+
+void telemetryPoll(bool analog) {
+  pollUdp();
+  if (!readyFull.load(std::memory_order_acquire)) return;
+
+  PacketWriter packet;
+  encodePacket(packet, ready, analog);
+  readyFull.store(false, std::memory_order_release);
+
+  if (serialSubscribed) {
+    if (Serial.availableForWrite() >= packet.length) {
+      Serial.write(packet.bytes, packet.length);
+    } else {
+      serialDrops++;
+    }
+  }
+#if TELEMETRY_UDP
+  if (leaseActive && networkConnected()) {
+    udp.beginPacket(leaseAddress, leasePort);
+    udp.write(packet.bytes, packet.length);
+    udp.endPacket();
+  }
+#endif
+}
@@ -0,0 +1,102 @@
+/**
+ * telemetry.h
+ *
+ * Compact binary runtime stats for unattended installs. Once a second a
+ * subscribed client gets one packet covering that interval:
+ *   - a histogram of frame render times, scaled to the frame budget
+ *   - missed frames and the worst frame
+ *   - show() time (average and worst)
+ *   - the active wave, eye and ripple counts, the governor level and mode
+ *   - free heap, so a slow leak shows up over weeks
+ *
+ * Transports:
+ *   Serial  send 't' to toggle the subscription (the same USB port
+ *           also carries the text commands and their replies)
+ *   UDP     with TELEMETRY_UDP 1 (needs WiFi, see network.h), any
+ *           datagram to TELEMETRY_UDP_PORT subscribes its sender for
+ *           TELEMETRY_LEASE_MS, so renew it every few seconds
+ * With no subscriber nothing is collected beyond one flag test per
+ * frame, and nothing is sent. A packet that would not fit in the serial
+ * transmit buffer is dropped, never waited for.
+ *
+ * Packet, all fields little-endian:
+ *   A5 5A  sync
+ *   u8     source: TELEMETRY_SOURCE_DISPLAY ('D')
+ *   u8     version: TELEMETRY_VERSION
+ *   u16    payload length
+ *   ...    payload
+ *   u8     XOR of every byte from source to the end of the payload
+ * Display payload (version 1):
+ *   u16 sequence    u32 uptime ms    u16 interval ms
+ *   u16 frames      u16 missed       u32 budget us     u32 worst frame us
+ *   u16 histogram[TELEMETRY_BUCKETS]  bucket i = frames whose render took
+ *                                     i/8 to (i+1)/8 of the budget; the
+ *                                     last bucket holds everything slower
+ *   u16 shows       u32 show avg us  u32 show max us
+ *   u8 waves  u8 eyes  u8 ripples  u8 quality level  u8 mode (0 analog, 1 digital)
+ *   u32 free heap bytes (0 off the ESP32)
+ *   u16 packets dropped because the serial buffer was full
+ *
+ * Frame stats are gathered on the rendering thread and handed to the
+ * loop task (which sends) through one atomic flag, like the render
+ * pipeline's frame handoff.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+#ifndef TELEMETRY_UDP
+#define TELEMETRY_UDP 0
+#endif
+
+#ifndef TELEMETRY_UDP_PORT
+#define TELEMETRY_UDP_PORT 4210
+#endif
+
+const uint8_t TELEMETRY_SOURCE_DISPLAY = 'D';
+const uint8_t TELEMETRY_VERSION = 1;
+const int TELEMETRY_BUCKETS = 16;
+const uint32_t TELEMETRY_INTERVAL_MS = 1000;
+const uint32_t TELEMETRY_LEASE_MS = 30000;
+
+/**
+ * telemetryBegin()
+ *
+ * Starts WiFi and the UDP listener when TELEMETRY_UDP is set; otherwise
+ * does nothing. Call once from setup().
+ */
+void telemetryBegin();
+
+/** Toggles the serial subscription (the 't' command). */
+void telemetryToggleSerial();
+
+/** True while any client is subscribed. */
+bool telemetrySubscribed();
+
+/**
+ * telemetryFrameEnd()
+ *
+ * Records one rendered frame. Call from the rendering thread next to
+ * governorFrameEnd(), with the same arguments.
+ *
+ * @param workMicros    Time spent rendering the frame
+ * @param budgetMicros  Time available per frame
+ */
+void telemetryFrameEnd(unsigned long workMicros, unsigned long budgetMicros);
+
+/** Records one matrix.show(). Call from the thread that presents. */
+void telemetryShow(unsigned long showMicros);
+
+/**
+ * telemetryPoll()
+ *
+ * Handles UDP subscriptions and sends the interval's packet when one is
+ * ready. Call from loop() each iteration.
+ *
+ * @param analog  Mode currently selected, reported in the packet
+ */
+void telemetryPoll(bool analog);
+
+#endif
@@ -0,0 +1,202 @@
+/**
+ * transition.cpp
+ *
+ * Implements the cross-fade declared in transition.h. The mixer works on
+ * RGB565 without unpacking to bytes. Each pixel is spread into a 32-bit word
+ * as 00000GGGGGG00000RRRRR000000BBBBB (green moved up 16 bits), which
+ * leaves at least five zero bits above every channel. One multiply per
+ * source then scales all three channels by a 5-bit weight without any
+ * carry crossing into the next channel, and a shift and mask packs the
+ * result back.
+ */
+
+#include "transition.h"
+#include <string.h>
+#include "fastdraw.h"
+
+static GFXcanvas16 *layers[2] = {NULL, NULL};  // [0] outgoing scene, [1] incoming
+static int fadeFrames = 0;
+static int fadeFrame = 0;                      // Frames of the fade shown so far
+
+static const uint32_t SPREAD_MASK = 0x07E0F81F;
+
+/** Moves green to the upper half so every channel has headroom above it. */
+static inline uint32_t spread565(uint16_t c) {
+  return ((uint32_t)c | ((uint32_t)c << 16)) & SPREAD_MASK;
+}
+
+/** Inverse of spread565(). */
+static inline uint16_t pack565(uint32_t s) {
+  s &= SPREAD_MASK;
+  return (uint16_t)(s | (s >> 16));
+}
+
+void transitionMix565(uint16_t *out, const uint16_t *a, const uint16_t *b, uint32_t count, int weight) {
+  uint32_t wa = (uint32_t)weight;
+  uint32_t wb = 32 - wa;
+  uint32_t i = 0;
+  // Two pixels per iteration: independent multiplies the core can overlap
+  for (; i + 1 < count; i += 2) {
+    uint32_t m0 = (spread565(a[i]) * wa + spread565(b[i]) * wb) >> 5;
+    uint32_t m1 = (spread565(a[i + 1]) * wa + spread565(b[i + 1]) * wb) >> 5;
+    out[i] = pack565(m0);
+    out[i + 1] = pack565(m1);
+  }
+  if (i < count) out[i] = pack565((spread565(a[i]) * wa + spread565(b[i]) * wb) >> 5);
+}
+
+/**
+ * DrawnSpan
+ *
+ * Where the scenes drew on a canvas: lines stretches of length pixels,
+ * from offset and every stride pixels after it. Without a draw window
+ * (fastdraw.h) that is the whole buffer as one stretch; with one it is
+ * the window's part of each framebuffer line.
+ */
+struct DrawnSpan {
+  int32_t offset;
+  int32_t length;
+  int32_t stride;
+  int lines;
+};
+
+static DrawnSpan drawnSpan(GFXcanvas16 &canvas) {
+  int16_t top, bottom;
+  fastDrawRows(canvas, top, bottom);
+  int32_t lineLength = canvas.height();
+  if (top == 0 && bottom == lineLength) {
+    int32_t pixels = (int32_t)canvas.width() * lineLength;
+    return {0, pixels, pixels, 1};
+  }
+  return {lineLength - bottom, bottom - top, lineLength, canvas.width()};
+}
+
+/** Copies the drawn span of from into to (same geometry). */
+static void copySpan(uint16_t *to, const uint16_t *from, const DrawnSpan &span) {
+  for (int i = 0; i < span.lines; i++) {
+    int32_t at = span.offset + (int32_t)i * span.stride;
+    memcpy(to + at, from + at, span.length * sizeof(uint16_t));
+  }
+}
+
+/**
+ * endFade()
+ *
+ * Ends the transition. The layers stay allocated for the next one.
+ */
+static void endFade() {
+  fadeFrames = 0;
+  fadeFrame = 0;
+}
+
+/**
+ * freeLayers()
+ *
+ * Ends any transition and releases the layers.
+ */
+static void freeLayers() {
+  endFade();
+  delete layers[0];
+  delete layers[1];
+  layers[0] = NULL;
+  layers[1] = NULL;
+}
+
+/**
+ * newLayer()
+ *
+ * Allocates a blank canvas with the same physical size and rotation as
+ * canvas.
+ */
+static GFXcanvas16 *newLayer(GFXcanvas16 &canvas) {
+  uint8_t rotation = canvas.getRotation();
+  canvas.setRotation(0);
+  GFXcanvas16 *layer = new GFXcanvas16(canvas.width(), canvas.height());
+  canvas.setRotation(rotation);
+  if (layer == NULL) return NULL;
+  if (layer->getBuffer() == NULL) {
+    delete layer;
+    return NULL;
+  }
+  layer->setRotation(rotation);
+  return layer;
+}
+
+/**
+ * layersFit()
+ *
+ * True if the layers exist and have canvas's physical size. Gives them
+ * canvas's rotation on the way.
+ */
+static bool layersFit(GFXcanvas16 &canvas) {
+  if (layers[0] == NULL || layers[1] == NULL) return false;
+  layers[0]->setRotation(canvas.getRotation());
+  layers[1]->setRotation(canvas.getRotation());
+  return layers[0]->width() == canvas.width() && layers[0]->height() == canvas.height();
+}
+
+bool transitionAllocate(GFXcanvas16 &canvas, int frames) {
+  if (frames <= 0) {
+    freeLayers();
+    return true;
+  }
+  if (layersFit(canvas)) return true;
+  freeLayers();
+  layers[0] = newLayer(canvas);
+  layers[1] = newLayer(canvas);
+  if (layers[0] == NULL || layers[1] == NULL) {
+    freeLayers();
+    return false;
+  }
+  return true;
+}
+
+bool transitionBegin(GFXcanvas16 &canvas, int frames) {
+  if (transitionActive()) {
+    // Switched back mid-fade: run the same fade backwards from here
+    GFXcanvas16 *swap = layers[0];
+    layers[0] = layers[1];
+    layers[1] = swap;
+    fadeFrame = fadeFrames - fadeFrame;
+    return true;
+  }
+  if (frames <= 0 || canvas.getBuffer() == NULL || !layersFit(canvas)) return false;
+
+  // The outgoing scene carries on from exactly what it last drew
+  copySpan(layers[0]->getBuffer(), canvas.getBuffer(), drawnSpan(canvas));
+  fadeFrames = frames;
+  fadeFrame = 0;
+  return true;
+}
+
+void transitionCancel() {
+  endFade();
+}
+
+bool transitionActive() {
+  return fadeFrames > 0;
+}
+
+void transitionRender(GFXcanvas16 &canvas, SceneFunction outgoing, SceneFunction incoming) {
+  if (!transitionActive()) {
+    incoming(canvas);
+    return;
+  }
+  outgoing(*layers[0]);
+  incoming(*layers[1]);
+  fadeFrame++;
+
+  DrawnSpan span = drawnSpan(canvas);
+  if (fadeFrame >= fadeFrames) {
+    // Hand the canvas over to the incoming scene in the state it expects
+    copySpan(canvas.getBuffer(), layers[1]->getBuffer(), span);
+    endFade();
+    return;
+  }
+  int weight = fadeFrame * 32 / fadeFrames;
+  for (int i = 0; i < span.lines; i++) {
+    int32_t at = span.offset + (int32_t)i * span.stride;
+    transitionMix565(canvas.getBuffer() + at, layers[1]->getBuffer() + at, layers[0]->getBuffer() + at,
+                     span.length, weight);
+  }
+}
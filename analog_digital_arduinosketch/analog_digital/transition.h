@@ -0,0 +1,95 @@
+/**
+ * transition.h
+ *
+ * Cross-fade between the analog and digital scenes. Normally only the
+ * selected scene renders, straight into the output canvas. Two offscreen
+ * layers with the same geometry as the output canvas are allocated once
+ * at startup (transitionAllocate()) and reused by every fade, so an
+ * install that runs for weeks never allocates on a mode switch. When the
+ * switch flips, for the next few frames transitionRender() draws the
+ * outgoing scene into one layer and the incoming scene into the other,
+ * then mixes them into the output canvas with a rising weight. On the
+ * last frame the incoming layer is copied in; outside a transition there
+ * is no extra work.
+ *
+ * The outgoing layer starts as a copy of the output canvas, so scenes
+ * that only erase what they drew last frame (analog dirty spans) keep
+ * working. A scene entering on a blank layer must be told to repaint
+ * everything (invalidateAnalog()). If the switch flips back during a
+ * transition, the fade reverses from where it is.
+ *
+ * If the layers could not be allocated, or the fade length is 0 (config
+ * setting "fade", which then allocates nothing), the switch is a hard
+ * cut as before.
+ */
+
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <Adafruit_Protomatter.h>
+
+/** Renders one frame of a scene into canvas. */
+typedef void (*SceneFunction)(GFXcanvas16 &canvas);
+
+/**
+ * transitionAllocate()
+ *
+ * Allocates the two fade layers for canvas's geometry. Call once at
+ * startup for the canvas the scenes draw into (shardBegin() does it for
+ * the wall canvas). Layers that already fit are kept; others are
+ * replaced, and frames 0 releases them.
+ *
+ * @param canvas  The output canvas the scenes normally draw into
+ * @param frames  Configured fade length in frames
+ * @return        false if the layers could not be allocated (every
+ *                switch will be a hard cut)
+ */
+bool transitionAllocate(GFXcanvas16 &canvas, int frames);
+
+/**
+ * transitionBegin()
+ *
+ * Starts a cross-fade from whatever canvas currently shows. During a
+ * transition this reverses the one in progress instead.
+ *
+ * @param canvas  The output canvas the scenes normally draw into
+ * @param frames  Length of the fade in frames
+ * @return        false if no fade will run (frames is 0, or no layers
+ *                fit canvas); the caller should cut straight to the new
+ *                scene
+ */
+bool transitionBegin(GFXcanvas16 &canvas, int frames);
+
+/** True while a cross-fade is in progress. */
+bool transitionActive();
+
+/**
+ * transitionRender()
+ *
+ * Draws one frame of the cross-fade into canvas. The fade ends after the
+ * frame that shows the incoming scene alone.
+ *
+ * @param canvas    The output canvas
+ * @param outgoing  Scene being faded out
+ * @param incoming  Scene being faded in
+ */
+void transitionRender(GFXcanvas16 &canvas, SceneFunction outgoing, SceneFunction incoming);
+
+/** Ends any cross-fade at once, leaving canvas as it is. The layers are kept. */
+void transitionCancel();
+
+/**
+ * transitionMix565()
+ *
+ * Blends two RGB565 pixel arrays: out = a * weight / 32 + b * (32 - weight) / 32,
+ * per channel. out may alias a or b.
+ *
+ * @param out     Destination, count pixels
+ * @param a       Pixels weighted by weight
+ * @param b       Pixels weighted by 32 - weight
+ * @param count   Number of pixels
+ * @param weight  0 (all b) to 32 (all a)
+ */
+void transitionMix565(uint16_t *out, const uint16_t *a, const uint16_t *b, uint32_t count, int weight);
+
+#endif
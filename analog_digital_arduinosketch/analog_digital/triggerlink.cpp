@@ -0,0 +1,123 @@
+/**
+ * triggerlink.cpp
+ *
+ * Implements the Teensy trigger link declared in triggerlink.h: a byte
+ * parser that runs on the loop task and an atomic trigger mask the
+ * renderer drains once per frame.
+ */
+
+#include "triggerlink.h"
+#include <atomic>
+#include <string.h>
+
+// Parser state (loop task only)
+static uint8_t frame[LINK_FRAME_BYTES];
+static int frameLength = 0;          // Bytes collected so far, 0 = hunting for sync
+
+// Latest link state (written by the loop task, read by either)
+static volatile uint32_t lastFrameMillis = 0;
+static volatile bool linkSeen = false;
+static volatile uint32_t digitalMask = 0;
+static volatile uint8_t sensorCount = 1;
+
+/** Sensors that fired and the renderer has not handled yet. */
+static std::atomic<uint32_t> pendingTriggers(0);
+/** micros() of the oldest trigger still pending, for the latency stat. */
+static volatile uint32_t pendingSinceMicros = 0;
+
+// Stats
+static uint32_t framesReceived = 0;
+static uint32_t checksumErrors = 0;
+static uint32_t triggersReceived = 0;
+static volatile uint32_t maxTakeMicros = 0;   // Written by the renderer only
+
+void triggerLinkBegin() {
+#if defined(ARDUINO_ARCH_ESP32)
+  Serial1.begin(LINK_BAUD, SERIAL_8N1, LINK_RX_PIN, LINK_TX_PIN);
+#endif
+}
+
+void triggerLinkPoll() {
+#if defined(ARDUINO_ARCH_ESP32)
+  while (Serial1.available() > 0) {
+    triggerLinkFeed((uint8_t)Serial1.read());
+  }
+#endif
+}
+
+/**
+ * applyFrame()
+ *
+ * Takes over the mask and sensor count of a verified frame and queues
+ * its trigger.
+ */
+static void applyFrame() {
+  framesReceived++;
+  uint32_t mask = (uint32_t)frame[4] | ((uint32_t)frame[5] << 8) |
+                  ((uint32_t)frame[6] << 16) | ((uint32_t)frame[7] << 24);
+  digitalMask = mask;
+  sensorCount = frame[3] > 0 ? frame[3] : 1;
+  lastFrameMillis = millis();
+  linkSeen = true;
+  if (frame[1] == LINK_TRIGGER && frame[2] < 32) {
+    triggersReceived++;
+    uint32_t before = pendingTriggers.fetch_or(1UL << frame[2], std::memory_order_release);
+    if (before == 0) pendingSinceMicros = micros();
+  }
+}
+
+void triggerLinkFeed(uint8_t b) {
+  if (frameLength == 0 && b != LINK_SYNC) return;
+  frame[frameLength++] = b;
+  if (frameLength < LINK_FRAME_BYTES) return;
+  frameLength = 0;
+
+  uint8_t check = 0;
+  for (int i = 1; i < LINK_FRAME_BYTES - 1; i++) check ^= frame[i];
+  if (check != frame[LINK_FRAME_BYTES - 1] || frame[1] > LINK_TRIGGER) {
+    checksumErrors++;
+    // The real sync byte may be inside this frame; rescan what followed it
+    for (int start = 1; start < LINK_FRAME_BYTES; start++) {
+      if (frame[start] != LINK_SYNC) continue;
+      uint8_t rest[LINK_FRAME_BYTES];
+      int restLength = LINK_FRAME_BYTES - start;
+      memcpy(rest, frame + start, restLength);
+      for (int i = 0; i < restLength; i++) triggerLinkFeed(rest[i]);
+      return;
+    }
+    return;
+  }
+  applyFrame();
+}
+
+bool triggerLinkActive() {
+  return linkSeen && millis() - lastFrameMillis < LINK_TIMEOUT_MS;
+}
+
+bool triggerLinkDigital() {
+  return digitalMask != 0;
+}
+
+int triggerLinkSensorCount() {
+  return sensorCount;
+}
+
+bool triggerLinkPending() {
+  return pendingTriggers.load(std::memory_order_relaxed) != 0;
+}
+
+uint32_t triggerLinkTake() {
+  uint32_t triggers = pendingTriggers.exchange(0, std::memory_order_acquire);
+  if (triggers != 0) {
+    uint32_t waited = micros() - pendingSinceMicros;
+    if (waited > maxTakeMicros) maxTakeMicros = waited;
+  }
+  return triggers;
+}
+
+void triggerLinkPrintStats() {
+  Serial.printf("link: %s, %lu frames, %lu bad, %lu triggers, max trigger-to-render %lu us\n",
+                triggerLinkActive() ? "up" : "down", (unsigned long)framesReceived,
+                (unsigned long)checksumErrors, (unsigned long)triggersReceived,
+                (unsigned long)maxTakeMicros);
+}
@@ -0,0 +1,101 @@
+/**
+ * triggerlink.h
+ *
+ * Serial trigger link from the Teensy sensor controller. Instead of one
+ * shared mode line on A1, sampled once per loop(), the Teensy sends a
+ * short UART frame the moment a sensor fires, carrying which sensor it
+ * was. The display switches to digital mode and spawns an eye at that
+ * sensor's position on the very next frame it renders.
+ *
+ * Frame (LINK_FRAME_BYTES bytes, 1 Mbaud 8N1, under 100 us on the wire):
+ *   0     LINK_SYNC (0xA5)
+ *   1     type: LINK_STATE (0) or LINK_TRIGGER (1)
+ *   2     sensor index that fired (trigger frames; 0 in state frames)
+ *   3     number of sensors on the Teensy
+ *   4-7   mask of sensors currently in digital mode, least significant
+ *         byte first (bit i = sensor i)
+ *   8     XOR of bytes 1-7
+ * The Teensy sends a trigger frame from playDigital(), and a state frame
+ * whenever a digital note ends plus every LINK_HEARTBEAT_MS, so a frame
+ * lost to noise is corrected within a heartbeat. The layout and constants
+ * must match TriggerLink.h in the Teensy sketch.
+ *
+ * While frames keep arriving (within LINK_TIMEOUT_MS) the mask decides
+ * the mode: digital while any sensor is. Without a link (Teensy not
+ * wired, or an older Teensy sketch) the sketch falls back to pin A1.
+ *
+ * Bytes are read on the loop task; triggers are handed to the renderer
+ * (on core 0 under the render pipeline) through one atomic mask.
+ */
+
+#ifndef TRIGGERLINK_H
+#define TRIGGERLINK_H
+
+#include <Arduino.h>
+
+/** MatrixPortal ESP32-S3 header pins; RX takes the Teensy's TX2 (pin 8). */
+#ifndef LINK_RX_PIN
+#define LINK_RX_PIN 8
+#endif
+#ifndef LINK_TX_PIN
+#define LINK_TX_PIN 18
+#endif
+
+const unsigned long LINK_BAUD = 1000000;
+const uint8_t LINK_SYNC = 0xA5;
+const uint8_t LINK_STATE = 0;
+const uint8_t LINK_TRIGGER = 1;
+const int LINK_FRAME_BYTES = 9;
+const uint32_t LINK_HEARTBEAT_MS = 100;
+const uint32_t LINK_TIMEOUT_MS = 5 * LINK_HEARTBEAT_MS;
+
+/**
+ * triggerLinkBegin()
+ *
+ * Opens the UART to the Teensy. A no-op off the ESP32 (the host bench
+ * feeds frames with triggerLinkFeed()).
+ */
+void triggerLinkBegin();
+
+/**
+ * triggerLinkPoll()
+ *
+ * Parses every byte waiting on the UART. Call from loop() each iteration.
+ */
+void triggerLinkPoll();
+
+/**
+ * triggerLinkFeed()
+ *
+ * Parses one received byte. Complete frames with a good checksum update
+ * the sensor mask and queue their trigger; anything else resynchronizes
+ * on the next sync byte.
+ *
+ * @param b  Byte read from the link
+ */
+void triggerLinkFeed(uint8_t b);
+
+/** True if a valid frame arrived within LINK_TIMEOUT_MS. */
+bool triggerLinkActive();
+
+/** True if the last frame reported any sensor in digital mode. */
+bool triggerLinkDigital();
+
+/** Number of sensors the Teensy reported (at least 1). */
+int triggerLinkSensorCount();
+
+/**
+ * triggerLinkTake()
+ *
+ * Returns the sensors that fired since the last call (bit i = sensor i)
+ * and clears them. Called by the renderer at the start of a frame.
+ */
+uint32_t triggerLinkTake();
+
+/** True if triggers are waiting for triggerLinkTake(). */
+bool triggerLinkPending();
+
+/** Prints frame, error and trigger-to-render latency counts over Serial. */
+void triggerLinkPrintStats();
+
+#endif
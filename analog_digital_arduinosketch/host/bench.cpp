@@ -0,0 +1,550 @@
+/**
+ * bench.cpp
+ *
+ * Host-side simulator and benchmark for the MatrixPortal renderer. Builds
+ * analog.cpp / digital.cpp unmodified against the mock Protomatter/GFX
+ * canvas in mock/, runs each scene headless for N frames from a fixed
+ * random seed, and reports:
+ *   - ns/frame per mode, plus the profiler's per-phase breakdown
+ *   - ns/call for the GFX primitives and their fastdraw replacements
+ *   - a checksum over every frame, so two builds can be compared for
+ *     identical output
+ * Frames can optionally be dumped as PPM images or raw RGB565 canvases.
+ *
+ * Usage: bench [--frames N] [--seed S] [--mode analog|digital|both|switch|triggers|replay|sink|shard]
+ *              [--no-primitives] [--dump DIR] [--raw FILE] [--set KEY=VALUE]
+ *              [--quality LEVEL]
+ * --set takes any config.h setting (panels, depth, fps, waves, ...).
+ * --mode switch flips between the scenes every SWITCH_FRAMES frames with
+ * the sketch's cross-fade (config setting fade).
+ * --mode triggers runs the digital scene with a trigger-link frame from
+ * the next of TRIGGER_SENSORS sensors every TRIGGER_FRAMES frames.
+ * --mode replay runs the sketch's replay scenario (replay.h) and prints
+ * its signature; with the same seed, frame count and settings the pixel
+ * hash matches the board's 'b' command.
+ * --mode sink streams a moving gradient into the network sink (netsink.h)
+ * with simulated uneven packet arrival, DDP for the first half of the
+ * run and Art-Net for the second, and prints the sink's counters.
+ * --mode shard runs a sharded wall (shard.h) of "shards" nodes (3 if not
+ * set): the leader, then each follower receiving the leader's pulses
+ * with delay, jitter, drops and a skewed clock. Every frame a node shows
+ * is compared with the same rows of one unsharded render of the whole
+ * wall.
+ * --quality pins the governor level (0 = full .. 4 = half rows); it is
+ * never adjusted automatically here, so runs stay reproducible.
+ */
+
+#include <Adafruit_Protomatter.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "analog.h"
+#include "config.h"
+#include "digital.h"
+#include "dither.h"
+#include "fastdraw.h"
+#include "governor.h"
+#include "netsink.h"
+#include "profiler.h"
+#include "replay.h"
+#include "scenerandom.h"
+#include "shard.h"
+#include "transition.h"
+#include "triggerlink.h"
+
+static uint8_t rgbPins[]  = {42, 41, 40, 38, 39, 37};
+static uint8_t addrPins[] = {45, 36, 48, 35, 21};
+
+// Same geometry as the sketch (config.h defaults: nine 64-wide panels,
+// rotated vertical); --panels and friends override them
+static Adafruit_Protomatter *matrix = NULL;
+
+static unsigned long microsPerFrame = 1000000 / 60;
+
+/* ------------------------------------------------------------------ */
+/*  Frame output                                                      */
+/* ------------------------------------------------------------------ */
+
+static std::string dumpDir;
+static FILE *rawFile = NULL;
+static uint64_t frameHash = 1469598103934665603ULL;  // FNV-1a over all frames
+static int dumpIndex = 0;
+
+/** Writes the logical (rotated) view as a binary PPM, one file per frame. */
+static void dumpPPM(Adafruit_Protomatter &m) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/frame_%05d.ppm", dumpDir.c_str(), dumpIndex);
+  FILE *f = fopen(path, "wb");
+  if (!f) return;
+  fprintf(f, "P6\n%d %d\n255\n", m.width(), m.height());
+  for (int y = 0; y < m.height(); y++) {
+    for (int x = 0; x < m.width(); x++) {
+      uint16_t c = m.getPixel(x, y);
+      uint8_t rgb[3] = {(uint8_t)((c >> 8) & 0xF8), (uint8_t)((c >> 3) & 0xFC), (uint8_t)((c << 3) & 0xF8)};
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  fclose(f);
+}
+
+/** Checksums the presented canvas and writes any requested dumps. */
+static void recordFrame(Adafruit_Protomatter &m) {
+  const uint16_t *buf = m.getBuffer();
+  uint32_t pixels = (uint32_t)m.width() * m.height();
+  for (uint32_t i = 0; i < pixels; i++) {
+    frameHash = (frameHash ^ buf[i]) * 1099511628211ULL;
+  }
+  if (!dumpDir.empty()) dumpPPM(m);
+  if (rawFile) fwrite(buf, sizeof(uint16_t), pixels, rawFile);
+  dumpIndex++;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Scene benchmark                                                   */
+/* ------------------------------------------------------------------ */
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsSince(Clock::time_point start) {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+/**
+ * runScene()
+ *
+ * Runs one scene for the given number of frames exactly the way loop()
+ * does (profiled draw + show) and prints the cost. Checksums and dumps
+ * happen outside the timed region.
+ */
+static void runScene(const char *name, void (*draw)(GFXcanvas16 &), int frames) {
+  profileReset();
+  double totalNs = 0;
+  for (int f = 0; f < frames; f++) {
+    Clock::time_point start = Clock::now();
+    profileFrameStart();
+    draw(*matrix);
+    matrix->show();
+    profileMark(PHASE_SHOW);
+    profileFrameEnd(microsPerFrame);
+    totalNs += nsSince(start);
+    recordFrame(*matrix);
+  }
+  printf("\n[%s] %d frames, %.0f ns/frame\n", name, frames, totalNs / frames);
+  profilePrint();
+}
+
+static const int SWITCH_FRAMES = 240;
+static int switchCounter = 0;
+static bool switchAnalog = true;
+
+/**
+ * drawSwitching()
+ *
+ * Toggles the mode every SWITCH_FRAMES frames and renders it the way the
+ * sketch's renderScene() does, cross-fade included.
+ */
+static void drawSwitching(GFXcanvas16 &canvas) {
+  if (++switchCounter == SWITCH_FRAMES) {
+    switchCounter = 0;
+    switchAnalog = !switchAnalog;
+    if (switchAnalog) invalidateAnalog();
+    transitionBegin(canvas, config.fadeFrames);
+  }
+  if (transitionActive()) {
+    transitionRender(canvas, switchAnalog ? drawDigital : drawAnalog, switchAnalog ? drawAnalog : drawDigital);
+  } else if (switchAnalog) {
+    drawAnalog(canvas);
+  } else {
+    drawDigital(canvas);
+  }
+}
+
+static const int TRIGGER_FRAMES = 45;
+static const int TRIGGER_SENSORS = 5;
+static int triggerCounter = 0;
+static int triggerSensor = 0;
+
+/**
+ * drawTriggered()
+ *
+ * Feeds a trigger frame through the link parser every TRIGGER_FRAMES
+ * frames, then handles it and draws the digital scene the way the
+ * sketch's renderScene() does.
+ */
+static void drawTriggered(GFXcanvas16 &canvas) {
+  if (++triggerCounter == TRIGGER_FRAMES) {
+    triggerCounter = 0;
+    uint8_t frame[LINK_FRAME_BYTES] = {LINK_SYNC, LINK_TRIGGER, (uint8_t)triggerSensor,
+                                       TRIGGER_SENSORS, (uint8_t)(1 << triggerSensor), 0, 0, 0, 0};
+    for (int i = 1; i < LINK_FRAME_BYTES - 1; i++) frame[LINK_FRAME_BYTES - 1] ^= frame[i];
+    for (int i = 0; i < LINK_FRAME_BYTES; i++) triggerLinkFeed(frame[i]);
+    triggerSensor = (triggerSensor + 1) % TRIGGER_SENSORS;
+  }
+  uint32_t triggers = triggerLinkTake();
+  for (int sensor = 0; triggers != 0; sensor++, triggers >>= 1) {
+    if (triggers & 1) digitalTrigger(canvas, sensor, triggerLinkSensorCount());
+  }
+  drawDigital(canvas);
+}
+
+/**
+ * drawReplay()
+ *
+ * Renders the next frame of the replay started in main().
+ */
+static void drawReplay(GFXcanvas16 &canvas) {
+  replayRender(canvas);
+}
+
+static const int SINK_DDP_PIXELS = 480;      // 1440-byte DDP payloads
+static const int SINK_PACKET_BYTES = 1500;
+static int sinkFrame = 0;
+static int sinkFrames = 0;
+static uint32_t sinkNowMicros = 0;
+
+/**
+ * sendSinkFrame()
+ *
+ * Builds stream frame n (a diagonal gradient that moves one pixel per
+ * frame) and feeds it to the sink as DDP or Art-Net packets arriving at
+ * arrivalMicros.
+ */
+static void sendSinkFrame(int n, bool ddp, uint32_t arrivalMicros) {
+  uint32_t pixels = (uint32_t)matrix->width() * matrix->height();
+  int rowPixels = PANEL_WIDTH * config.panelCount;
+  static uint8_t packet[SINK_PACKET_BYTES];
+  int perPacket = ddp ? SINK_DDP_PIXELS : ARTNET_PIXELS_PER_UNIVERSE;
+  int headerBytes = ddp ? 10 : 18;
+  for (uint32_t first = 0; first < pixels; first += perPacket) {
+    uint32_t count = min((uint32_t)perPacket, pixels - first);
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t p = first + i;
+      int x = p % rowPixels;
+      int y = p / rowPixels;
+      uint8_t *rgb = packet + headerBytes + i * 3;
+      rgb[0] = (uint8_t)(x + n);
+      rgb[1] = (uint8_t)(y * 8 + n);
+      rgb[2] = (uint8_t)(x - y - n);
+    }
+    if (ddp) {
+      uint32_t offset = first * 3;
+      uint32_t length = count * 3;
+      bool last = first + count >= pixels;
+      uint8_t header[10] = {(uint8_t)(0x40 | (last ? 0x01 : 0)), (uint8_t)(n & 0x0F), 0x0B, 1,
+                            (uint8_t)(offset >> 24), (uint8_t)(offset >> 16), (uint8_t)(offset >> 8), (uint8_t)offset,
+                            (uint8_t)(length >> 8), (uint8_t)length};
+      memcpy(packet, header, sizeof(header));
+      netsinkFeedDdp(packet, headerBytes + length, arrivalMicros);
+    } else {
+      int universe = config.sinkUniverse + first / ARTNET_PIXELS_PER_UNIVERSE;
+      uint32_t length = count * 3;
+      uint8_t header[18] = {'A', 'r', 't', '-', 'N', 'e', 't', 0, 0x00, 0x50, 0, 14, (uint8_t)n, 0,
+                            (uint8_t)universe, (uint8_t)(universe >> 8), (uint8_t)(length >> 8), (uint8_t)length};
+      memcpy(packet, header, sizeof(header));
+      netsinkFeedArtnet(packet, headerBytes + length, arrivalMicros);
+    }
+  }
+}
+
+/**
+ * drawSink()
+ *
+ * One display frame period of sink mode the way the sketch's loop()
+ * runs it. Stream frames are sent once per period but arrive late by a
+ * random 0-90% of a period, so some periods see none and others two.
+ */
+static void drawSink(GFXcanvas16 &canvas) {
+  sinkNowMicros += microsPerFrame;
+  uint32_t arrival = sinkNowMicros + (uint32_t)sceneRandom(microsPerFrame * 9 / 10);
+  sendSinkFrame(sinkFrame, sinkFrame < sinkFrames / 2, arrival);
+  sinkFrame++;
+  // Poll a few times a period, like loop() between frames
+  for (int step = 1; step <= 4; step++) {
+    netsinkTakeFrame(canvas, sinkNowMicros + step * microsPerFrame / 4, microsPerFrame);
+  }
+}
+
+static const uint32_t SHARD_MIN_LATENCY_MICROS = 300;
+static const uint32_t SHARD_MAX_LATENCY_MICROS = 1200;
+
+/**
+ * shardInput()
+ *
+ * Inputs of frame f of the sharded scenario: the switch and trigger
+ * patterns of --mode switch and --mode triggers combined.
+ */
+static ShardInput shardInput(int f) {
+  bool analog = (f / SWITCH_FRAMES) % 2 == 0;
+  ShardInput input = {0, TRIGGER_SENSORS, (uint8_t)(analog ? 1 : 0), (uint8_t)governorLevel()};
+  if (!analog && f % TRIGGER_FRAMES == 0) input.triggers = 1u << ((f / TRIGGER_FRAMES) % TRIGGER_SENSORS);
+  return input;
+}
+
+/** FNV-1a over rows firstRow .. firstRow + rows - 1 of a rotated canvas. */
+static uint64_t hashRows(GFXcanvas16 &canvas, int firstRow, int rows) {
+  int lineLength = canvas.height();
+  const uint16_t *pixels = canvas.getBuffer() + (lineLength - firstRow - rows);
+  uint64_t h = 14695981039346656037ULL;
+  for (int x = 0; x < canvas.width(); x++) {
+    for (int i = 0; i < rows; i++) h = (h ^ pixels[(int32_t)x * lineLength + i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+/**
+ * shardReference()
+ *
+ * Renders the scenario on one chain as long as the whole wall, the way
+ * renderScene() would, and keeps a hash of each node's rows per frame.
+ */
+static std::vector<std::vector<uint64_t>> shardReference(int nodes, int frames, uint32_t seed) {
+  Adafruit_Protomatter wallMatrix(PANEL_WIDTH * config.panelCount * nodes, config.bitDepth, 1, rgbPins,
+                                  4, addrPins, 2, 47, 14, false);
+  wallMatrix.begin();
+  wallMatrix.setRotation(1);
+  wallMatrix.fillScreen(0);
+  // The reference paints every row; the nodes set their own windows
+  fastDrawSetWindow(0, 0, 0);
+  transitionCancel();
+  transitionAllocate(wallMatrix, config.fadeFrames);
+  sceneRandomSeed(seed);
+  initDigital(wallMatrix, config.digitCharCount, config.charScale, config.maxEyes, config.digitTrail);
+  initAnalog(wallMatrix, config.maxWaves, config.waveGlow != 0);
+  std::vector<std::vector<uint64_t>> hashes(nodes, std::vector<uint64_t>(frames));
+  bool analog = true;
+  for (int f = 0; f < frames; f++) {
+    ShardInput input = shardInput(f);
+    for (int sensor = 0; sensor < TRIGGER_SENSORS; sensor++) {
+      if (input.triggers & (1u << sensor)) digitalTrigger(wallMatrix, sensor, input.sensorCount);
+    }
+    if ((input.analog != 0) != analog) {
+      analog = !analog;
+      if (analog) invalidateAnalog();
+      transitionBegin(wallMatrix, config.fadeFrames);
+    }
+    if (transitionActive()) {
+      transitionRender(wallMatrix, analog ? drawDigital : drawAnalog, analog ? drawAnalog : drawDigital);
+    } else if (analog) {
+      drawAnalog(wallMatrix);
+    } else {
+      drawDigital(wallMatrix);
+    }
+    for (int n = 0; n < nodes; n++) hashes[n][f] = hashRows(wallMatrix, n * matrix->height(), matrix->height());
+  }
+  transitionCancel();
+  return hashes;
+}
+
+struct ShardTally {
+  int shown;
+  int mismatched;
+};
+
+/**
+ * serviceShard()
+ *
+ * Calls shardService() at nowMicros until nothing more is due, the way
+ * loop() does, checking each frame shown against the reference.
+ */
+static void serviceShard(uint32_t nowMicros, const std::vector<uint64_t> &reference, ShardTally &tally) {
+  for (;;) {
+    ShardStep step = shardService(*matrix, nowMicros);
+    if (step == SHARD_IDLE) return;
+    if (step == SHARD_SHOW) {
+      matrix->show();
+      tally.shown++;
+      if (hashRows(*matrix, 0, matrix->height()) != reference[shardFrame()]) tally.mismatched++;
+      recordFrame(*matrix);
+    }
+  }
+}
+
+/**
+ * runShardWall()
+ *
+ * --mode shard: the leader's run produces the pulses, then each follower
+ * replays them as its network would deliver them.
+ */
+static void runShardWall(int frames, uint32_t seed) {
+  int nodes = config.shardCount > 1 ? config.shardCount : 3;
+  std::vector<std::vector<uint64_t>> reference = shardReference(nodes, frames, seed);
+  std::vector<std::vector<uint8_t>> pulses(frames, std::vector<uint8_t>(SHARD_PULSE_BYTES));
+
+  for (int node = 0; node < nodes; node++) {
+    if (!shardBegin(*matrix, nodes, node, seed)) {
+      printf("shard allocation failed\n");
+      return;
+    }
+    ShardTally tally = {0, 0};
+    uint32_t skew = node == 0 ? 0 : 0xFFF00000u + node * 7777;   // Follower clocks wrap mid-run
+    uint32_t jitter = 12345 + node;
+    Clock::time_point start = Clock::now();
+    for (int f = 0; f < frames; f++) {
+      uint32_t leaderMicros = (uint32_t)f * microsPerFrame;
+      if (node == 0) {
+        shardLeaderTick(shardInput(f), leaderMicros, pulses[f].data());
+        serviceShard(leaderMicros, reference[0], tally);
+        serviceShard(leaderMicros + SHARD_PRESENT_DELAY_US, reference[0], tally);
+        continue;
+      }
+      // Joins a few frames late, loses every 13th pulse and some bursts
+      bool dropped = f < node || f % 13 == 5 || (f % 500 >= 200 && f % 500 < 200 + SHARD_HISTORY - 2);
+      jitter = jitter * 1103515245u + 12345u;
+      uint32_t latency = SHARD_MIN_LATENCY_MICROS + (jitter >> 8) % (SHARD_MAX_LATENCY_MICROS - SHARD_MIN_LATENCY_MICROS);
+      uint32_t arrival = leaderMicros + skew + latency;
+      if (!dropped) shardFeed(pulses[f].data(), SHARD_PULSE_BYTES, arrival);
+      serviceShard(arrival, reference[node], tally);
+      serviceShard(leaderMicros + skew + SHARD_PRESENT_DELAY_US + SHARD_MAX_LATENCY_MICROS, reference[node], tally);
+    }
+    printf("\n[shard node %d/%d] %d frames, %.0f ns/frame, shown %d, mismatched %d\n", node, nodes, frames,
+           nsSince(start) / frames, tally.shown, tally.mismatched);
+    shardPrintStats();
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Primitive micro-benchmarks                                        */
+/* ------------------------------------------------------------------ */
+
+static volatile uint16_t sink;
+
+/**
+ * timePrimitive()
+ *
+ * Calls fn(i) for i = 0..iterations-1 and prints the average cost.
+ */
+template <typename Fn>
+static void timePrimitive(const char *name, int iterations, Fn fn) {
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < iterations; i++) fn(i);
+  double ns = nsSince(start) / iterations;
+  sink = matrix->getBuffer()[0];
+  printf("  %-34s %10.1f ns/call\n", name, ns);
+}
+
+static void runPrimitives() {
+  const int n = 200000;
+  int w = matrix->width();
+  int h = matrix->height();
+  uint16_t c = Adafruit_Protomatter::color565(255, 140, 0);
+
+  printf("\n[primitives]\n");
+  timePrimitive("gfx drawPixel x2 (trace)", n, [&](int i) {
+    matrix->drawPixel(i % w, i % h, c);
+    matrix->drawPixel(i % w + 1, i % h, c);
+  });
+  timePrimitive("fastTrace", n, [&](int i) { fastTrace(*matrix, i % w, i % h, c); });
+  timePrimitive("gfx drawFastHLine full row", n, [&](int i) { matrix->drawFastHLine(0, i % h, w, c); });
+  timePrimitive("fastHLine full row", n, [&](int i) { fastHLine(*matrix, 0, i % h, w, c); });
+  timePrimitive("gfx drawFastVLine 51 rows", n, [&](int i) { matrix->drawFastVLine(i % w, i % (h - 51), 51, c); });
+  timePrimitive("fastVLine 51 rows", n, [&](int i) { fastVLine(*matrix, i % w, i % (h - 51), 51, c); });
+  timePrimitive("gfx fillRect 32x100", n / 20, [&](int i) { matrix->fillRect(0, i % (h - 100), w, 100, c); });
+  timePrimitive("fastFillRect 32x100", n / 20, [&](int i) { fastFillRect(*matrix, 0, i % (h - 100), w, 100, c); });
+  timePrimitive("gfx fillScreen", n / 200, [&](int) { matrix->fillScreen(c); });
+  timePrimitive("gfx drawChar scale 4", n / 20, [&](int i) { matrix->drawChar(6, i % h, '0' + (i & 1), 0xFFFF, c, 4); });
+  FastSprite glyph;
+  if (fastSpriteFromChar(glyph, '0', 4)) {
+    timePrimitive("fastBlitSprite glyph scale 4", n / 20, [&](int i) { fastBlitSprite(*matrix, glyph, 6, i % h, 0xFFFF, c); });
+    timePrimitive("fastBlitSpriteMask glyph scale 4", n / 20, [&](int i) { fastBlitSpriteMask(*matrix, glyph, 6, i % h, 0xFFFF); });
+    fastSpriteFree(glyph);
+  }
+  timePrimitive("gfx drawLine (lid edge)", n, [&](int i) { matrix->drawLine(16, i % h, 2, i % h + 25, c); });
+  timePrimitive("gfx drawCircle r=200", n / 20, [&](int i) { matrix->drawCircle(16, i % h, 200, 0); });
+  timePrimitive("fastCircle r=200", n / 20, [&](int i) { fastCircle(*matrix, 16, i % h, 200, 0); });
+  timePrimitive("gfx fillCircle r=4", n, [&](int i) { matrix->fillCircle(16, i % h, 4, c); });
+  uint16_t *layer = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+  if (layer != NULL) {
+    timePrimitive("transitionMix565 full screen", n / 200, [&](int i) {
+      transitionMix565(matrix->getBuffer(), matrix->getBuffer(), layer, (uint32_t)w * h, i & 31);
+    });
+    free(layer);
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Entry point                                                       */
+/* ------------------------------------------------------------------ */
+
+static void usage() {
+  printf("usage: bench [--frames N] [--seed S] [--mode analog|digital|both|switch|triggers|replay|sink|shard]\n"
+         "             [--no-primitives] [--dump DIR] [--raw FILE]\n"
+         "             [--set KEY=VALUE ...]   (config.h settings, e.g. panels=4)\n"
+         "             [--quality LEVEL]       (governor level, 0 = full .. 4 = half rows)\n");
+}
+
+int main(int argc, char **argv) {
+  int frames = 3600;
+  unsigned long seed = 1;
+  std::string mode = "both";
+  bool primitives = true;
+  configDefaults(config);
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = (i + 1 < argc);
+    if (arg == "--frames" && hasValue) frames = atoi(argv[++i]);
+    else if (arg == "--seed" && hasValue) seed = strtoul(argv[++i], NULL, 0);
+    else if (arg == "--mode" && hasValue) mode = argv[++i];
+    else if (arg == "--no-primitives") primitives = false;
+    else if (arg == "--dump" && hasValue) dumpDir = argv[++i];
+    else if (arg == "--raw" && hasValue) rawFile = fopen(argv[++i], "wb");
+    else if (arg == "--quality" && hasValue) governorForceLevel(atoi(argv[++i]));
+    else if (arg == "--set" && hasValue) {
+      // Same parser as the sketch's serial 'c <key> <value>' command
+      std::string setting = argv[++i];
+      size_t eq = setting.find('=');
+      if (eq != std::string::npos) setting[eq] = ' ';
+      configCommand(config, setting.c_str());
+    }
+    else {
+      usage();
+      return 1;
+    }
+  }
+
+  randomSeed(seed);
+  sceneRandomSeed(seed);
+  microsPerFrame = 1000000 / config.maxFPS;
+  matrix = new Adafruit_Protomatter(PANEL_WIDTH * config.panelCount, config.bitDepth, 1, rgbPins,
+                                    4, addrPins, 2, 47, 14, config.doubleBuffer != 0);
+  matrix->begin();
+  matrix->setRotation(1);
+  matrix->fillScreen(0);
+  ditherBegin(config.bitDepth, config.gammaTenths, config.ditherScenes);
+  if (!initDigital(*matrix, config.digitCharCount, config.charScale, config.maxEyes, config.digitTrail) ||
+      !initAnalog(*matrix, config.maxWaves, config.waveGlow != 0)) {
+    printf("scene allocation failed\n");
+    return 1;
+  }
+  if (!transitionAllocate(*matrix, config.fadeFrames)) {
+    printf("fade layer allocation failed\n");
+    return 1;
+  }
+
+  printf("canvas %dx%d (rotated), seed %lu\n", matrix->width(), matrix->height(), seed);
+  if (mode == "analog" || mode == "both") runScene("analog", drawAnalog, frames);
+  if (mode == "both") invalidateAnalog();
+  if (mode == "digital" || mode == "both") runScene("digital", drawDigital, frames);
+  if (mode == "switch") runScene("switch", drawSwitching, frames);
+  if (mode == "triggers") runScene("triggers", drawTriggered, frames);
+  if (mode == "replay") {
+    replayStart(frames, seed, -1);
+    runScene("replay", drawReplay, frames);
+    replayPoll();
+  }
+  if (mode == "sink") {
+    if (!netsinkBegin(*matrix, config.sinkJitter, config.sinkUniverse)) {
+      printf("sink allocation failed\n");
+      return 1;
+    }
+    sinkFrames = frames;
+    runScene("sink", drawSink, frames);
+    netsinkPrintStats();
+  }
+  if (mode == "shard") runShardWall(frames, seed);
+  printf("\nframe checksum %016llx\n", (unsigned long long)frameHash);
+
+  if (rawFile) fclose(rawFile);
+  if (primitives) runPrimitives();
+  return 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * Adafruit_Protomatter.h (host mock)
+ *
+ * Stand-in for the HUB75 driver: a GFXcanvas16 with the same constructor
+ * and begin()/show()/color565() interface. show() only counts frames; the
+ * host driver reads the canvas directly.
+ */
+
+#ifndef HOST_ADAFRUIT_PROTOMATTER_H
+#define HOST_ADAFRUIT_PROTOMATTER_H
+
+#include <Arduino.h>
+#include "Adafruit_GFX.h"
+
+typedef enum {
+  PROTOMATTER_OK,
+  PROTOMATTER_ERR_PINS,
+  PROTOMATTER_ERR_MALLOC,
+  PROTOMATTER_ERR_ARG,
+} ProtomatterStatus;
+
+class Adafruit_Protomatter : public GFXcanvas16 {
+public:
+  Adafruit_Protomatter(uint16_t bitWidth, uint8_t bitDepth, uint8_t rgbCount, uint8_t *rgbList,
+                       uint8_t addrCount, uint8_t *addrList, uint8_t clockPin, uint8_t latchPin,
+                       uint8_t oePin, bool doubleBuffer, int8_t tile = 1, void *timer = NULL)
+    : GFXcanvas16(bitWidth, (2 << min((int)addrCount, 5)) * min((int)rgbCount, 2) * (tile < 0 ? -tile : tile)),
+      bitDepth(bitDepth), frameCount(0) {
+    (void)rgbList; (void)addrList; (void)clockPin; (void)latchPin; (void)oePin;
+    (void)doubleBuffer; (void)timer;
+  }
+
+  ProtomatterStatus begin(void) { return PROTOMATTER_OK; }
+
+  void show(void) {
+    frameCount++;
+  }
+
+  uint32_t getFrameCount(void) const { return frameCount; }
+
+  static uint16_t color565(uint8_t red, uint8_t green, uint8_t blue) {
+    return ((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3);
+  }
+
+  uint8_t bitDepth;  // Host-only: recorded for reporting
+  uint32_t frameCount;
+};
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * Arduino.cpp (host mock)
+ *
+ * Runtime behind the host Arduino.h: steady-clock timing, a seedable
+ * random(), pin state storage, and stdout-backed Serial.
+ */
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+HostSerial Serial;
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint32_t micros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+/* Deterministic LCG so every host run with the same seed is identical. */
+static uint32_t randState = 1;
+
+void randomSeed(unsigned long seed) {
+  randState = (uint32_t)seed ? (uint32_t)seed : 1;
+}
+
+static uint32_t nextRandom() {
+  randState = randState * 1103515245UL + 12345UL;
+  return randState >> 1;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return nextRandom() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+static int pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin < 64 && mode == INPUT_PULLUP) pinLevels[pin] = HIGH;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < 64 ? pinLevels[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < 64) pinLevels[pin] = val;
+}
+
+void hostSetPin(uint8_t pin, int val) {
+  if (pin < 64) pinLevels[pin] = val;
+}
+
+static std::string serialInput;
+
+void hostSerialFeed(const char *s) {
+  serialInput += s;
+}
+
+int HostSerial::available() {
+  return (int)serialInput.size();
+}
+
+int HostSerial::read() {
+  if (serialInput.empty()) return -1;
+  int c = (unsigned char)serialInput[0];
+  serialInput.erase(0, 1);
+  return c;
+}
+
+size_t HostSerial::printf(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vprintf(fmt, args);
+  va_end(args);
+  return n < 0 ? 0 : (size_t)n;
+}
@@ -0,0 +1,83 @@
+/**
+ * Arduino.h (host mock)
+ *
+ * Minimal stand-in for the Arduino core so the scene code can be built
+ * and benchmarked on a desktop. Only the calls the sketch actually uses
+ * are provided. Time comes from a steady clock; random() comes from a
+ * seedable deterministic generator so runs are repeatable.
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+
+using std::max;
+using std::min;
+using std::abs;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#define LOW  0
+#define HIGH 1
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+#define A1 16
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t val);
+/** Host-only hook: sets the level returned by digitalRead(). */
+void hostSetPin(uint8_t pin, int val);
+
+/**
+ * HostSerial
+ *
+ * Prints to stdout. Input is always empty unless fed via hostSerialFeed().
+ */
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+  int available();
+  int read();
+  int availableForWrite() { return 4096; }
+  size_t write(uint8_t b) { return fwrite(&b, 1, 1, stdout); }
+  size_t write(const uint8_t *buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+  size_t print(const char *s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+  size_t print(char c) { return fputc(c, stdout) != EOF; }
+  size_t print(int v) { return printf("%d", v); }
+  size_t print(unsigned int v) { return printf("%u", v); }
+  size_t print(long v) { return printf("%ld", v); }
+  size_t print(unsigned long v) { return printf("%lu", v); }
+  size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+  size_t println() { return fputs("\n", stdout) >= 0; }
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  size_t println(double v, int digits) { size_t n = print(v, digits); return n + println(); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  void flush() { fflush(stdout); }
+};
+
+extern HostSerial Serial;
+/** Host-only hook: queues bytes to be returned by Serial.read(). */
+void hostSerialFeed(const char *s);
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * elapsedMillis.h (host mock)
+ *
+ * Same interface as the elapsedMillis library: an integer-like value that
+ * counts up on its own and can be reset by assigning to it.
+ */
+
+#ifndef HOST_ELAPSEDMILLIS_H
+#define HOST_ELAPSEDMILLIS_H
+
+#include <Arduino.h>
+
+class elapsedMillis {
+private:
+  unsigned long ms;
+public:
+  elapsedMillis(void) { ms = millis(); }
+  elapsedMillis(unsigned long val) { ms = millis() - val; }
+  operator unsigned long () const { return millis() - ms; }
+  elapsedMillis & operator = (unsigned long val) { ms = millis() - val; return *this; }
+};
+
+class elapsedMicros {
+private:
+  unsigned long us;
+public:
+  elapsedMicros(void) { us = micros(); }
+  elapsedMicros(unsigned long val) { us = micros() - val; }
+  operator unsigned long () const { return micros() - us; }
+  elapsedMicros & operator = (unsigned long val) { us = micros() - val; return *this; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef EDGE_QUEUE_H
+#define EDGE_QUEUE_H
+
+#include <Arduino.h>
+
+/**
+ * Edge - One input pin change captured by a sensor's pin interrupt.
+ */
+struct Edge {
+    uint32_t micros;        // micros() when the interrupt ran
+    uint8_t sensor;         // Index of the Sensor whose pin changed
+    uint8_t level;          // Pin level after the change (HIGH or LOW)
+};
+
+/**
+ * EdgeQueue - Lock-free single-producer/single-consumer ring of pin edges.
+ *
+ * Pin interrupts push, loop() pops. All GPIO interrupts run at the same
+ * priority and never preempt each other, so pushes from different pins
+ * still count as a single producer. Each index is written by only one
+ * side, and a slot is filled before head moves past it (the Teensy is
+ * single-core, so compiler barriers are enough), so no interrupts need
+ * disabling.
+ *
+ * If loop() falls so far behind that the ring fills, new edges are dropped
+ * and counted. The sensor then re-reads its pin instead of trusting
+ * stale edges.
+ */
+class EdgeQueue {
+public:
+    static const uint8_t CAPACITY = 64;     // Power of two
+
+    EdgeQueue() : _head(0), _tail(0), _dropped(0) {}
+
+    /** Appends an edge. Call only from the pin interrupt. @return false if the ring was full. */
+    bool push(uint8_t sensor, uint8_t level, uint32_t now) {
+        uint8_t head = _head;
+        if ((uint8_t)(head - _tail) >= CAPACITY) {
+            _dropped++;
+            return false;
+        }
+        Edge &slot = _edges[head & (CAPACITY - 1)];
+        slot.micros = now;
+        slot.sensor = sensor;
+        slot.level = level;
+        __asm__ volatile("" ::: "memory");  // Slot contents before the new head
+        _head = head + 1;
+        return true;
+    }
+
+    /** Removes the oldest edge into edge. Call only from loop(). @return false if empty. */
+    bool pop(Edge &edge) {
+        uint8_t tail = _tail;
+        if (tail == _head) return false;
+        __asm__ volatile("" ::: "memory");  // Read the slot only after seeing the head
+        edge = _edges[tail & (CAPACITY - 1)];
+        __asm__ volatile("" ::: "memory");  // Finish reading before releasing the slot
+        _tail = tail + 1;
+        return true;
+    }
+
+    /** True if nothing is waiting to be popped. */
+    bool empty() const { return _tail == _head; }
+
+    /** Number of edges lost because the ring was full. */
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    Edge _edges[CAPACITY];
+    volatile uint8_t _head;     // Written by the interrupt only
+    volatile uint8_t _tail;     // Written by loop() only
+    volatile uint32_t _dropped;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "MidiQueue.h"
+#include <string.h>
+
+MidiQueue midiOut;
+
+MidiQueue::MidiQueue() {
+    _count = 0;
+    _sent = 0;
+    _flushes = 0;
+    _coalesced = 0;
+    _maxWaitMicros = 0;
+    memset(_sounding, 0, sizeof(_sounding));
+}
+
+int MidiQueue::_find(Type type, uint8_t data1, uint8_t channel) const {
+    for (int i = 0; i < _count; i++) {
+        const Message &m = _messages[i];
+        if (m.type == type && m.data1 == data1 && m.channel == channel) return i;
+    }
+    return -1;
+}
+
+void MidiQueue::_remove(int index) {
+    for (int i = index + 1; i < _count; i++) _messages[i - 1] = _messages[i];
+    _count--;
+}
+
+void MidiQueue::_push(Type type, uint8_t data1, uint8_t data2, uint8_t channel) {
+    if (_count >= CAPACITY) flush();
+    Message &m = _messages[_count++];
+    m.queuedMicros = micros();
+    m.type = type;
+    m.data1 = data1;
+    m.data2 = data2;
+    m.channel = channel;
+}
+
+void MidiQueue::noteOn(uint8_t note, uint8_t velocity, uint8_t channel) {
+    _push(NOTE_ON, note, velocity, channel);
+}
+
+/**
+ * A note that was switched on and off within the same pass never sounded, so both messages
+ * are dropped. Only the most recent queued note-on can be cancelled: anything queued after a
+ * note-off (a retrigger) must still go out.
+ */
+void MidiQueue::noteOff(uint8_t note, uint8_t velocity, uint8_t channel) {
+    int on = _find(NOTE_ON, note, channel);
+    if (on >= 0 && _find(NOTE_OFF, note, channel) < 0) {
+        _remove(on);
+        _coalesced += 2;
+        return;
+    }
+    _push(NOTE_OFF, note, velocity, channel);
+}
+
+/**
+ * Only the latest value of a controller matters to QLC+, so a queued CC for the same controller
+ * is updated in place.
+ */
+void MidiQueue::controlChange(uint8_t control, uint8_t value, uint8_t channel) {
+    int queued = _find(CONTROL_CHANGE, control, channel);
+    if (queued >= 0) {
+        _messages[queued].data2 = value;
+        _coalesced++;
+        return;
+    }
+    _push(CONTROL_CHANGE, control, value, channel);
+}
+
+void MidiQueue::flush() {
+    if (_count == 0) return;
+    uint32_t now = micros();
+    for (int i = 0; i < _count; i++) {
+        const Message &m = _messages[i];
+        uint32_t &notes = _sounding[(m.channel - 1) & 15][(m.data1 >> 5) & 3];
+        switch (m.type) {
+            case NOTE_ON:
+                usbMIDI.sendNoteOn(m.data1, m.data2, m.channel);
+                notes |= 1UL << (m.data1 & 31);
+                break;
+            case NOTE_OFF:
+                usbMIDI.sendNoteOff(m.data1, m.data2, m.channel);
+                notes &= ~(1UL << (m.data1 & 31));
+                break;
+            case CONTROL_CHANGE:
+                usbMIDI.sendControlChange(m.data1, m.data2, m.channel);
+                break;
+        }
+        uint32_t wait = now - m.queuedMicros;
+        if (wait > _maxWaitMicros) _maxWaitMicros = wait;
+    }
+    usbMIDI.send_now();
+    _sent += _count;
+    _flushes++;
+    _count = 0;
+}
+
+void MidiQueue::printStats() {
+    Serial.printf("midi: %lu sent in %lu flushes, %lu coalesced, max queue wait %lu us\n",
+                  (unsigned long)_sent, (unsigned long)_flushes, (unsigned long)_coalesced,
+                  (unsigned long)_maxWaitMicros);
+}
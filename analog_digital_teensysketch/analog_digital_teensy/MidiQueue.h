@@ -0,0 +1,82 @@
+#ifndef MIDI_QUEUE_H
+#define MIDI_QUEUE_H
+
+#include <Arduino.h>
+
+/**
+ * MidiQueue - Collects the USB MIDI messages produced during one checkSensors() pass and sends
+ * them together.
+ *
+ * Sensors queue note and CC messages instead of calling usbMIDI directly. flush() then writes
+ * them all and calls usbMIDI.send_now() once, so every state change from a pass leaves in the
+ * same USB transfer, and QLC+ and the DAW see them together. While queuing:
+ *   - a note-off cancels a still-queued note-on for the same note and channel (both are dropped)
+ *   - a CC replaces a still-queued CC with the same number and channel
+ * A note-off followed by a note-on is a retrigger and is kept.
+ *
+ * Each message is timestamped when queued; printStats() reports the longest wait until flush.
+ * flush() also records which notes are sounding, so a soak test can check that every note the
+ * sensors think is off really was switched off over USB.
+ */
+class MidiQueue {
+public:
+    static const uint8_t CAPACITY = 32;    // Flushes early if a pass queues more
+
+    MidiQueue();
+
+    /** Queues a note-on. */
+    void noteOn(uint8_t note, uint8_t velocity, uint8_t channel);
+
+    /** Queues a note-off, or cancels the matching queued note-on. */
+    void noteOff(uint8_t note, uint8_t velocity, uint8_t channel);
+
+    /** Queues a control change, replacing a queued one for the same controller. */
+    void controlChange(uint8_t control, uint8_t value, uint8_t channel);
+
+    /** Sends every queued message, then pushes them out with usbMIDI.send_now(). */
+    void flush();
+
+    /** Prints message, flush and coalescing counts and the longest queue wait over Serial. */
+    void printStats();
+
+    /** True if the last message flushed for this note and channel (1-16) was a note-on. */
+    bool sounding(uint8_t note, uint8_t channel) const {
+        return _sounding[(channel - 1) & 15][(note >> 5) & 3] & (1UL << (note & 31));
+    }
+
+    /** Messages written to USB since boot. */
+    uint32_t sent() const { return _sent; }
+
+private:
+    enum Type : uint8_t { NOTE_ON, NOTE_OFF, CONTROL_CHANGE };
+
+    struct Message {
+        uint32_t queuedMicros;  // micros() when queued
+        Type type;
+        uint8_t data1;          // Note or controller number
+        uint8_t data2;          // Velocity or value
+        uint8_t channel;
+    };
+
+    Message _messages[CAPACITY];
+    uint8_t _count;
+    uint32_t _sent;             // Messages written to USB
+    uint32_t _flushes;          // send_now() calls
+    uint32_t _coalesced;        // Messages dropped or merged while queued
+    uint32_t _maxWaitMicros;    // Longest queued-to-sent time
+    uint32_t _sounding[16][4];  // Per channel, bit n = note n is on as sent
+
+    /** Index of the queued message matching type, data1 and channel, or -1. */
+    int _find(Type type, uint8_t data1, uint8_t channel) const;
+
+    /** Removes the message at index, keeping the order of the rest. */
+    void _remove(int index);
+
+    /** Appends a message, flushing first if the queue is full. */
+    void _push(Type type, uint8_t data1, uint8_t data2, uint8_t channel);
+};
+
+/** The queue all sensors send through; flushed by checkSensors(). */
+extern MidiQueue midiOut;
+
+#endif
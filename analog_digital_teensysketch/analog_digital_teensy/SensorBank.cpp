@@ -0,0 +1,487 @@
+#include "SensorBank.h"
+#include "EdgeQueue.h"
+#include "MidiQueue.h"
+#include "TriggerLink.h"
+#include <EEPROM.h>
+#include <string.h>
+
+SensorBank sensors;
+
+// QLC+ only listens on one MIDI channel, so all CC messages share channel 16.
+static const uint8_t MIDI_CC_CHANNEL = 16;
+
+// SysEx addressing and commands (see handleSysEx())
+static const uint8_t SYSEX_MANUFACTURER = 0x7D;
+static const uint8_t SYSEX_DEVICE = 0x41;
+static const uint8_t SYSEX_SET = 0x01;
+static const uint8_t SYSEX_SAVE = 0x02;
+static const uint8_t SYSEX_DEFAULTS = 0x03;
+static const uint8_t SYSEX_DUMP = 0x04;
+static const uint8_t SYSEX_DUMP_REPLY = 0x05;
+static const uint8_t PARAM_COUNT = 6;
+
+// Settings saved over SysEx. Bump SAVED_VERSION if SensorSettings changes layout.
+static const uint8_t SAVED_VERSION = 1;
+static const int SAVED_ADDRESS = 0;
+
+struct SavedSettings {
+    uint8_t version;
+    uint8_t count;
+    SensorSettings sensors[SensorBank::MAX_SENSORS];
+};
+
+#if SENSOR_INTERRUPTS
+static EdgeQueue edges;
+static uint32_t droppedSeen = 0;     // edges.dropped() when processEdges() last resynced
+static uint8_t isrPins[SensorBank::MAX_SENSORS];   // Input pin of each sensor, for the interrupts
+#endif
+
+/** Sensor i's bit in the flag masks. */
+static inline uint32_t maskOf(uint8_t i) { return 1UL << i; }
+
+// Trigger latency across all sensors: debounce satisfied -> MIDI note queued (micros)
+static uint32_t latencyCount = 0;
+static uint32_t latencyTotal = 0;
+static uint32_t latencyMax = 0;
+
+SensorBank::SensorBank() {
+    _count = 0;
+    _table = NULL;
+    _portCount = 0;
+    _state = 0;
+    _level = 0;
+    _debouncing = 0;
+    _analogActive = 0;
+    _digitalActive = 0;
+    _simulated = 0;
+    _simulatedLevel = 0;
+    memset(_triggers, 0, sizeof(_triggers));
+    memset(_rejects, 0, sizeof(_rejects));
+    memset(&_timing, 0, sizeof(_timing));
+}
+
+void SensorBank::_apply(uint8_t i, const SensorSettings &s) {
+    _inPin[i] = s.inPin;
+    _outPin[i] = s.outPin;
+    _channelAnalog[i] = s.channelAnalog;
+    _channelDigital[i] = s.channelDigital;
+    _note[i] = s.note;
+    _velocity[i] = s.velocity;
+    _durationMs[i] = s.durationMs;
+    _debounceMs[i] = s.debounceMs;
+}
+
+/**
+ * On Teensy 4.x every pin is a bit in a 32-bit GPIO data register, so pins that share a port
+ * are read together. Elsewhere each pin is its own "port" and is read with digitalReadFast().
+ */
+void SensorBank::_mapPin(uint8_t i) {
+#if defined(__IMXRT1062__)
+    volatile uint32_t *reg = portInputRegister(_inPin[i]);
+    _mask[i] = digitalPinToBitMask(_inPin[i]);
+    for (uint8_t p = 0; p < _portCount; p++) {
+        if (_portRegs[p] == reg) {
+            _port[i] = p;
+            return;
+        }
+    }
+    _portRegs[_portCount] = reg;
+#else
+    _mask[i] = 1;
+    _portRegs[_portCount] = NULL;
+#endif
+    _port[i] = _portCount++;
+}
+
+void SensorBank::_pollPins() {
+#if defined(__IMXRT1062__)
+    uint32_t ports[MAX_SENSORS];
+    for (uint8_t p = 0; p < _portCount; p++) ports[p] = *_portRegs[p];
+    uint32_t level = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (ports[_port[i]] & _mask[i]) level |= maskOf(i);
+    }
+#else
+    uint32_t level = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (digitalReadFast(_inPin[i])) level |= maskOf(i);
+    }
+#endif
+    _level = (level & ~_simulated) | (_simulatedLevel & _simulated);
+}
+
+#if SENSOR_INTERRUPTS
+/**
+ * Pin interrupt: timestamps the change and queues it for processEdges(). One instance per
+ * sensor index, since attachInterrupt() takes a plain function.
+ */
+template <uint8_t I>
+static void edgeIsr() {
+    edges.push(I, digitalReadFast(isrPins[I]), micros());
+}
+#endif
+
+/**
+ * Sends note-on on the analog channel. Ignored if already active.
+ */
+void SensorBank::playAnalog(uint8_t i) {
+    if (_analogActive & maskOf(i)) return;
+    midiOut.noteOn(_note[i], _velocity[i], _channelAnalog[i]);
+    _analogActive |= maskOf(i);
+}
+
+/**
+ * Sends note-off on the analog channel. Ignored if not active.
+ */
+void SensorBank::stopAnalog(uint8_t i) {
+    if (!(_analogActive & maskOf(i))) return;
+    midiOut.noteOff(_note[i], _velocity[i], _channelAnalog[i]);
+    _analogActive &= ~maskOf(i);
+}
+
+/**
+ * Stops the analog note, sends note-on on the digital channel, drives output pin HIGH,
+ * and starts the note duration timer. Ignored if digital is already active.
+ */
+void SensorBank::playDigital(uint8_t i) {
+    if (_digitalActive & maskOf(i)) return;
+    stopAnalog(i);
+    digitalWrite(_outPin[i], HIGH);
+    midiOut.noteOn(_note[i], _velocity[i], _channelDigital[i]);
+    midiOut.controlChange(_channelAnalog[i] * 2, 1, MIDI_CC_CHANNEL);
+    _noteStartMs[i] = millis();
+    _digitalActive |= maskOf(i);
+    triggerLink.trigger(i, _digitalActive, _count);
+}
+
+/**
+ * Sends note-off on the digital channel, drives output pin LOW, and resumes the analog note.
+ * Ignored if digital is not active.
+ */
+void SensorBank::stopDigital(uint8_t i) {
+    if (!(_digitalActive & maskOf(i))) return;
+    digitalWrite(_outPin[i], LOW);
+    midiOut.noteOff(_note[i], _velocity[i], _channelDigital[i]);
+    midiOut.controlChange(_channelAnalog[i] * 2 + 1, 1, MIDI_CC_CHANNEL);
+    _digitalActive &= ~maskOf(i);
+    triggerLink.state(_digitalActive, _count);
+    playAnalog(i);
+}
+
+bool SensorBank::begin(const SensorSettings *table, uint8_t count) {
+    bool fits = count <= MAX_SENSORS;
+    if (!fits) count = MAX_SENSORS;
+    _table = table;
+    _count = count;
+    for (uint8_t i = 0; i < count; i++) _apply(i, table[i]);
+    _loadSaved();
+
+    for (uint8_t i = 0; i < count; i++) {
+        pinMode(_inPin[i], INPUT);
+        pinMode(_outPin[i], OUTPUT);
+        digitalWrite(_outPin[i], LOW);
+        _mapPin(i);
+        playAnalog(i);
+    }
+
+#if SENSOR_INTERRUPTS
+    static void (*const isrs[MAX_SENSORS])() = {
+        edgeIsr<0>,  edgeIsr<1>,  edgeIsr<2>,  edgeIsr<3>,  edgeIsr<4>,  edgeIsr<5>,  edgeIsr<6>,  edgeIsr<7>,
+        edgeIsr<8>,  edgeIsr<9>,  edgeIsr<10>, edgeIsr<11>, edgeIsr<12>, edgeIsr<13>, edgeIsr<14>, edgeIsr<15>,
+        edgeIsr<16>, edgeIsr<17>, edgeIsr<18>, edgeIsr<19>, edgeIsr<20>, edgeIsr<21>, edgeIsr<22>, edgeIsr<23>,
+        edgeIsr<24>, edgeIsr<25>, edgeIsr<26>, edgeIsr<27>, edgeIsr<28>, edgeIsr<29>, edgeIsr<30>, edgeIsr<31>,
+    };
+    for (uint8_t i = 0; i < count; i++) {
+        isrPins[i] = _inPin[i];
+        attachInterrupt(digitalPinToInterrupt(_inPin[i]), isrs[i], CHANGE);
+    }
+#endif
+    // A pin that is already HIGH starts debouncing as if it had just risen
+    _pollPins();
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < count; i++) _onEdge(i, _level & maskOf(i), now);
+    return fits;
+}
+
+/**
+ * Applies one pin change. A rise starts the debounce window from the moment of the edge;
+ * a fall inside the window cancels it. Changes while a digital note plays only update the
+ * level, so the pin must go LOW again before it can retrigger.
+ */
+void SensorBank::_onEdge(uint8_t i, bool high, uint32_t when) {
+    uint32_t b = maskOf(i);
+    if (high) _level |= b;
+    else _level &= ~b;
+    if (_digitalActive & b) return;
+
+    if (_debouncing & b) {
+        // Input dropped before debounce period elapsed — false trigger
+        if (!high) {
+            _debouncing &= ~b;
+            _rejects[i]++;
+        }
+        return;
+    }
+
+    if (high == ((_state & b) != 0)) return;
+
+    if (high) {
+        // Input just went HIGH — start debounce timer
+        _debouncing |= b;
+        _debounceStart[i] = when;
+    } else {
+        _state &= ~b;
+    }
+}
+
+/**
+ * Confirms the trigger once the input has been held HIGH for the debounce time, and records
+ * how late past that point the note went out.
+ */
+void SensorBank::_checkDebounce(uint8_t i) {
+    uint32_t held = micros() - _debounceStart[i];
+    uint32_t window = (uint32_t)_debounceMs[i] * 1000;
+    if (held < window) return;
+
+    // Input held HIGH long enough — confirmed trigger
+    _debouncing &= ~maskOf(i);
+    _state |= maskOf(i);
+    playDigital(i);
+
+    _triggers[i]++;
+    _timing.count++;
+    _timing.totalMicros += held;
+    if (held > _timing.maxMicros) _timing.maxMicros = held;
+
+    uint32_t late = held - window;
+    latencyCount++;
+    latencyTotal += late;
+    if (late > latencyMax) latencyMax = late;
+}
+
+/**
+ * Drains the edge queue into the sensors. If edges were dropped because the queue filled,
+ * every pin is re-read and applied as a fresh change instead.
+ */
+void SensorBank::processEdges() {
+#if SENSOR_INTERRUPTS
+    Edge edge;
+    while (edges.pop(edge)) {
+        if (_simulated & maskOf(edge.sensor)) continue;
+        _onEdge(edge.sensor, edge.level, edge.micros);
+    }
+    uint32_t dropped = edges.dropped();
+    if (dropped != droppedSeen) {
+        droppedSeen = dropped;
+        _pollPins();
+        uint32_t now = micros();
+        uint32_t level = _level;
+        for (uint8_t i = 0; i < _count; i++) _onEdge(i, level & maskOf(i), now);
+    }
+#endif
+}
+
+SensorSettings SensorBank::settings(uint8_t i) const {
+    SensorSettings s;
+    s.inPin = _inPin[i];
+    s.outPin = _outPin[i];
+    s.channelAnalog = _channelAnalog[i];
+    s.channelDigital = _channelDigital[i];
+    s.note = _note[i];
+    s.velocity = _velocity[i];
+    s.durationMs = _durationMs[i];
+    s.debounceMs = _debounceMs[i];
+    return s;
+}
+
+/**
+ * Simulated sensors start LOW, a fall if their pin was HIGH. Released ones re-read their pin,
+ * in both input modes, since their real edges were dropped while simulated.
+ */
+void SensorBank::simulate(uint32_t mask) {
+    if (_count < 32) mask &= maskOf(_count) - 1;
+    uint32_t released = _simulated & ~mask;
+    uint32_t added = mask & ~_simulated;
+    _simulated = mask;
+    _simulatedLevel &= ~added;
+    uint32_t previous = _level;
+    _pollPins();
+    uint32_t now = micros();
+    uint32_t level = _level;
+    for (uint8_t i = 0; i < _count; i++) {
+        uint32_t b = maskOf(i);
+        if ((released & b) || ((added & b) && (previous & b))) _onEdge(i, level & b, now);
+    }
+}
+
+void SensorBank::simulateInput(uint8_t i, bool high) {
+    uint32_t b = maskOf(i);
+    if (!(_simulated & b) || high == ((_simulatedLevel & b) != 0)) return;
+    if (high) _simulatedLevel |= b;
+    else _simulatedLevel &= ~b;
+    _onEdge(i, high, micros());
+}
+
+uint32_t SensorBank::edgesDropped() const {
+#if SENSOR_INTERRUPTS
+    return edges.dropped();
+#else
+    return 0;
+#endif
+}
+
+SensorBank::TriggerTiming SensorBank::takeTiming() {
+    TriggerTiming timing = _timing;
+    memset(&_timing, 0, sizeof(_timing));
+    return timing;
+}
+
+/**
+ * True if pin edges are waiting for processEdges(). Always false when polling.
+ */
+bool SensorBank::edgesPending() const {
+#if SENSOR_INTERRUPTS
+    return !edges.empty();
+#else
+    return false;
+#endif
+}
+
+/**
+ * Runs every sensor's timers. Detects rising edges (LOW → HIGH) on the input pins: the input
+ * must stay HIGH for the debounce time before triggering, filtering out noise. While a digital
+ * note is active, new triggers are ignored until it expires. With SENSOR_INTERRUPTS the edges
+ * have already been applied by processEdges(); otherwise all pins are read first.
+ */
+void SensorBank::check() {
+    uint32_t nowMs = millis();
+    uint32_t playing = _digitalActive;
+    for (uint8_t i = 0; playing != 0; i++, playing >>= 1) {
+        // Auto-off timer: stops the digital note and resumes analog once the duration has elapsed
+        if ((playing & 1) && nowMs - _noteStartMs[i] >= _durationMs[i]) stopDigital(i);
+    }
+
+#if SENSOR_INTERRUPTS
+    // Released while the digital note played
+    _state &= _level | _digitalActive | _debouncing;
+#else
+    uint32_t previous = _level;
+    _pollPins();
+    uint32_t changed = (_level ^ previous) & ~_digitalActive;
+    uint32_t now = micros();
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+        if (changed & 1) _onEdge(i, _level & maskOf(i), now);
+    }
+    // Sensors that were not debouncing see the current level, as the interrupt path does
+    _state &= _level | _digitalActive | _debouncing;
+#endif
+
+    uint32_t pending = _debouncing & ~_digitalActive;
+    for (uint8_t i = 0; pending != 0; i++, pending >>= 1) {
+        if (pending & 1) _checkDebounce(i);
+    }
+}
+
+void SensorBank::_loadSaved() {
+    SavedSettings saved;
+    EEPROM.get(SAVED_ADDRESS, saved);
+    if (saved.version != SAVED_VERSION || saved.count != _count) return;
+    for (uint8_t i = 0; i < _count; i++) {
+        // Only keep saved settings for the same wiring
+        if (saved.sensors[i].inPin != _table[i].inPin || saved.sensors[i].outPin != _table[i].outPin) return;
+    }
+    for (uint8_t i = 0; i < _count; i++) _apply(i, saved.sensors[i]);
+}
+
+void SensorBank::_save() {
+    SavedSettings saved;
+    memset(&saved, 0, sizeof(saved));
+    saved.version = SAVED_VERSION;
+    saved.count = _count;
+    for (uint8_t i = 0; i < _count; i++) saved.sensors[i] = settings(i);
+    EEPROM.put(SAVED_ADDRESS, saved);
+}
+
+void SensorBank::_dump() {
+    for (uint8_t i = 0; i < _count; i++) {
+        uint16_t values[PARAM_COUNT] = {_note[i], _velocity[i], _channelAnalog[i], _channelDigital[i],
+                                        _durationMs[i], _debounceMs[i]};
+        uint8_t reply[6 + PARAM_COUNT * 2 + 1];
+        int n = 0;
+        reply[n++] = 0xF0;
+        reply[n++] = SYSEX_MANUFACTURER;
+        reply[n++] = SYSEX_DEVICE;
+        reply[n++] = SYSEX_DUMP_REPLY;
+        reply[n++] = i;
+        for (uint8_t p = 0; p < PARAM_COUNT; p++) {
+            reply[n++] = (values[p] >> 7) & 0x7F;
+            reply[n++] = values[p] & 0x7F;
+        }
+        reply[n++] = 0xF7;
+        usbMIDI.sendSysEx(n, reply, true);
+    }
+    usbMIDI.send_now();
+}
+
+/**
+ * Changing what a sensor sends while its notes sound would leave them hanging, so the sensor
+ * is silenced with its old settings first and its analog note restarted with the new ones.
+ */
+void SensorBank::_setParam(uint8_t i, uint8_t param, uint16_t value) {
+    bool midiParam = param <= 3;
+    if (midiParam) {
+        if (param == 0 || param == 1) value = min(value, (uint16_t)127);
+        if (param == 2 || param == 3) value = constrain(value, (uint16_t)1, (uint16_t)16);
+        stopDigital(i);
+        stopAnalog(i);
+    }
+    switch (param) {
+        case 0: _note[i] = value; break;
+        case 1: _velocity[i] = value; break;
+        case 2: _channelAnalog[i] = value; break;
+        case 3: _channelDigital[i] = value; break;
+        case 4: _durationMs[i] = value; break;
+        case 5: _debounceMs[i] = value; break;
+    }
+    if (midiParam) playAnalog(i);
+}
+
+void SensorBank::handleSysEx(const uint8_t *data, unsigned length) {
+    if (length < 5 || data[0] != 0xF0 || data[1] != SYSEX_MANUFACTURER || data[2] != SYSEX_DEVICE) return;
+    switch (data[3]) {
+        case SYSEX_SET:
+            if (length >= 9 && data[4] < _count && data[5] < PARAM_COUNT) {
+                _setParam(data[4], data[5], ((uint16_t)(data[6] & 0x7F) << 7) | (data[7] & 0x7F));
+            }
+            break;
+        case SYSEX_SAVE:
+            _save();
+            break;
+        case SYSEX_DEFAULTS:
+            for (uint8_t i = 0; i < _count; i++) {
+                const SensorSettings &s = _table[i];
+                uint16_t values[PARAM_COUNT] = {s.note, s.velocity, s.channelAnalog, s.channelDigital,
+                                                s.durationMs, s.debounceMs};
+                for (uint8_t p = 0; p < PARAM_COUNT; p++) _setParam(i, p, values[p]);
+            }
+            EEPROM.write(SAVED_ADDRESS, 0xFF);  // Forget the saved copy
+            break;
+        case SYSEX_DUMP:
+            _dump();
+            break;
+    }
+}
+
+/**
+ * Prints trigger latency (average and worst case since boot) and edge queue drops.
+ */
+void SensorBank::printStats() {
+    Serial.printf("sensors: %u %s, %lu triggers, latency avg %lu us max %lu us", _count,
+                  SENSOR_INTERRUPTS ? "interrupt-driven" : "polled", (unsigned long)latencyCount,
+                  latencyCount ? (unsigned long)(latencyTotal / latencyCount) : 0UL,
+                  (unsigned long)latencyMax);
+#if SENSOR_INTERRUPTS
+    Serial.printf(", %lu edges dropped", (unsigned long)edges.dropped());
+#endif
+    Serial.println();
+}
@@ -0,0 +1,219 @@
+#ifndef SENSOR_BANK_H
+#define SENSOR_BANK_H
+
+#include <Arduino.h>
+
+/**
+ * SENSOR_INTERRUPTS - 1 = each sensor's input pin raises an interrupt on every change,
+ * which timestamps the edge into an EdgeQueue; loop() only drains the queue and runs the
+ * debounce and note timers, and may sleep in between. 0 = poll every pin each loop iteration
+ * (one read per GPIO port on Teensy 4.x).
+ */
+#ifndef SENSOR_INTERRUPTS
+#define SENSOR_INTERRUPTS 1
+#endif
+
+/**
+ * SensorSettings - One sensor's wiring and MIDI behavior; a row of the sketch's sensor table.
+ *
+ * Everything except the pins can also be changed over SysEx (see SensorBank::handleSysEx()).
+ */
+struct SensorSettings {
+    uint8_t inPin;              // Digital input pin (sensor trigger)
+    uint8_t outPin;             // Digital output pin (drives LED display)
+    uint8_t channelAnalog;      // MIDI channel for the sustained analog note
+    uint8_t channelDigital;     // MIDI channel for the triggered digital note
+    uint8_t note;
+    uint8_t velocity;
+    uint16_t durationMs;        // How long the digital note plays before analog resumes
+    uint16_t debounceMs;        // How long input must stay HIGH before triggering
+};
+
+/**
+ * SensorBank - All sensors, each reading a digital input and outputting USB MIDI in two
+ * modes: analog and digital.
+ *
+ * After begin(), every sensor immediately plays a sustained note on its analog MIDI channel.
+ * When an input pin transitions LOW-to-HIGH and stays HIGH for the debounce time (trigger),
+ * that sensor's analog note stops and a digital note begins on its digital MIDI channel.
+ * After the note duration elapses, the digital note stops and the analog note resumes.
+ *
+ * CC messages are sent on channel 16 for QLC+ lighting control; the CC pair is derived from
+ * the analog channel (on = channel * 2, off = channel * 2 + 1). All messages go through
+ * midiOut (MidiQueue.h) and leave when the loop flushes it.
+ *
+ * State is kept as a struct of arrays: settings and timers in per-field arrays, and every
+ * per-sensor flag as one bit of a 32-bit mask, so a pass over 32 sensors touches a few
+ * cache lines and the flags of all sensors can be tested at once.
+ *
+ * Trigger latency (time from the debounce period being satisfied to the MIDI note going out)
+ * is measured across all sensors; see printStats().
+ */
+class SensorBank {
+public:
+    static const uint8_t MAX_SENSORS = 32;
+
+    SensorBank();
+
+    /**
+     * Takes the sensor table, applies any settings saved over SysEx, configures the pins,
+     * attaches the pin interrupts and starts every analog note. Call once from setup().
+     *
+     * @param table  One row per sensor; must outlive the bank
+     * @param count  Rows in table (at most MAX_SENSORS; extra rows are ignored)
+     * @return       false if count exceeded MAX_SENSORS
+     */
+    bool begin(const SensorSettings *table, uint8_t count);
+
+    /** Number of sensors in use. */
+    uint8_t count() const { return _count; }
+
+    /** Sensors whose digital note is playing, bit i = sensor i. */
+    uint32_t digitalMask() const { return _digitalActive; }
+
+    /** Sensors whose analog note is sustaining, bit i = sensor i. */
+    uint32_t analogMask() const { return _analogActive; }
+
+    /** Sensor i's current settings (the table row, or what SysEx or EEPROM changed). */
+    SensorSettings settings(uint8_t i) const;
+
+    /**
+     * Makes the sensors in mask read their input from simulateInput() instead of their pins,
+     * for the soak test (Soak.h). Real changes on those pins are ignored meanwhile. Handing a
+     * sensor back applies its real pin level as a fresh change. The simulated input starts LOW.
+     */
+    void simulate(uint32_t mask);
+
+    /** Sets simulated sensor i's input, as an edge at micros() now. Ignored if i is not simulated. */
+    void simulateInput(uint8_t i, bool high);
+
+    /** Hands every queued pin edge to its sensor. Call once per loop iteration before check(). */
+    void processEdges();
+
+    /** True if pin edges are waiting for processEdges(). */
+    bool edgesPending() const;
+
+    /** Polls the sensors (when not interrupt-driven) and runs the debounce and note timers. */
+    void check();
+
+    /** Sends note-on on sensor i's analog channel. */
+    void playAnalog(uint8_t i);
+
+    /** Sends note-off on sensor i's analog channel. */
+    void stopAnalog(uint8_t i);
+
+    /**
+     * Stops sensor i's analog note, sends note-on on its digital channel, drives its output pin
+     * HIGH and tells the display over triggerLink.
+     */
+    void playDigital(uint8_t i);
+
+    /** Sends note-off on sensor i's digital channel, drives its output pin LOW, and resumes analog. */
+    void stopDigital(uint8_t i);
+
+    /**
+     * Applies one SysEx message (the whole F0 ... F7 array as usbMIDI delivers it). Messages
+     * not addressed to this sketch are ignored. Format, with manufacturer ID 0x7D
+     * (non-commercial) and 14-bit values sent as two 7-bit bytes, high first:
+     *   F0 7D 41 01 <sensor> <param> <hi> <lo> F7   set a setting (not yet saved)
+     *   F0 7D 41 02 F7                              save settings to EEPROM
+     *   F0 7D 41 03 F7                              restore the sketch's table (and forget saved)
+     *   F0 7D 41 04 F7                              dump: one reply per sensor,
+     *                                               F0 7D 41 05 <sensor> <hi lo per param> F7
+     * Params: 0 note, 1 velocity, 2 analog channel, 3 digital channel, 4 duration ms,
+     * 5 debounce ms. A sensor whose notes change is stopped and restarted so no note hangs.
+     */
+    void handleSysEx(const uint8_t *data, unsigned length);
+
+    /** Prints trigger latency and edge queue statistics over Serial. */
+    void printStats();
+
+    /** Edge-to-MIDI timing of the triggers since the last takeTiming(). */
+    struct TriggerTiming {
+        uint32_t count;
+        uint32_t totalMicros;       // Sum of input edge -> note queued for the same pass's flush
+        uint32_t maxMicros;
+    };
+
+    /** Returns and clears the trigger timing gathered since the last call (for telemetry). */
+    TriggerTiming takeTiming();
+
+    /** Triggers sensor i has fired since boot. */
+    uint32_t triggerCount(uint8_t i) const { return _triggers[i]; }
+
+    /** Rising edges of sensor i that fell before the debounce time, since boot. */
+    uint32_t rejectCount(uint8_t i) const { return _rejects[i]; }
+
+    /** Pin edges lost because the edge queue was full (0 when polling). */
+    uint32_t edgesDropped() const;
+
+private:
+    uint8_t _count;
+    const SensorSettings *_table;
+
+    // Settings, one entry per sensor
+    uint8_t _inPin[MAX_SENSORS];
+    uint8_t _outPin[MAX_SENSORS];
+    uint8_t _channelAnalog[MAX_SENSORS];
+    uint8_t _channelDigital[MAX_SENSORS];
+    uint8_t _note[MAX_SENSORS];
+    uint8_t _velocity[MAX_SENSORS];
+    uint16_t _durationMs[MAX_SENSORS];
+    uint16_t _debounceMs[MAX_SENSORS];
+
+    // Where each input pin lives for port-wide reads
+    uint8_t _port[MAX_SENSORS];         // Index into _portRegs
+    uint32_t _mask[MAX_SENSORS];        // Pin's bit in its port register
+    volatile uint32_t *_portRegs[MAX_SENSORS];
+    uint8_t _portCount;
+
+    // Timers
+    uint32_t _noteStartMs[MAX_SENSORS];     // millis() when the digital note started
+    uint32_t _debounceStart[MAX_SENSORS];   // micros() of the rising edge being debounced
+
+    // Counters since boot
+    uint32_t _triggers[MAX_SENSORS];
+    uint32_t _rejects[MAX_SENSORS];
+    TriggerTiming _timing;
+
+    // Flags, bit i = sensor i
+    uint32_t _state;            // Last confirmed pin state for edge detection
+    uint32_t _level;            // Latest pin level seen (edge or poll)
+    uint32_t _debouncing;       // Waiting for debounce period to confirm
+    uint32_t _analogActive;     // Analog note sustaining
+    uint32_t _digitalActive;    // Digital note playing
+    uint32_t _simulated;        // Input comes from simulateInput(), not the pin
+    uint32_t _simulatedLevel;   // Simulated input levels
+
+    /** Copies settings row s into sensor i's arrays. */
+    void _apply(uint8_t i, const SensorSettings &s);
+
+    /** Finds or adds the port register of sensor i's input pin. */
+    void _mapPin(uint8_t i);
+
+    /** Reads every sensor's input into _level, one register read per port where possible. */
+    void _pollPins();
+
+    /** Applies one pin change of sensor i, observed at micros() time when. */
+    void _onEdge(uint8_t i, bool high, uint32_t when);
+
+    /** Fires sensor i's digital note once its input has stayed HIGH for the debounce time. */
+    void _checkDebounce(uint8_t i);
+
+    /** Loads settings saved over SysEx, if they match this table. */
+    void _loadSaved();
+
+    /** Writes the current settings to EEPROM. */
+    void _save();
+
+    /** Sends the dump reply for every sensor. */
+    void _dump();
+
+    /** Changes one SysEx parameter of sensor i. */
+    void _setParam(uint8_t i, uint8_t param, uint16_t value);
+};
+
+/** The sketch's sensors. */
+extern SensorBank sensors;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SENSOR_TABLE_H
+#define SENSOR_TABLE_H
+
+// Generated by tools/sensorgen.py from tools/sensors.csv. Edit the CSV and rerun the script,
+// so the QLC+ workspace keeps listening for the same CCs.
+
+#include "SensorBank.h"
+
+// One row per sensor: {inPin, outPin, midiChannelAnalog, midiChannelDigital, note, velocity,
+// durationMs, debounceMs}. The bank sizes itself from this table (up to SensorBank::MAX_SENSORS).
+// Note, velocity, channels and timings can be changed at runtime over SysEx (see SensorBank.h),
+// but QLC+ only follows the CCs of the channels listed here.
+const SensorSettings sensorTable[] = {
+  {0, 33, 1,  2, 60, 100, 5000, 250},  // Row 1: CC 2 on / 3 off
+  {1, 34, 3,  4, 60, 100, 5000, 250},  // Row 2: CC 6 on / 7 off
+  {2, 35, 5,  6, 60, 100, 5000, 250},  // Row 3: CC 10 on / 11 off
+  {3, 36, 7,  8, 60, 100, 5000, 250},  // Row 4: CC 14 on / 15 off
+  {4, 37, 9, 10, 60, 100, 5000, 250},  // Row 5: CC 18 on / 19 off
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "Soak.h"
+#include "MidiQueue.h"
+#include "SensorBank.h"
+#include <string.h>
+
+Soak soak;
+
+static const char *const PATTERN_NAMES[] = {"trigger", "burst", "chatter", "retrigger"};
+
+/** Sensor i's bit in the masks. */
+static inline uint32_t maskOf(uint8_t i) { return 1UL << i; }
+
+Soak::Soak() {
+    _running = false;
+    _rate = DEFAULT_RATE;
+}
+
+void Soak::toggle() {
+    if (_running) _stop();
+    else _start();
+}
+
+void Soak::setRate(uint16_t rate) {
+    _rate = constrain(rate, (uint16_t)1, MAX_RATE);
+    Serial.printf("soak: %u patterns/s\n", _rate);
+}
+
+void Soak::_start() {
+    uint8_t count = sensors.count();
+    _busy = 0;
+    _high = 0;
+    _lastDigital = sensors.digitalMask();
+    _stuck = 0;
+    _stuckIncidents = 0;
+    _skipped = 0;
+    _edges = 0;
+    _loops = 0;
+    _maxLoopMicros = 0;
+    memset(_patterns, 0, sizeof(_patterns));
+    uint32_t nowMs = millis();
+    for (uint8_t i = 0; i < count; i++) _digitalSinceMs[i] = nowMs;
+    _triggersAtStart = _bankTotal(false);
+    _rejectsAtStart = _bankTotal(true);
+    _midiAtStart = midiOut.sent();
+    _startMs = nowMs;
+    _nextPatternMicros = micros();
+    sensors.simulate(count >= 32 ? 0xFFFFFFFFUL : maskOf(count) - 1);
+    _loopStart = micros();
+    _running = true;
+    Serial.printf("soak: started, %u patterns/s over %u sensors ('s' stops)\n", _rate, count);
+}
+
+/** Hands the pins back; notes still playing end on their own timers. */
+void Soak::_stop() {
+    printStats();
+    for (uint8_t i = 0; i < sensors.count(); i++) sensors.simulateInput(i, false);
+    sensors.simulate(0);
+    _running = false;
+    Serial.println("soak: stopped");
+}
+
+void Soak::loopEnd() {
+    if (!_running) return;
+    uint32_t work = micros() - _loopStart;
+    if (work > _maxLoopMicros) _maxLoopMicros = work;
+    _loops++;
+}
+
+/**
+ * Picks a pattern, weighted towards single triggers. Gaps between patterns are uniform over
+ * 0 .. 2 / rate seconds, so the average is rate patterns per second.
+ */
+void Soak::_startPattern(uint32_t now) {
+    uint8_t count = sensors.count();
+    uint8_t idle[MAX_SENSORS];
+    uint8_t idleCount = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!(_busy & maskOf(i))) idle[idleCount++] = i;
+    }
+    if (idleCount == 0) {
+        _skipped++;
+        return;
+    }
+    long roll = random(100);
+    Pattern pattern = roll < 50 ? TRIGGER : roll < 65 ? BURST : roll < 85 ? CHATTER : RETRIGGER;
+    _patterns[pattern]++;
+
+    uint8_t i = idle[random(idleCount)];
+    uint16_t debounce = sensors.settings(i).debounceMs;
+    switch (pattern) {
+        case TRIGGER:
+            _press(i, 1, debounce + random(2 * debounce + 1), 0, now);
+            break;
+        case BURST: {
+            // Same press on every idle sensor, at this same instant
+            uint16_t hold = random(2 * debounce + 1);
+            for (uint8_t k = 0; k < idleCount; k++) {
+                uint8_t s = idle[k];
+                _press(s, 1, sensors.settings(s).debounceMs + hold, 0, now);
+            }
+            break;
+        }
+        case CHATTER:
+            _press(i, random(2, 6), random(1, debounce / 2 + 2), random(1, 30), now);
+            break;
+        case RETRIGGER:
+            _press(i, random(2, 5), debounce + random(20, 200), random(5, 60), now);
+            break;
+        default:
+            break;
+    }
+}
+
+void Soak::_press(uint8_t i, uint8_t presses, uint16_t highMs, uint16_t lowMs, uint32_t now) {
+    _busy |= maskOf(i);
+    _high |= maskOf(i);
+    _pressesLeft[i] = presses;
+    _highMs[i] = highMs;
+    _lowMs[i] = lowMs;
+    _changeMicros[i] = now + (uint32_t)highMs * 1000;
+    sensors.simulateInput(i, true);
+    _edges++;
+}
+
+void Soak::update() {
+    if (!_running) return;
+    uint32_t now = micros();
+    if ((int32_t)(now - _nextPatternMicros) >= 0) {
+        _startPattern(now);
+        _nextPatternMicros = now + random(2000000UL / _rate + 1);
+    }
+    uint32_t busy = _busy;
+    for (uint8_t i = 0; busy != 0; i++, busy >>= 1) {
+        if (!(busy & 1) || (int32_t)(now - _changeMicros[i]) < 0) continue;
+        uint32_t b = maskOf(i);
+        if (_high & b) {
+            // Release; the pattern ends with its last press
+            _high &= ~b;
+            sensors.simulateInput(i, false);
+            if (--_pressesLeft[i] == 0) _busy &= ~b;
+            else _changeMicros[i] = now + (uint32_t)_lowMs[i] * 1000;
+        } else {
+            _high |= b;
+            sensors.simulateInput(i, true);
+            _changeMicros[i] = now + (uint32_t)_highMs[i] * 1000;
+        }
+        _edges++;
+    }
+}
+
+/**
+ * The bank's state and the notes sent must agree after every flush. A sensor counts as one
+ * incident from the moment it goes stuck until it recovers.
+ */
+void Soak::check() {
+    if (!_running) return;
+    uint32_t nowMs = millis();
+    uint32_t digital = sensors.digitalMask();
+    uint32_t analog = sensors.analogMask();
+    uint32_t started = digital & ~_lastDigital;
+    _lastDigital = digital;
+    uint32_t stuck = 0;
+    for (uint8_t i = 0; i < sensors.count(); i++) {
+        uint32_t b = maskOf(i);
+        SensorSettings s = sensors.settings(i);
+        if (started & b) _digitalSinceMs[i] = nowMs;
+        bool expired = (digital & b) && nowMs - _digitalSinceMs[i] > (uint32_t)s.durationMs + STUCK_SLACK_MS;
+        if (expired || midiOut.sounding(s.note, s.channelDigital) != ((digital & b) != 0) ||
+            midiOut.sounding(s.note, s.channelAnalog) != ((analog & b) != 0)) {
+            stuck |= b;
+        }
+    }
+    uint32_t fresh = stuck & ~_stuck;
+    for (; fresh != 0; fresh &= fresh - 1) _stuckIncidents++;
+    _stuck = stuck;
+}
+
+uint32_t Soak::_bankTotal(bool rejects) const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < sensors.count(); i++) {
+        total += rejects ? sensors.rejectCount(i) : sensors.triggerCount(i);
+    }
+    return total;
+}
+
+void Soak::printStats() {
+    if (!_running) return;
+    uint32_t ms = millis() - _startMs;
+    float seconds = ms > 0 ? ms / 1000.0f : 1.0f;
+    uint32_t patterns = 0;
+    for (uint8_t p = 0; p < PATTERN_COUNT; p++) patterns += _patterns[p];
+    uint32_t triggers = _bankTotal(false) - _triggersAtStart;
+    uint32_t rejects = _bankTotal(true) - _rejectsAtStart;
+    uint32_t midi = midiOut.sent() - _midiAtStart;
+    Serial.printf("soak: %lu s at %u patterns/s, %lu patterns (%.1f/s), %lu skipped (all busy)\n",
+                  (unsigned long)(ms / 1000), _rate, (unsigned long)patterns, patterns / seconds,
+                  (unsigned long)_skipped);
+    for (uint8_t p = 0; p < PATTERN_COUNT; p++) {
+        Serial.printf("  %-9s %lu\n", PATTERN_NAMES[p], (unsigned long)_patterns[p]);
+    }
+    Serial.printf("soak: %.1f edges/s, %.1f triggers/s, %lu rejected, %.1f MIDI messages/s\n",
+                  _edges / seconds, triggers / seconds, (unsigned long)rejects, midi / seconds);
+    Serial.printf("soak: %lu loops, worst loop %lu us, edges dropped %lu\n", (unsigned long)_loops,
+                  (unsigned long)_maxLoopMicros, (unsigned long)sensors.edgesDropped());
+    Serial.printf("soak: stuck notes %lu incidents, now 0x%08lX\n", (unsigned long)_stuckIncidents,
+                  (unsigned long)_stuck);
+}
@@ -0,0 +1,115 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <Arduino.h>
+
+/**
+ * Soak - Non-blocking stress test of the sensor firmware, for finding its limits before a busy
+ * night.
+ *
+ * While running, every sensor reads a simulated input (SensorBank::simulate()) and the soak
+ * drives it with randomized patterns, at an average of rate() patterns per second across the
+ * wall. Each pattern starts on a random idle sensor:
+ *   - trigger: one press held past the debounce time
+ *   - burst: a trigger on every idle sensor in the same microsecond
+ *   - chatter: 2-5 presses shorter than the debounce time (all must be rejected)
+ *   - retrigger: 2-4 valid presses in quick succession, mostly while the note still plays
+ * The simulated edges go through the same debounce, note timers and MIDI queue as real ones,
+ * and loop() keeps running normally, so the display link, telemetry and SysEx stay live.
+ *
+ * After each checkSensors() pass it checks for stuck notes: a sensor whose notes as sent over
+ * USB (MidiQueue::sounding()) disagree with its analog/digital state, or whose digital note
+ * has outlived its duration by more than STUCK_SLACK_MS. printStats() reports patterns, edges
+ * and triggers per second, MIDI throughput, the worst loop iteration (work only, not the
+ * sleep) and stuck-note incidents.
+ *
+ * Serial 's' starts or stops the soak (stopping prints the report); '+' and '-' double or
+ * halve the rate.
+ */
+class Soak {
+public:
+    static const uint16_t DEFAULT_RATE = 4;     // Patterns per second
+    static const uint16_t MAX_RATE = 256;
+    static const uint16_t STUCK_SLACK_MS = 50;
+
+    Soak();
+
+    /** Starts the soak at the current rate, or stops it and prints the report. */
+    void toggle();
+
+    /** True while soaking. */
+    bool running() const { return _running; }
+
+    /** Patterns per second. */
+    uint16_t rate() const { return _rate; }
+
+    /** Sets the patterns per second (1 - MAX_RATE). */
+    void setRate(uint16_t rate);
+
+    /** Marks the start of a loop iteration's work. */
+    void loopBegin() { _loopStart = micros(); }
+
+    /** Marks the end of a loop iteration's work, before any sleep. */
+    void loopEnd();
+
+    /** Drives the simulated inputs. Call once per loop iteration, before checkSensors(). */
+    void update();
+
+    /** Checks for stuck notes. Call once per loop iteration, after checkSensors(). */
+    void check();
+
+    /** Prints the soak report over Serial (nothing when not running). */
+    void printStats();
+
+private:
+    static const uint8_t MAX_SENSORS = 32;      // SensorBank::MAX_SENSORS
+
+    enum Pattern : uint8_t { TRIGGER, BURST, CHATTER, RETRIGGER, PATTERN_COUNT };
+
+    bool _running;
+    uint16_t _rate;
+    uint32_t _nextPatternMicros;
+
+    // Simulated presses, one entry per sensor
+    uint32_t _changeMicros[MAX_SENSORS];    // When the input next changes
+    uint16_t _highMs[MAX_SENSORS];          // Press length
+    uint16_t _lowMs[MAX_SENSORS];           // Gap between presses
+    uint8_t _pressesLeft[MAX_SENSORS];      // Including the one in progress
+    uint32_t _busy;                         // Bit i = sensor i is playing a pattern
+    uint32_t _high;                         // Bit i = sensor i's input is HIGH
+
+    // Stuck-note detection
+    uint32_t _digitalSinceMs[MAX_SENSORS];  // millis() when the digital note was first seen
+    uint32_t _lastDigital;
+    uint32_t _stuck;                        // Sensors currently stuck
+    uint32_t _stuckIncidents;
+
+    // Report
+    uint32_t _startMs;
+    uint32_t _patterns[PATTERN_COUNT];
+    uint32_t _skipped;                      // Patterns due while every sensor was busy
+    uint32_t _edges;
+    uint32_t _loops;
+    uint32_t _loopStart;
+    uint32_t _maxLoopMicros;
+    uint32_t _triggersAtStart;
+    uint32_t _rejectsAtStart;
+    uint32_t _midiAtStart;
+
+    void _start();
+    void _stop();
+
+    /** Starts a random pattern, if any sensor is idle. */
+    void _startPattern(uint32_t now);
+
+    /** Starts presses on sensor i: the first goes HIGH now. */
+    void _press(uint8_t i, uint8_t presses, uint16_t highMs, uint16_t lowMs, uint32_t now);
+
+    /** Sum of every sensor's triggers (rejects = false) or debounce rejections since boot. */
+    uint32_t _bankTotal(bool rejects) const;
+};
+
+/** The sketch's soak test. */
+extern Soak soak;
+
+#endif
@@ -0,0 +1,71 @@
+#include "Telemetry.h"
+#include "SensorBank.h"
+
+Telemetry telemetry;
+
+Telemetry::Telemetry() {
+    _subscribed = false;
+    _intervalStartMs = 0;
+    _loops = 0;
+    _sequence = 0;
+    _drops = 0;
+    _length = 0;
+}
+
+void Telemetry::toggle() {
+    _subscribed = !_subscribed;
+    _intervalStartMs = millis();
+    _loops = 0;
+    sensors.takeTiming();   // Start the first interval clean
+}
+
+void Telemetry::_encode(uint32_t nowMs) {
+    SensorBank::TriggerTiming timing = sensors.takeTiming();
+    _length = 0;
+    _put8(SYNC_0);
+    _put8(SYNC_1);
+    _put8(SOURCE);
+    _put8(VERSION);
+    _put16(0);   // Payload length, patched below
+
+    _put16(_sequence++);
+    _put32(nowMs);
+    _put16(nowMs - _intervalStartMs);
+    _put32(_loops);
+    _put16(timing.count > 0xFFFF ? 0xFFFF : timing.count);
+    _put32(timing.count ? timing.totalMicros / timing.count : 0);
+    _put32(timing.maxMicros);
+    _put32(sensors.edgesDropped());
+    _put16(_drops);
+    _put8(sensors.count());
+    for (uint8_t i = 0; i < sensors.count(); i++) {
+        _put32(sensors.triggerCount(i));
+        _put32(sensors.rejectCount(i));
+    }
+
+    uint16_t payload = _length - HEADER_BYTES;
+    _packet[4] = payload;
+    _packet[5] = payload >> 8;
+    uint8_t check = 0;
+    for (uint16_t i = 2; i < _length; i++) check ^= _packet[i];
+    _put8(check);
+}
+
+void Telemetry::update() {
+    if (!_subscribed) return;
+    if (!Serial) {
+        _subscribed = false;    // Port closed: stop until the next 't'
+        return;
+    }
+    uint32_t nowMs = millis();
+    if (nowMs - _intervalStartMs < INTERVAL_MS) return;
+
+    _encode(nowMs);
+    if (Serial.availableForWrite() >= _length) {
+        Serial.write(_packet, _length);
+    } else {
+        _drops++;
+    }
+    _intervalStartMs = nowMs;
+    _loops = 0;
+}
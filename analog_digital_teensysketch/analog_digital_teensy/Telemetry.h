@@ -0,0 +1,72 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+/**
+ * Telemetry - Compact binary runtime stats over the USB serial port, for unattended installs.
+ *
+ * Send 't' over serial to toggle the stream. While subscribed, one packet per INTERVAL_MS
+ * reports loop rate, trigger timing and per-sensor counters. When nobody is subscribed, or
+ * the serial port is closed, the only cost is one counter increment per loop. A packet that
+ * would not fit in the serial transmit buffer is dropped and counted, never waited for.
+ *
+ * Packet, all fields little-endian (the same framing as the display's telemetry.h):
+ *   A5 5A  sync
+ *   u8     source: SOURCE ('T')
+ *   u8     version: VERSION
+ *   u16    payload length
+ *   ...    payload
+ *   u8     XOR of every byte from source to the end of the payload
+ * Teensy payload (version 1):
+ *   u16 sequence    u32 uptime ms    u16 interval ms    u32 loop iterations
+ *   u16 triggers    u32 edge-to-MIDI avg us    u32 edge-to-MIDI max us
+ *   u32 edges dropped since boot    u16 packets dropped    u8 sensor count
+ *   per sensor: u32 triggers since boot, u32 debounce rejections since boot
+ * Edge-to-MIDI runs from the input edge (interrupt timestamp, or the poll that saw it) to the
+ * note being queued for that pass's flush, so it includes the debounce time.
+ */
+class Telemetry {
+public:
+    static const uint8_t SOURCE = 'T';
+    static const uint8_t VERSION = 1;
+    static const uint32_t INTERVAL_MS = 1000;
+
+    Telemetry();
+
+    /** Toggles the subscription (the 't' command). */
+    void toggle();
+
+    /** Counts one loop iteration. */
+    void loopTick() { _loops++; }
+
+    /** Sends the interval's packet when one is due. Call once per loop iteration. */
+    void update();
+
+private:
+    static const uint8_t SYNC_0 = 0xA5;
+    static const uint8_t SYNC_1 = 0x5A;
+    static const uint8_t HEADER_BYTES = 6;
+    static const uint16_t MAX_PACKET_BYTES = 300;
+
+    bool _subscribed;
+    uint32_t _intervalStartMs;
+    uint32_t _loops;
+    uint16_t _sequence;
+    uint16_t _drops;
+
+    uint8_t _packet[MAX_PACKET_BYTES];
+    uint16_t _length;
+
+    void _put8(uint8_t v) { _packet[_length++] = v; }
+    void _put16(uint16_t v) { _put8(v); _put8(v >> 8); }
+    void _put32(uint32_t v) { _put16(v); _put16(v >> 16); }
+
+    /** Encodes the packet for the interval ending at nowMs into _packet. */
+    void _encode(uint32_t nowMs);
+};
+
+/** The sketch's telemetry stream. */
+extern Telemetry telemetry;
+
+#endif
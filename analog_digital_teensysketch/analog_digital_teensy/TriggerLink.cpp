@@ -0,0 +1,47 @@
+#include "TriggerLink.h"
+
+TriggerLink triggerLink;
+
+TriggerLink::TriggerLink() {
+    _started = false;
+    _lastSentMs = 0;
+    _triggers = 0;
+    _states = 0;
+}
+
+void TriggerLink::begin() {
+    TRIGGER_LINK_SERIAL.begin(BAUD);
+    _started = true;
+}
+
+void TriggerLink::_send(uint8_t type, uint8_t sensor, uint32_t digitalMask, uint8_t count) {
+    if (!_started) return;
+    uint8_t frame[FRAME_BYTES] = {
+        SYNC, type, sensor, count,
+        (uint8_t)digitalMask, (uint8_t)(digitalMask >> 8),
+        (uint8_t)(digitalMask >> 16), (uint8_t)(digitalMask >> 24), 0
+    };
+    for (uint8_t i = 1; i < FRAME_BYTES - 1; i++) frame[FRAME_BYTES - 1] ^= frame[i];
+    // Fits the UART transmit buffer, so this returns without waiting for the wire
+    TRIGGER_LINK_SERIAL.write(frame, FRAME_BYTES);
+    _lastSentMs = millis();
+}
+
+void TriggerLink::trigger(uint8_t sensor, uint32_t digitalMask, uint8_t count) {
+    _send(TRIGGER, sensor, digitalMask, count);
+    _triggers++;
+}
+
+void TriggerLink::state(uint32_t digitalMask, uint8_t count) {
+    _send(STATE, 0, digitalMask, count);
+    _states++;
+}
+
+void TriggerLink::heartbeat(uint32_t digitalMask, uint8_t count) {
+    if (millis() - _lastSentMs >= HEARTBEAT_MS) state(digitalMask, count);
+}
+
+void TriggerLink::printStats() {
+    Serial.printf("link: %lu trigger and %lu state frames sent\n",
+                  (unsigned long)_triggers, (unsigned long)_states);
+}
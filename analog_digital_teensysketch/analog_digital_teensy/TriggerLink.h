@@ -0,0 +1,69 @@
+#ifndef TRIGGER_LINK_H
+#define TRIGGER_LINK_H
+
+#include <Arduino.h>
+
+/**
+ * TRIGGER_LINK_SERIAL - UART wired to the MatrixPortal's RX pin. Serial2 (TX2 = pin 8) because
+ * Serial1 shares pins 0 and 1 with the first sensors.
+ */
+#ifndef TRIGGER_LINK_SERIAL
+#define TRIGGER_LINK_SERIAL Serial2
+#endif
+
+/**
+ * TriggerLink - Tells the MatrixPortal display which sensor fired, the moment it fires.
+ *
+ * Each output pin can only say "some sensor is digital", and the display samples it once per
+ * frame. This link sends a 9-byte UART frame instead (1 Mbaud, under 100 us on the wire) that
+ * names the sensor, so the display can open an eye at that sensor's place on its next frame:
+ *   0     SYNC (0xA5)
+ *   1     type: STATE (0) or TRIGGER (1)
+ *   2     sensor that fired (TRIGGER frames; 0 in STATE frames)
+ *   3     number of sensors
+ *   4-7   mask of sensors in digital mode, least significant byte first
+ *   8     XOR of bytes 1-7
+ * A TRIGGER frame goes out from playDigital(), a STATE frame when a digital note ends and
+ * every HEARTBEAT_MS, so the display notices a lost frame or a missing Teensy. The layout must
+ * match triggerlink.h in the display sketch. The output pins keep working alongside.
+ */
+class TriggerLink {
+public:
+    static const uint32_t BAUD = 1000000;
+    static const uint8_t SYNC = 0xA5;
+    static const uint8_t STATE = 0;
+    static const uint8_t TRIGGER = 1;
+    static const uint8_t FRAME_BYTES = 9;
+    static const uint32_t HEARTBEAT_MS = 100;
+
+    TriggerLink();
+
+    /** Opens the UART. Call once from setup() before the sensors start. */
+    void begin();
+
+    /** Sends a TRIGGER frame for sensor. */
+    void trigger(uint8_t sensor, uint32_t digitalMask, uint8_t count);
+
+    /** Sends a STATE frame now. */
+    void state(uint32_t digitalMask, uint8_t count);
+
+    /** Sends a STATE frame if none went out for HEARTBEAT_MS. Call once per loop iteration. */
+    void heartbeat(uint32_t digitalMask, uint8_t count);
+
+    /** Prints frame counts over Serial. */
+    void printStats();
+
+private:
+    bool _started;
+    uint32_t _lastSentMs;
+    uint32_t _triggers;         // TRIGGER frames sent
+    uint32_t _states;           // STATE frames sent
+
+    /** Builds and writes one frame. */
+    void _send(uint8_t type, uint8_t sensor, uint32_t digitalMask, uint8_t count);
+};
+
+/** The link to the display; fed by the sensor bank. */
+extern TriggerLink triggerLink;
+
+#endif
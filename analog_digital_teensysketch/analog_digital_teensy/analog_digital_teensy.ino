@@ -1,58 +1,102 @@
-#include "Sensor.h"
-
-// Array size and sensorCount must match to avoid out-of-bounds access.
-// Each Sensor is constructed as: Sensor(inPin, outPin, midiChannelAnalog, midiChannelDigital)
-// Channels are assigned in pairs: sensor 1 = ch 1/2, sensor 2 = ch 3/4, etc.
-int sensorCount = 5;
-
-Sensor sensors[5] = {
-  Sensor(0, 33, 1,  2),
-  Sensor(1, 34, 3,  4),
-  Sensor(2, 35, 5,  6),
-  Sensor(3, 36, 7,  8),
-  Sensor(4, 37, 9, 10),
-};
-
-class Sensor;
+#include "MidiQueue.h"
+#include "SensorBank.h"
+#include "SensorTable.h"
+#include "Soak.h"
+#include "Telemetry.h"
+#include "TriggerLink.h"
+
+// sensorTable[] (SensorTable.h) is generated from tools/sensors.csv by tools/sensorgen.py,
+// along with the QLC+ bindings for its CCs.
+const uint8_t sensorCount = sizeof(sensorTable) / sizeof(sensorTable[0]);
+
 void setupSensors();
 void checkSensors();
-void test();
+void handleSerial();
+void handleMidiInput();
 
 void setup() {
   Serial.begin(115200);
+  triggerLink.begin();
   setupSensors();
 }
 
 void loop() {
+  soak.loopBegin();
+  handleSerial();
+  handleMidiInput();
+  soak.update();
   checkSensors();
-  // test();
+  soak.check();
+  triggerLink.heartbeat(sensors.digitalMask(), sensors.count());
+  telemetry.loopTick();
+  telemetry.update();
+  soak.loopEnd();
+
+#if SENSOR_INTERRUPTS
+  // Nothing left to do until the next pin edge, USB activity or the 1 ms system tick.
+  // Check with interrupts masked, so an edge landing after the check can't be slept
+  // through: a pending interrupt still ends wfi while PRIMASK is set, and runs once
+  // interrupts are enabled again.
+  __disable_irq();
+  if (!sensors.edgesPending()) asm volatile("wfi");
+  __enable_irq();
+#endif
 }
 
-/** Initializes all sensor pin modes and starts their analog notes. */
-void setupSensors() {
-  for (int i = 0; i < sensorCount; i++) {
-    sensors[i].init();
+/**
+ * Serial console: 'p' prints trigger latency, edge queue, MIDI queue and trigger link statistics
+ * (and the soak report while soaking); 't' toggles the binary telemetry stream (see Telemetry.h);
+ * 's' starts or stops the soak test and '+'/'-' change its rate (see Soak.h).
+ */
+void handleSerial() {
+  while (Serial.available() > 0) {
+    switch (Serial.read()) {
+      case 'p':
+        sensors.printStats();
+        midiOut.printStats();
+        triggerLink.printStats();
+        soak.printStats();
+        break;
+      case 't':
+        telemetry.toggle();
+        break;
+      case 's':
+        soak.toggle();
+        break;
+      case '+':
+        soak.setRate(soak.rate() * 2);
+        break;
+      case '-':
+        soak.setRate(soak.rate() / 2);
+        break;
+    }
   }
 }
 
-/** Polls all sensors and manages their note timers. */
-void checkSensors() {
-  for (int i = 0; i < sensorCount; i++) {
-    sensors[i].check();
+/** Passes incoming SysEx to the sensor bank for runtime configuration. */
+void handleMidiInput() {
+  while (usbMIDI.read()) {
+    if (usbMIDI.getType() == usbMIDI.SystemExclusive) {
+      sensors.handleSysEx(usbMIDI.getSysExArray(), usbMIDI.getSysExArrayLength());
+    }
   }
+  midiOut.flush();
 }
 
-/** Debug helper: fires all sensors into digital mode, waits for them to auto-off, then pauses. */
-void test() {
-  // delay(6000);
-  for (int i = 0; i < sensorCount; i++) {
-    sensors[i].playDigital();
-    delay(6000);
-    sensors[i].check();
-    delay(6000);
+/** Initializes all sensor pin modes and starts their analog notes. */
+void setupSensors() {
+  if (!sensors.begin(sensorTable, sensorCount)) {
+    Serial.println("sensorTable has more rows than SensorBank::MAX_SENSORS; extra sensors ignored");
   }
-  // delay(6000);
-  // for (int i = 0; i < sensorCount; i++) {
-  //   sensors[i].check();
-  // }
+  midiOut.flush();
+}
+
+/**
+ * Applies queued pin edges, polls all sensors and manages their note timers, then sends every
+ * MIDI message the pass produced in one USB transfer.
+ */
+void checkSensors() {
+  sensors.processEdges();
+  sensors.check();
+  midiOut.flush();
 }
@@ -0,0 +1,286 @@
+#!/usr/bin/env python3
+"""Measures how far QLC+ lighting lags sensor triggers, over a MIDI loopback.
+
+Plays the Teensy's part: for each trigger it sends, for every sensor in
+the burst, exactly what SensorBank::playDigital() sends (analog note off,
+digital note on, CC on on channel 16), back to back as one flush does. It
+then times how long QLC+ takes to change its DMX output, received as
+Art-Net. After a hold it sends what stopDigital() sends and waits for the
+output to settle before the next burst.
+
+Setup, with QLC+ on the same machine:
+  - MIDI: QLC+ listens on one side of a loopback port (the workspace uses
+    "Default App Loopback (B)"); this script sends on the other side.
+  - DMX: save a copy of the workspace with Universe 1's output set to the
+    Art-Net plugin on 127.0.0.1 and load that copy. The output is then the
+    same DMX the USB interface would have sent.
+
+A calibration pass first fires each sensor alone and records which DMX
+channels its cue changes. In a burst, a sensor's cue counts as shown on
+the first Art-Net frame in which one of its channels differs from the
+frame before the burst. Art-Net arrives once per QLC+ output tick (about
+20 ms), so results are quantized to that tick.
+
+--load adds background MIDI traffic (unbound CCs on channel 16) while
+measuring. Sensors come from tools/sensors.csv (see sensorgen.py).
+Needs mido with the python-rtmidi backend.
+"""
+
+import argparse
+import random
+import socket
+import sys
+import threading
+import time
+
+import sensorgen
+
+try:
+    import mido
+except ImportError:
+    sys.exit("cuelatency: needs mido and python-rtmidi (pip install mido python-rtmidi)")
+
+ARTNET_PORT = 6454
+ARTDMX_OPCODE = 0x5000
+LOAD_CC_FIRST = 100         # Background CCs use numbers no sensor is bound to
+
+
+def trigger_messages(sensor):
+    """What SensorBank::playDigital() sends for one sensor."""
+    note, velocity = sensor["note"], sensor["velocity"]
+    return [
+        mido.Message("note_off", note=note, velocity=velocity, channel=sensor["analogChannel"] - 1),
+        mido.Message("note_on", note=note, velocity=velocity, channel=sensor["digitalChannel"] - 1),
+        mido.Message("control_change", control=sensorgen.cc_on(sensor), value=1,
+                     channel=sensorgen.CC_CHANNEL - 1),
+    ]
+
+
+def stop_messages(sensor):
+    """What SensorBank::stopDigital() sends for one sensor."""
+    note, velocity = sensor["note"], sensor["velocity"]
+    return [
+        mido.Message("note_off", note=note, velocity=velocity, channel=sensor["digitalChannel"] - 1),
+        mido.Message("control_change", control=sensorgen.cc_off(sensor), value=1,
+                     channel=sensorgen.CC_CHANNEL - 1),
+        mido.Message("note_on", note=note, velocity=velocity, channel=sensor["analogChannel"] - 1),
+    ]
+
+
+class MidiOut:
+    """The loopback port, shared by the bursts and the background load."""
+
+    def __init__(self, name):
+        self._port = mido.open_output(name)
+        self._lock = threading.Lock()
+
+    def send(self, messages):
+        with self._lock:
+            for message in messages:
+                self._port.send(message)
+
+
+class ArtnetIn:
+    """Receives ArtDmx frames of one universe and keeps the latest."""
+
+    def __init__(self, bind, universe):
+        self._socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self._socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self._socket.bind((bind, ARTNET_PORT))
+        self._universe = universe
+        self.frame = None
+        self.frames = 0
+
+    def receive(self, deadline):
+        """Waits for the next frame until deadline (perf_counter). Returns its arrival time or None."""
+        while True:
+            remaining = deadline - time.perf_counter()
+            if remaining <= 0:
+                return None
+            self._socket.settimeout(remaining)
+            try:
+                packet = self._socket.recv(1024)
+            except socket.timeout:
+                return None
+            arrival = time.perf_counter()
+            if len(packet) < 18 or packet[:8] != b"Art-Net\0":
+                continue
+            if int.from_bytes(packet[8:10], "little") != ARTDMX_OPCODE:
+                continue
+            if int.from_bytes(packet[14:16], "little") != self._universe:
+                continue
+            length = int.from_bytes(packet[16:18], "big")
+            self.frame = packet[18:18 + length]
+            self.frames += 1
+            return arrival
+
+    def settle(self, quiet, timeout):
+        """Reads frames until the output has not changed for quiet seconds. Returns the frame."""
+        end = time.perf_counter() + timeout
+        last = self.frame
+        changed = time.perf_counter()
+        while True:
+            now = time.perf_counter()
+            if (last is not None and now - changed >= quiet) or now >= end:
+                break
+            self.receive(min(end, now + quiet))
+            if self.frame != last:
+                last = self.frame
+                changed = time.perf_counter()
+        if last is None:
+            sys.exit("cuelatency: no Art-Net frames for universe %d; is QLC+ outputting Art-Net here?"
+                     % self._universe)
+        return last
+
+
+def changed_channels(a, b):
+    return {i for i in range(max(len(a), len(b))) if (a[i] if i < len(a) else 0) != (b[i] if i < len(b) else 0)}
+
+
+def load_thread(midi, rate, stop):
+    """Sends rate background CCs per second until stop is set."""
+    interval = 1.0 / rate
+    value = 0
+    next_send = time.perf_counter()
+    while not stop.is_set():
+        value = (value + 1) & 0x7F
+        midi.send([mido.Message("control_change", control=LOAD_CC_FIRST + value % 20, value=value,
+                                channel=sensorgen.CC_CHANNEL - 1)])
+        next_send += interval
+        delay = next_send - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+
+
+def calibrate(sensors, midi, artnet, args):
+    """Fires each sensor alone and returns the DMX channels each cue changes."""
+    footprints = []
+    for sensor in sensors:
+        before = artnet.settle(args.settle, args.timeout)
+        midi.send(trigger_messages(sensor))
+        after = artnet.settle(args.settle, args.timeout)
+        midi.send(stop_messages(sensor))
+        channels = changed_channels(before, after)
+        if not channels:
+            sys.exit('cuelatency: "%s" (CC %d) changed no DMX channel; check the bindings (sensorgen.py)'
+                     % (sensor["name"], sensorgen.cc_on(sensor)))
+        footprints.append(channels)
+    # Attribute a cue only by the channels no other sensor's cue touches, if it has some
+    own = []
+    for i, channels in enumerate(footprints):
+        others = set().union(*(f for j, f in enumerate(footprints) if j != i))
+        exclusive = channels - others
+        if not exclusive:
+            print('warning: every channel of "%s" is shared with another cue' % sensors[i]["name"], file=sys.stderr)
+        own.append(exclusive or channels)
+    return own
+
+
+def run_burst(burst, footprints, sensors, midi, artnet, args):
+    """Fires the sensors in burst together. Returns their latencies in ms (None = not seen)."""
+    baseline = artnet.settle(args.settle, args.timeout)
+    messages = [m for i in burst for m in trigger_messages(sensors[i])]
+    start = time.perf_counter()
+    midi.send(messages)
+    latency = {i: None for i in burst}
+    deadline = start + args.timeout
+    while any(v is None for v in latency.values()):
+        arrival = artnet.receive(deadline)
+        if arrival is None:
+            break
+        frame = artnet.frame
+        for i in burst:
+            if latency[i] is None and any((frame[c] if c < len(frame) else 0) != baseline[c] for c in footprints[i]):
+                latency[i] = (arrival - start) * 1000.0
+    time.sleep(args.hold)
+    midi.send([m for i in burst for m in stop_messages(sensors[i])])
+    return latency
+
+
+def summary(values):
+    """min/avg/p50/p99/max in ms, the profiler's order."""
+    if not values:
+        return "no samples"
+    values = sorted(values)
+
+    def pick(q):
+        return values[min(len(values) - 1, int(q * len(values)))]
+    return "min %6.1f  avg %6.1f  p50 %6.1f  p99 %6.1f  max %6.1f ms" % (
+        values[0], sum(values) / len(values), pick(0.5), pick(0.99), values[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--list-ports", action="store_true", help="list MIDI output ports and exit")
+    parser.add_argument("--port", default="Default App Loopback (A)",
+                        help="MIDI output port to send on (a unique part of its name)")
+    parser.add_argument("--bind", default="0.0.0.0", help="address to receive Art-Net on")
+    parser.add_argument("--universe", type=int, default=0, help="Art-Net universe of QLC+ Universe 1")
+    parser.add_argument("--bursts", type=int, default=50, help="bursts to measure")
+    parser.add_argument("--size", type=int, default=0, help="sensors per burst (default: all)")
+    parser.add_argument("--load", type=float, default=0, help="background MIDI messages per second")
+    parser.add_argument("--hold", type=float, default=0.5, help="seconds a burst's cues stay on")
+    parser.add_argument("--settle", type=float, default=0.3, help="seconds without a DMX change that count as settled")
+    parser.add_argument("--timeout", type=float, default=3.0, help="seconds to wait for a cue")
+    parser.add_argument("--seed", type=int, default=1, help="seed for picking burst members")
+    args = parser.parse_args()
+
+    if args.list_ports:
+        for name in mido.get_output_names():
+            print(name)
+        return 0
+    matches = [n for n in mido.get_output_names() if args.port in n]
+    if len(matches) != 1:
+        sys.exit("cuelatency: %d MIDI outputs match %r; see --list-ports" % (len(matches), args.port))
+    try:
+        sensors = sensorgen.load_sensors()
+    except (OSError, ValueError) as error:
+        sys.exit("cuelatency: %s" % error)
+    size = args.size or len(sensors)
+    if not 1 <= size <= len(sensors):
+        sys.exit("cuelatency: --size must be 1-%d" % len(sensors))
+
+    midi = MidiOut(matches[0])
+    artnet = ArtnetIn(args.bind, args.universe)
+    print("%d sensors, MIDI out %s, Art-Net universe %d" % (len(sensors), matches[0], args.universe))
+    footprints = calibrate(sensors, midi, artnet, args)
+    for sensor, channels in zip(sensors, footprints):
+        print("  %-12s CC %3d  DMX %s" % (sensor["name"], sensorgen.cc_on(sensor),
+                                          ",".join(str(c + 1) for c in sorted(channels))))
+
+    stop = threading.Event()
+    if args.load > 0:
+        threading.Thread(target=load_thread, args=(midi, args.load, stop), daemon=True).start()
+    picker = random.Random(args.seed)
+    first, last, missed = [], [], 0
+    per_sensor = [[] for _ in sensors]
+    frames_before, started = artnet.frames, time.perf_counter()
+    try:
+        for _ in range(args.bursts):
+            burst = sorted(picker.sample(range(len(sensors)), size))
+            latency = run_burst(burst, footprints, sensors, midi, artnet, args)
+            seen = [v for v in latency.values() if v is not None]
+            missed += len(latency) - len(seen)
+            for i, v in latency.items():
+                if v is not None:
+                    per_sensor[i].append(v)
+            if seen:
+                first.append(min(seen))
+            if len(seen) == len(latency):
+                last.append(max(seen))
+    finally:
+        stop.set()
+    elapsed = time.perf_counter() - started
+
+    print("%d bursts of %d sensors, background load %g msg/s, Art-Net %.1f frames/s"
+          % (args.bursts, size, args.load, (artnet.frames - frames_before) / elapsed))
+    print("first cue  %s" % summary(first))
+    print("all cues   %s" % summary(last))
+    for sensor, values in zip(sensors, per_sensor):
+        print("  %-12s %s" % (sensor["name"], summary(values)))
+    print("cues not seen within %.1f s: %d" % (args.timeout, missed))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Generates the sensor wiring on both sides of the MIDI link from sensors.csv.
+
+The Teensy sends, per sensor, notes on the sensor's analog and digital
+channels and a CC pair on channel 16 (on = analogChannel * 2, off =
+analogChannel * 2 + 1, see SensorBank::playDigital()). QLC+ has to listen
+for exactly those CCs. This script writes, from tools/sensors.csv:
+
+  - the Teensy's sensorTable[] (SensorTable.h)
+  - a QLC+ input profile naming every sensor's CCs
+  - the CC bindings of each sensor's Analog and Digital buttons in the
+    workspace, found by the solo frame whose caption is the sensor's name
+
+Run it after editing the CSV, then rebuild the Teensy sketch and reload the
+workspace. --check only reports files that are out of date (exit status 1).
+Uses only the standard library.
+"""
+
+import argparse
+import csv
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SENSORS_CSV = os.path.join(ROOT, "tools", "sensors.csv")
+SENSOR_TABLE = os.path.join(ROOT, "analog_digital_teensysketch", "analog_digital_teensy", "SensorTable.h")
+WORKSPACE = os.path.join(ROOT, "analog_digital_qlc+", "analog_digital.qxw")
+PROFILE = os.path.join(ROOT, "analog_digital_qlc+", "Analog-Digital-Teensy-Sensors.qxi")
+
+CC_CHANNEL = 16             # MIDI_CC_CHANNEL in SensorBank.cpp
+MAX_SENSORS = 32            # SensorBank::MAX_SENSORS
+PROFILE_MANUFACTURER = "Analog Digital"
+PROFILE_MODEL = "Teensy Sensors"
+
+FIELDS = [
+    # name, min, max
+    ("inPin", 0, 255),
+    ("outPin", 0, 255),
+    ("analogChannel", 1, 16),
+    ("digitalChannel", 1, 16),
+    ("note", 0, 127),
+    ("velocity", 0, 127),
+    ("durationMs", 0, 65535),
+    ("debounceMs", 0, 65535),
+]
+
+
+def cc_on(sensor):
+    return sensor["analogChannel"] * 2
+
+
+def cc_off(sensor):
+    return sensor["analogChannel"] * 2 + 1
+
+
+def load_sensors(path=SENSORS_CSV):
+    """Reads and validates the sensor rows. Raises ValueError naming the bad row."""
+    with open(path, newline="") as f:
+        rows = [line for line in f if line.strip() and not line.lstrip().startswith("#")]
+    sensors = []
+    for number, row in enumerate(csv.DictReader(rows), start=1):
+        sensor = {"name": (row.get("name") or "").strip()}
+        if not sensor["name"]:
+            raise ValueError("sensor %d: missing name" % number)
+        for field, low, high in FIELDS:
+            text = (row.get(field) or "").strip()
+            if not text.isdigit() or not low <= int(text) <= high:
+                raise ValueError("sensor %d (%s): %s must be %d-%d, got %r"
+                                 % (number, sensor["name"], field, low, high, text))
+            sensor[field] = int(text)
+        sensors.append(sensor)
+    if not sensors:
+        raise ValueError("no sensors in %s" % path)
+    if len(sensors) > MAX_SENSORS:
+        raise ValueError("%d sensors, SensorBank holds %d" % (len(sensors), MAX_SENSORS))
+    for field in ("name", "inPin", "outPin", "analogChannel"):
+        values = [s[field] for s in sensors]
+        duplicates = sorted(set(v for v in values if values.count(v) > 1), key=str)
+        if duplicates:
+            # A shared analog channel would give two sensors the same CC pair
+            raise ValueError("%s used by more than one sensor: %s" % (field, ", ".join(map(str, duplicates))))
+    return sensors
+
+
+def sensor_table(sensors):
+    """The Teensy's SensorTable.h."""
+    columns = [[str(s[field]) for field, _, _ in FIELDS] for s in sensors]
+    widths = [max(len(c[i]) for c in columns) for i in range(len(FIELDS))]
+    lines = [
+        "#ifndef SENSOR_TABLE_H",
+        "#define SENSOR_TABLE_H",
+        "",
+        "// Generated by tools/sensorgen.py from tools/sensors.csv. Edit the CSV and rerun the script,",
+        "// so the QLC+ workspace keeps listening for the same CCs.",
+        "",
+        "#include \"SensorBank.h\"",
+        "",
+        "// One row per sensor: {inPin, outPin, midiChannelAnalog, midiChannelDigital, note, velocity,",
+        "// durationMs, debounceMs}. The bank sizes itself from this table (up to SensorBank::MAX_SENSORS).",
+        "// Note, velocity, channels and timings can be changed at runtime over SysEx (see SensorBank.h),",
+        "// but QLC+ only follows the CCs of the channels listed here.",
+        "const SensorSettings sensorTable[] = {",
+    ]
+    for sensor, values in zip(sensors, columns):
+        cells = ", ".join(v.rjust(w) if i else v for i, (v, w) in enumerate(zip(values, widths)))
+        lines.append("  {%s},  // %s: CC %d on / %d off" % (cells, sensor["name"], cc_on(sensor), cc_off(sensor)))
+    lines += ["};", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def input_profile(sensors):
+    """A QLC+ input profile naming each sensor's CC pair."""
+    lines = [
+        '<?xml version="1.0" encoding="UTF-8"?>',
+        "<!DOCTYPE InputProfile>",
+        '<InputProfile xmlns="http://www.qlcplus.org/InputProfile">',
+        " <Creator>",
+        "  <Name>Q Light Controller Plus</Name>",
+        "  <Version>5.2.0</Version>",
+        "  <Author>tools/sensorgen.py</Author>",
+        " </Creator>",
+        " <Manufacturer>%s</Manufacturer>" % PROFILE_MANUFACTURER,
+        " <Model>%s</Model>" % PROFILE_MODEL,
+        " <Type>MIDI</Type>",
+    ]
+    channels = []
+    for sensor in sensors:
+        channels.append((cc_on(sensor), "%s digital" % sensor["name"]))
+        channels.append((cc_off(sensor), "%s analog" % sensor["name"]))
+    for number, name in sorted(channels):
+        lines += [
+            ' <Channel Number="%d">' % number,
+            "  <Name>%s</Name>" % xml_escape(name),
+            "  <Type>Button</Type>",
+            " </Channel>",
+        ]
+    lines += ["</InputProfile>", ""]
+    return "\n".join(lines)
+
+
+def xml_escape(text):
+    return text.replace("&", "&amp;").replace("<", "&lt;").replace(">", "&gt;").replace('"', "&quot;")
+
+
+def bind_workspace(text, sensors):
+    """Returns the workspace with every sensor's buttons bound to its CCs, and warnings.
+
+    Edits only the Input lines it owns, so the rest of the file stays as
+    QLC+ wrote it. Workspace input channels are CC numbers (MIDI plugin on
+    channel 16, not omni).
+    """
+    warnings = []
+    profile = "%s %s" % (PROFILE_MANUFACTURER, PROFILE_MODEL)
+    text, found = re.subn(r'(<Input Plugin="MIDI"[^>]*?)(?: Profile="[^"]*")?/>',
+                          lambda m: '%s Profile="%s"/>' % (m.group(1), profile), text, count=1)
+    if not found:
+        warnings.append("no MIDI input universe; patch one to the Teensy in QLC+ and rerun")
+    for sensor in sensors:
+        frame = re.search(r'<SoloFrame Caption="%s" .*?</SoloFrame>' % re.escape(xml_escape(sensor["name"])),
+                          text, re.S)
+        if frame is None:
+            warnings.append('no solo frame "%s" in the virtual console; bind CC %d/%d by hand'
+                            % (sensor["name"], cc_on(sensor), cc_off(sensor)))
+            continue
+        body = frame.group(0)
+        for caption, cc in (("Digital", cc_on(sensor)), ("Analog", cc_off(sensor))):
+            button = re.compile(r'(<Button Caption="%s" (?:(?!</Button>).)*?<Input ID="0" Universe="\d+" Channel=")(\d+)("/>)'
+                                % caption, re.S)
+            body, bound = button.subn(lambda m: "%s%d%s" % (m.group(1), cc, m.group(3)), body, count=1)
+            if not bound:
+                warnings.append('"%s" has no %s button with an input; bind CC %d by hand'
+                                % (sensor["name"], caption, cc))
+        text = text[:frame.start()] + body + text[frame.end():]
+    return text, warnings
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--check", action="store_true", help="only report files that are out of date")
+    args = parser.parse_args()
+
+    try:
+        sensors = load_sensors()
+    except (OSError, ValueError) as error:
+        sys.exit("sensorgen: %s" % error)
+    with open(WORKSPACE, newline="") as f:
+        workspace, warnings = bind_workspace(f.read(), sensors)
+    outputs = [
+        (SENSOR_TABLE, sensor_table(sensors)),
+        (PROFILE, input_profile(sensors)),
+        (WORKSPACE, workspace),
+    ]
+    for warning in warnings:
+        print("warning: %s" % warning, file=sys.stderr)
+
+    stale = []
+    for path, content in outputs:
+        try:
+            with open(path, newline="") as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = None
+        if current == content:
+            continue
+        stale.append(os.path.relpath(path, ROOT))
+        if not args.check:
+            with open(path, "w", newline="") as f:
+                f.write(content)
+    verb = "out of date" if args.check else "updated"
+    for path in stale:
+        print("%s: %s" % (verb, path))
+    if not stale:
+        print("%d sensors, everything up to date" % len(sensors))
+    return 1 if args.check and stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())